@@ -0,0 +1,102 @@
+#include <stdlib.h>
+#include <string.h>
+#include "allocator.h"
+
+/** Header in front of every block of an allocator, the union keeps the
+ *  block after it aligned for any type */
+typedef union BlockHeader_t{
+    struct{
+        size_t size;
+        AllocatorCategory category;
+    }info;
+    long double alignLongDouble;
+    long long alignLongLong;
+    void* alignPointer;
+}BlockHeader;
+
+struct Allocator_t{
+    AllocatorHooks hooks;
+    size_t limit;
+    size_t bytes[ALLOCATOR_NUM_OF_CATEGORIES];
+    size_t total;
+    size_t peak;
+};
+
+/** default allocate hook, calls malloc */
+void* allocatorMalloc(size_t size, void* context);
+
+/** default deallocate hook, calls free */
+void allocatorDefaultFree(void* block, void* context);
+
+void* allocatorMalloc(size_t size, void* context){
+    return malloc(size);
+}
+
+void allocatorDefaultFree(void* block, void* context){
+    free(block);
+}
+
+Allocator allocatorCreate(const AllocatorHooks* hooks, size_t limit){
+    AllocatorHooks defaultHooks = {allocatorMalloc, allocatorDefaultFree,
+                                   NULL};
+    if(!hooks){
+        hooks = &defaultHooks;
+    }
+    if(!hooks->allocate||!hooks->deallocate) return NULL;
+    Allocator allocator = hooks->allocate(sizeof(*allocator), hooks->context);
+    if(!allocator) return NULL;
+    allocator->hooks = *hooks;
+    allocator->limit = limit;
+    memset(allocator->bytes, 0, sizeof(allocator->bytes));
+    allocator->total = 0;
+    allocator->peak = 0;
+    return allocator;
+}
+
+void allocatorDestroy(Allocator allocator){
+    if(!allocator) return;
+    allocator->hooks.deallocate(allocator, allocator->hooks.context);
+}
+
+void* allocatorAllocate(Allocator allocator, AllocatorCategory category,
+                        size_t size){
+    if(!allocator) return malloc(size);
+    if(category<0||category>=ALLOCATOR_NUM_OF_CATEGORIES){
+        category = ALLOCATOR_OTHER;
+    }
+    if(allocator->limit>0 && allocator->total+size > allocator->limit){
+        return NULL;
+    }
+    BlockHeader* header = allocator->hooks.allocate(sizeof(BlockHeader)+size,
+                                                    allocator->hooks.context);
+    if(!header) return NULL;
+    header->info.size = size;
+    header->info.category = category;
+    allocator->bytes[category] += size;
+    allocator->total += size;
+    if(allocator->total > allocator->peak){
+        allocator->peak = allocator->total;
+    }
+    return header+1;
+}
+
+void allocatorFree(Allocator allocator, void* block){
+    if(!block) return;
+    if(!allocator){
+        free(block);
+        return;
+    }
+    BlockHeader* header = (BlockHeader*)block-1;
+    allocator->bytes[header->info.category] -= header->info.size;
+    allocator->total -= header->info.size;
+    allocator->hooks.deallocate(header, allocator->hooks.context);
+}
+
+bool allocatorGetUsage(Allocator allocator, AllocatorUsage* usage){
+    if(!allocator||!usage) return false;
+    memcpy(usage->bytes, allocator->bytes, sizeof(usage->bytes));
+    usage->total = allocator->total;
+    usage->peak = allocator->peak;
+    usage->limit = allocator->limit;
+    return true;
+}
@@ -0,0 +1,121 @@
+#ifndef MTM_HW1_EUROVISION_ALLOCATOR_H
+#define MTM_HW1_EUROVISION_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Accounting Allocator
+ *
+ * Allocates memory through pluggable hooks (malloc and free by default) and
+ * keeps the number of bytes in use by category, so the memory of one owner
+ * (a contest) can be reported and capped. Every block is allocated with a
+ * small header that remembers its size and category, so blocks are freed
+ * without passing them again.
+ *
+ * A NULL Allocator is valid in every function: the memory then comes
+ * straight from malloc and free and nothing is counted.
+ *
+ * The following functions are available:
+ *
+ * allocatorCreate   - Allocate a new allocator with hooks and a limit.
+ * allocatorDestroy  - Deallocate an allocator.
+ * allocatorAllocate - Allocate a block of a category.
+ * allocatorFree     - Deallocate a block.
+ * allocatorGetUsage - Return the bytes in use by category.
+*/
+
+/** The categories the allocated bytes are counted by */
+typedef enum AllocatorCategory_t{
+    ALLOCATOR_MAP_NODES,
+    ALLOCATOR_KEYS,
+    ALLOCATOR_STATES,
+    ALLOCATOR_JUDGES,
+    ALLOCATOR_STRINGS,
+    ALLOCATOR_VOTE_COUNTERS,
+    ALLOCATOR_RESULTS,
+    ALLOCATOR_OTHER,
+    ALLOCATOR_NUM_OF_CATEGORIES
+}AllocatorCategory;
+
+/** Type of function for allocating memory, context is the hooks context */
+typedef void*(*allocateFunction)(size_t size, void* context);
+
+/** Type of function for deallocating memory returned by allocateFunction */
+typedef void(*deallocateFunction)(void* block, void* context);
+
+/** The memory functions an allocator uses */
+typedef struct AllocatorHooks_t{
+    allocateFunction allocate;
+    deallocateFunction deallocate;
+    void* context;
+}AllocatorHooks;
+
+/** The bytes in use of an allocator, headers are not counted. limit is 0
+ *  when the allocator has no limit */
+typedef struct AllocatorUsage_t{
+    size_t bytes[ALLOCATOR_NUM_OF_CATEGORIES];
+    size_t total;
+    size_t peak;
+    size_t limit;
+}AllocatorUsage;
+
+/** Type for defining an Allocator */
+typedef struct Allocator_t *Allocator;
+
+/**
+* allocatorCreate: Allocates a new allocator
+*
+* @param hooks - the memory functions to use, copied into the allocator.
+*                NULL to use malloc and free.
+* @param limit - the maximal number of bytes in use, an allocation that
+*                would go over it fails. 0 for no limit.
+* @return
+* 	NULL - if hooks has a NULL function or allocations failed.
+* 	A new Allocator in case of success.
+*/
+Allocator allocatorCreate(const AllocatorHooks* hooks, size_t limit);
+
+/**
+* allocatorDestroy: Deallocate an allocator. The blocks still in use are not
+* freed.
+*
+* @param allocator - the allocator to deallocate, if NULL nothing will be done
+*/
+void allocatorDestroy(Allocator allocator);
+
+/**
+* allocatorAllocate: Allocate a block and count it in a category
+*
+* @param allocator - the allocator, NULL to use malloc
+* @param category - the category to count the block in
+* @param size - the size of the block
+* @return
+* 	NULL - if the allocation failed or would go over the limit
+* 	the new block otherwise
+*/
+void* allocatorAllocate(Allocator allocator, AllocatorCategory category,
+                        size_t size);
+
+/**
+* allocatorFree: Deallocate a block returned by allocatorAllocate of the
+* same allocator
+*
+* @param allocator - the allocator, NULL to use free
+* @param block - the block to deallocate, if NULL nothing will be done
+*/
+void allocatorFree(Allocator allocator, void* block);
+
+/**
+* allocatorGetUsage: Get the bytes in use of an allocator
+*
+* @param allocator - the allocator
+* @param usage - set to the bytes in use by category, their total, the
+*                highest total so far and the limit
+* @return
+* 	false - if one of the parameters is NULL
+* 	true - otherwise
+*/
+bool allocatorGetUsage(Allocator allocator, AllocatorUsage* usage);
+
+#endif
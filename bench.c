@@ -0,0 +1,735 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "eurovision.h"
+#include "generator.h"
+#include "map.h"
+#include "contestset.h"
+#include "protocol.h"
+#include "pipeline.h"
+#include "score.h"
+#include "threadpool.h"
+
+#define DEFAULT_STATES 200
+#define DEFAULT_JUDGES 20
+#define DEFAULT_VOTES 200000
+#define DEFAULT_SKEW 1.0
+#define DEFAULT_SEED 1
+#define DEFAULT_MAP_SIZE 5000
+#define DEFAULT_REPEAT 10
+#define REMOVED_STATES_PERCENT 10
+#define REGION_STATES_PERCENT 10
+#define NANO_IN_SECOND 1e9
+#define NUM_OF_SET_CONTESTS 3
+#define NUM_OF_MAP_READERS 4
+#define PIPELINE_PARSERS 2
+#define PIPELINE_AGGREGATORS 2
+#define PIPELINE_QUEUE_CAPACITY 64
+#define PIPELINE_REFRESH_MILLISECONDS 100
+#define PIPELINE_CHUNK_SIZE 16384
+#define RANK_SIZE 1000000
+#define RANK_DISTINCT_SCORES 1000
+#define SIMULATION_TRIALS 1000
+#define MAX_CASES 32
+
+/** Options of one benchmark run */
+typedef struct BenchOptions_t{
+    GeneratorConfig config;
+    int mapSize;
+    int repeat;
+    bool json;
+    const char *group;
+}BenchOptions;
+
+/** Result of one benchmark */
+typedef struct BenchCase_t{
+    const char *name;
+    long ops;
+    double seconds;
+    long peakRssKb;
+}BenchCase;
+
+/** A group of benchmarks, run fills results (room for MAX_CASES) and
+ *  returns their number */
+typedef struct BenchGroup_t{
+    const char *name;
+    int (*run)(BenchOptions options, BenchCase *results);
+}BenchGroup;
+
+/** return the current monotonic time in seconds */
+double benchNow();
+
+/** return the peak resident set size of the process in KB, every group of
+ *  benchmarks runs in a process of its own so this is the peak of its group */
+long benchPeakRss();
+
+/** fill a benchmark result that started at start and ran ops operations */
+BenchCase benchFinish(const char *name, long ops, double start);
+
+/** print one benchmark result in the selected format */
+void benchPrint(BenchCase result, bool json, bool first);
+
+/** parse the command line into options, return false on bad arguments */
+bool benchParseOptions(int argc, char **argv, BenchOptions *options);
+
+/** run group in a child process and copy its results to results, which has
+ *  room for capacity results, return their number (0 if the child failed or
+ *  the results do not fit) */
+int benchRunGroup(BenchGroup group, BenchOptions options, BenchCase *results,
+                  int capacity);
+
+/** read size bytes of fd to data, return false if it ended before */
+bool benchReadAll(int fd, void *data, size_t size);
+
+/** create a eurovision filled by a new generator of config */
+Eurovision benchCreateEurovision(GeneratorConfig config);
+
+/** int copy, free and compare functions for the map benchmarks */
+MapDataElement benchCopyInt(MapDataElement n);
+void benchFreeInt(MapDataElement n);
+int benchCompareInts(MapKeyElement n1, MapKeyElement n2);
+
+/** One reader thread of the concurrent mapGet benchmark */
+typedef struct BenchMapReader_t{
+    Map map;
+    int *keys;
+    int size;
+    long found;
+}BenchMapReader;
+
+/** get every key of a BenchMapReader from its map */
+void* benchMapRead(void* reader);
+
+/** run mapGet on a concurrent map from NUM_OF_MAP_READERS threads, return
+ *  the number of keys found, -1 if the threads could not be started */
+long benchMapConcurrentGet(Map map, int *keys, int size);
+
+/** One thread ranking a snapshot while votes are added to its eurovision */
+typedef struct BenchSnapshotReader_t{
+    Eurovision snapshot;
+    int repeat;
+}BenchSnapshotReader;
+
+/** run eurovisionRunContest repeat times on the snapshot of a
+ *  BenchSnapshotReader */
+void* benchSnapshotRun(void* reader);
+
+/** add votes to a eurovision while a thread ranks a snapshot of it */
+int benchSnapshotIngest(BenchOptions options, BenchCase *results);
+
+/** run the mapPut, mapGet and mapRemove benchmarks */
+int benchMap(BenchOptions options, BenchCase *results);
+
+/** run the eurovision benchmarks */
+int benchEurovision(BenchOptions options, BenchCase *results);
+
+/** submit the votes as PROTOCOL_ADD_VOTE messages to a vote pipeline, and
+ *  report the busy time of each stage */
+int benchPipeline(BenchOptions options, BenchCase *results);
+
+/** rank RANK_SIZE states (with many equal scores) with scoreRank and with
+ *  scoreRankParallel on a pool of one thread per processor */
+int benchScoreRank(BenchOptions options, BenchCase *results);
+
+/** run SIMULATION_TRIALS trials of the contest with Poisson noise on the
+ *  citizen votes */
+int benchSimulate(BenchOptions options, BenchCase *results);
+
+/** export the vote graph and find the voting blocs of the contest */
+int benchVotingBlocs(BenchOptions options, BenchCase *results);
+
+/** run the contest set benchmark, NUM_OF_SET_CONTESTS contests on as many
+ *  threads */
+int benchContestSet(BenchOptions options, BenchCase *results);
+
+double benchNow(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec+now.tv_nsec/NANO_IN_SECOND;
+}
+
+long benchPeakRss(){
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage)!=0) return -1;
+    return usage.ru_maxrss;
+}
+
+BenchCase benchFinish(const char *name, long ops, double start){
+    BenchCase result;
+    result.name = name;
+    result.ops = ops;
+    result.seconds = benchNow()-start;
+    result.peakRssKb = benchPeakRss();
+    return result;
+}
+
+void benchPrint(BenchCase result, bool json, bool first){
+    double nsPerOp = result.ops>0 ?
+            result.seconds*NANO_IN_SECOND/result.ops : 0;
+    double opsPerSec = result.seconds>0 ? result.ops/result.seconds : 0;
+    if(json){
+        printf("%s\n  {\"benchmark\": \"%s\", \"ops\": %ld, "
+               "\"ns_per_op\": %.1f, \"ops_per_sec\": %.1f, "
+               "\"peak_rss_kb\": %ld}", first ? "[" : ",", result.name,
+               result.ops, nsPerOp, opsPerSec, result.peakRssKb);
+        return;
+    }
+    if(first){
+        printf("benchmark,ops,ns_per_op,ops_per_sec,peak_rss_kb\n");
+    }
+    printf("%s,%ld,%.1f,%.1f,%ld\n", result.name, result.ops, nsPerOp,
+           opsPerSec, result.peakRssKb);
+}
+
+bool benchParseOptions(int argc, char **argv, BenchOptions *options){
+    options->config.numOfStates = DEFAULT_STATES;
+    options->config.numOfJudges = DEFAULT_JUDGES;
+    options->config.numOfVotes = DEFAULT_VOTES;
+    options->config.voteSkew = DEFAULT_SKEW;
+    options->config.seed = DEFAULT_SEED;
+    options->mapSize = DEFAULT_MAP_SIZE;
+    options->repeat = DEFAULT_REPEAT;
+    options->json = false;
+    options->group = NULL;
+    for(int i=1; i<argc; i++){
+        if(i+1>=argc) return false;
+        char *option = argv[i];
+        char *value = argv[++i];
+        if(strcmp(option, "--states")==0){
+            options->config.numOfStates = atoi(value);
+        }
+        else if(strcmp(option, "--judges")==0){
+            options->config.numOfJudges = atoi(value);
+        }
+        else if(strcmp(option, "--votes")==0){
+            options->config.numOfVotes = atoi(value);
+        }
+        else if(strcmp(option, "--skew")==0){
+            options->config.voteSkew = atof(value);
+        }
+        else if(strcmp(option, "--seed")==0){
+            options->config.seed = strtoull(value, NULL, 10);
+        }
+        else if(strcmp(option, "--map-size")==0){
+            options->mapSize = atoi(value);
+        }
+        else if(strcmp(option, "--repeat")==0){
+            options->repeat = atoi(value);
+        }
+        else if(strcmp(option, "--format")==0){
+            if(strcmp(value, "json")!=0 && strcmp(value, "csv")!=0){
+                return false;
+            }
+            options->json = strcmp(value, "json")==0;
+        }
+        else if(strcmp(option, "--case")==0){
+            options->group = value;
+        }
+        else{
+            return false;
+        }
+    }
+    return options->mapSize>0 && options->repeat>0;
+}
+
+int benchRunGroup(BenchGroup group, BenchOptions options, BenchCase *results,
+                  int capacity){
+    int fds[2];
+    if(pipe(fds)!=0) return 0;
+    pid_t child = fork();
+    if(child<0){
+        close(fds[0]);
+        close(fds[1]);
+        return 0;
+    }
+    if(child==0){
+        /* the names of the results are literals, valid in the parent too */
+        close(fds[0]);
+        BenchCase cases[MAX_CASES];
+        int count = group.run(options, cases);
+        if(count<0||count>capacity){
+            fprintf(stderr, "%s: %d results do not fit in %d\n", group.name,
+                    count, capacity);
+            _exit(1);
+        }
+        bool written = write(fds[1], &count, sizeof(count))==sizeof(count) &&
+                       write(fds[1], cases, sizeof(*cases)*count)==
+                       (ssize_t)(sizeof(*cases)*count);
+        _exit(written ? 0 : 1);
+    }
+    close(fds[1]);
+    int count = 0;
+    bool received = benchReadAll(fds[0], &count, sizeof(count)) &&
+                    count>=0 && count<=capacity &&
+                    benchReadAll(fds[0], results, sizeof(*results)*count);
+    close(fds[0]);
+    int status;
+    bool exited = waitpid(child, &status, 0)==child && WIFEXITED(status) &&
+                  WEXITSTATUS(status)==0;
+    return received && exited ? count : 0;
+}
+
+bool benchReadAll(int fd, void *data, size_t size){
+    size_t done = 0;
+    while(done<size){
+        ssize_t bytes = read(fd, (char*)data+done, size-done);
+        if(bytes<=0) return false;
+        done += bytes;
+    }
+    return true;
+}
+
+Eurovision benchCreateEurovision(GeneratorConfig config){
+    Generator generator = generatorCreate(config);
+    Eurovision eurovision = eurovisionCreate();
+    if(!generator||!eurovision){
+        generatorDestroy(generator);
+        eurovisionDestroy(eurovision);
+        return NULL;
+    }
+    EurovisionResult result = generatorFillEurovision(generator, eurovision);
+    if(result!=EUROVISION_SUCCESS){
+        generatorDestroy(generator);
+        if(result!=EUROVISION_OUT_OF_MEMORY){
+            eurovisionDestroy(eurovision);
+        }
+        return NULL;
+    }
+    generatorDestroy(generator);
+    return eurovision;
+}
+
+MapDataElement benchCopyInt(MapDataElement n){
+    int *copy = malloc(sizeof(*copy));
+    if(!copy) return NULL;
+    *copy = *(int*)n;
+    return copy;
+}
+
+void benchFreeInt(MapDataElement n){
+    free(n);
+}
+
+int benchCompareInts(MapKeyElement n1, MapKeyElement n2){
+    return *(int*)n1-*(int*)n2;
+}
+
+void* benchMapRead(void* reader){
+    BenchMapReader* mapReader = reader;
+    for(int i=0; i<mapReader->size; i++){
+        mapReader->found += mapGet(mapReader->map,
+                                   &mapReader->keys[i]) != NULL;
+    }
+    return NULL;
+}
+
+long benchMapConcurrentGet(Map map, int *keys, int size){
+    pthread_t threads[NUM_OF_MAP_READERS];
+    BenchMapReader readers[NUM_OF_MAP_READERS];
+    int started = 0;
+    for(; started<NUM_OF_MAP_READERS; started++){
+        readers[started] = (BenchMapReader){map, keys, size, 0};
+        if(pthread_create(&threads[started], NULL, benchMapRead,
+                          &readers[started]) != 0){
+            break;
+        }
+    }
+    long found = 0;
+    for(int i=0; i<started; i++){
+        pthread_join(threads[i], NULL);
+        found += readers[i].found;
+    }
+    return started==NUM_OF_MAP_READERS ? found : -1;
+}
+
+int benchMap(BenchOptions options, BenchCase *results){
+    int size = options.mapSize;
+    int *keys = malloc(sizeof(int)*size);
+    Generator generator = generatorCreate(options.config);
+    Map map = mapCreate(benchCopyInt, benchCopyInt, benchFreeInt,
+                        benchFreeInt, benchCompareInts);
+    if(!keys||!generator||!map){
+        free(keys);
+        generatorDestroy(generator);
+        mapDestroy(map);
+        return 0;
+    }
+    for(int i=0; i<size; i++){
+        keys[i] = i;
+    }
+    for(int i=size-1; i>0; i--){
+        int j = (int)(generatorRandom(generator)%(i+1));
+        int tmp = keys[i];
+        keys[i] = keys[j];
+        keys[j] = tmp;
+    }
+    double start = benchNow();
+    for(int i=0; i<size; i++){
+        mapPut(map, &keys[i], &i);
+    }
+    results[0] = benchFinish("map_put", size, start);
+    long found = 0;
+    start = benchNow();
+    for(int i=0; i<size; i++){
+        found += mapGet(map, &keys[i]) != NULL;
+    }
+    results[1] = benchFinish("map_get", found, start);
+    int count = 2;
+    if(mapSetConcurrent(map, true) == MAP_SUCCESS){
+        start = benchNow();
+        found = benchMapConcurrentGet(map, keys, size);
+        if(found >= 0){
+            results[count++] = benchFinish("map_get_concurrent", found,
+                                           start);
+        }
+        mapSetConcurrent(map, false);
+    }
+    start = benchNow();
+    for(int i=0; i<size; i++){
+        mapRemove(map, &keys[i]);
+    }
+    results[count++] = benchFinish("map_remove", size, start);
+    mapDestroy(map);
+    generatorDestroy(generator);
+    free(keys);
+    return count;
+}
+
+void* benchSnapshotRun(void* reader){
+    BenchSnapshotReader* snapshotReader = reader;
+    for(int i=0; i<snapshotReader->repeat; i++){
+        listDestroy(eurovisionRunContest(snapshotReader->snapshot, 50));
+    }
+    return NULL;
+}
+
+int benchSnapshotIngest(BenchOptions options, BenchCase *results){
+    GeneratorConfig config = options.config;
+    Eurovision eurovision = benchCreateEurovision(config);
+    BenchSnapshotReader reader = {eurovisionSnapshot(eurovision),
+                                  options.repeat};
+    config.seed++;
+    Generator generator = generatorCreate(config);
+    pthread_t thread;
+    if(!reader.snapshot||!generator||
+       pthread_create(&thread, NULL, benchSnapshotRun, &reader)!=0){
+        eurovisionDestroy(reader.snapshot);
+        eurovisionDestroy(eurovision);
+        generatorDestroy(generator);
+        return 0;
+    }
+    double start = benchNow();
+    for(int i=0; i<config.numOfVotes; i++){
+        int giver, taker;
+        generatorNextVote(generator, &giver, &taker);
+        eurovisionAddVote(eurovision, giver, taker);
+    }
+    results[0] = benchFinish("eurovision_add_vote_during_contest",
+                             config.numOfVotes, start);
+    pthread_join(thread, NULL);
+    eurovisionDestroy(reader.snapshot);
+    eurovisionDestroy(eurovision);
+    generatorDestroy(generator);
+    return 1;
+}
+
+int benchEurovision(BenchOptions options, BenchCase *results){
+    GeneratorConfig config = options.config;
+    int count = 0;
+    GeneratorConfig noVotes = config;
+    noVotes.numOfVotes = 0;
+    Eurovision eurovision = benchCreateEurovision(noVotes);
+    Generator generator = generatorCreate(config);
+    if(!eurovision||!generator){
+        eurovisionDestroy(eurovision);
+        generatorDestroy(generator);
+        return 0;
+    }
+    double start = benchNow();
+    for(int i=0; i<config.numOfVotes; i++){
+        int giver, taker;
+        generatorNextVote(generator, &giver, &taker);
+        eurovisionAddVote(eurovision, giver, taker);
+    }
+    results[count++] = benchFinish("eurovision_add_vote",
+                                   config.numOfVotes, start);
+    generatorDestroy(generator);
+
+    start = benchNow();
+    for(int i=0; i<options.repeat; i++){
+        listDestroy(eurovisionRunContest(eurovision, 50));
+    }
+    results[count++] = benchFinish("eurovision_run_contest",
+                                   options.repeat, start);
+    int regionSize = config.numOfStates*REGION_STATES_PERCENT/100;
+    start = benchNow();
+    for(int i=0; i<options.repeat; i++){
+        listDestroy(eurovisionRunContestRange(eurovision, 50, 0,
+                                              regionSize));
+    }
+    results[count++] = benchFinish("eurovision_run_contest_range",
+                                   options.repeat, start);
+    start = benchNow();
+    for(int i=0; i<options.repeat; i++){
+        listDestroy(eurovisionRunAudienceFavorite(eurovision));
+    }
+    results[count++] = benchFinish("eurovision_run_audience_favorite",
+                                   options.repeat, start);
+    start = benchNow();
+    for(int i=0; i<options.repeat; i++){
+        listDestroy(eurovisionRunGetFriendlyStates(eurovision));
+    }
+    results[count++] = benchFinish("eurovision_run_friendly_states",
+                                   options.repeat, start);
+    start = benchNow();
+    for(int i=0; i<options.repeat; i++){
+        eurovisionDestroy(eurovisionSnapshot(eurovision));
+    }
+    results[count++] = benchFinish("eurovision_snapshot", options.repeat,
+                                   start);
+
+    int toRemove = config.numOfStates*REMOVED_STATES_PERCENT/100;
+    if(toRemove<1) toRemove = 1;
+    start = benchNow();
+    for(int i=0; i<toRemove; i++){
+        eurovisionRemoveState(eurovision, i*(100/REMOVED_STATES_PERCENT));
+    }
+    results[count++] = benchFinish("eurovision_remove_state", toRemove,
+                                   start);
+    eurovisionDestroy(eurovision);
+
+    eurovision = benchCreateEurovision(config);
+    int *removedIds = malloc(sizeof(int)*toRemove);
+    if(eurovision && removedIds){
+        for(int i=0; i<toRemove; i++){
+            removedIds[i] = i*(100/REMOVED_STATES_PERCENT);
+        }
+        start = benchNow();
+        eurovisionRemoveStates(eurovision, removedIds, toRemove);
+        results[count++] = benchFinish("eurovision_remove_states", toRemove,
+                                       start);
+    }
+    free(removedIds);
+    eurovisionDestroy(eurovision);
+
+    eurovision = benchCreateEurovision(config);
+    if(eurovision){
+        eurovisionSetLazyRemoval(eurovision, true, 0);
+        start = benchNow();
+        for(int i=0; i<toRemove; i++){
+            eurovisionRemoveState(eurovision, i*(100/REMOVED_STATES_PERCENT));
+        }
+        results[count++] = benchFinish("eurovision_remove_state_lazy",
+                                       toRemove, start);
+        start = benchNow();
+        eurovisionCompact(eurovision);
+        results[count++] = benchFinish("eurovision_compact", 1, start);
+    }
+    eurovisionDestroy(eurovision);
+    return count;
+}
+
+int benchPipeline(BenchOptions options, BenchCase *results){
+    GeneratorConfig config = options.config;
+    GeneratorConfig noVotes = config;
+    noVotes.numOfVotes = 0;
+    Eurovision eurovision = benchCreateEurovision(noVotes);
+    Generator generator = generatorCreate(config);
+    ProtocolBuffer messages = protocolBufferCreate();
+    bool encoded = eurovision && generator && messages;
+    for(int i=0; encoded && i<config.numOfVotes; i++){
+        int giver, taker;
+        generatorNextVote(generator, &giver, &taker);
+        int32_t vote[] = {giver, taker};
+        encoded = protocolAppendMessage(messages, PROTOCOL_ADD_VOTE, vote,
+                                        2)==PROTOCOL_SUCCESS;
+    }
+    generatorDestroy(generator);
+    VotePipelineConfig pipelineConfig = {PIPELINE_PARSERS,
+                                         PIPELINE_AGGREGATORS,
+                                         PIPELINE_QUEUE_CAPACITY,
+                                         PIPELINE_REFRESH_MILLISECONDS};
+    VotePipeline pipeline = encoded ?
+            votePipelineCreate(eurovision, pipelineConfig) : NULL;
+    if(!pipeline){
+        eurovisionDestroy(eurovision);
+        protocolBufferDestroy(messages);
+        return 0;
+    }
+    const char *data = protocolBufferGetData(messages);
+    uint32_t size = protocolBufferGetSize(messages);
+    uint32_t messageSize = sizeof(ProtocolHeader)+2*sizeof(int32_t);
+    uint32_t chunkSize = PIPELINE_CHUNK_SIZE/messageSize*messageSize;
+    double start = benchNow();
+    for(uint32_t offset=0; offset<size; offset+=chunkSize){
+        votePipelineSubmit(pipeline, data+offset, size-offset < chunkSize ?
+                                                  size-offset : chunkSize);
+    }
+    votePipelineFlush(pipeline);
+    results[0] = benchFinish("vote_pipeline", config.numOfVotes, start);
+    VotePipelineStats stats;
+    votePipelineGetStats(pipeline, &stats);
+    const char *names[] = {"vote_pipeline_parse", "vote_pipeline_aggregate",
+                           "vote_pipeline_score"};
+    for(int i=0; i<VOTE_PIPELINE_NUM_OF_STAGES; i++){
+        results[1+i] = (BenchCase){names[i], stats.stages[i].items,
+                                   stats.stages[i].busySeconds,
+                                   benchPeakRss()};
+    }
+    votePipelineDestroy(pipeline);
+    eurovisionDestroy(eurovision);
+    protocolBufferDestroy(messages);
+    return 1+VOTE_PIPELINE_NUM_OF_STAGES;
+}
+
+int benchScoreRank(BenchOptions options, BenchCase *results){
+    double *total = malloc(sizeof(double)*RANK_SIZE);
+    int *ids = malloc(sizeof(int)*RANK_SIZE);
+    int *order = malloc(sizeof(int)*RANK_SIZE);
+    if(!total||!ids||!order){
+        free(total);
+        free(ids);
+        free(order);
+        return 0;
+    }
+    srand((unsigned)options.config.seed);
+    for(int i=0; i<RANK_SIZE; i++){
+        total[i] = (double)(rand()%RANK_DISTINCT_SCORES)/RANK_DISTINCT_SCORES;
+        ids[i] = i;
+    }
+    double start = benchNow();
+    for(int i=0; i<options.repeat; i++){
+        scoreRank(total, ids, order, RANK_SIZE);
+    }
+    results[0] = benchFinish("score_rank", (long)RANK_SIZE*options.repeat,
+                             start);
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    ThreadPool pool = threadPoolCreate(processors>1 ? (int)processors : 1);
+    start = benchNow();
+    for(int i=0; i<options.repeat; i++){
+        scoreRankParallel(total, ids, order, RANK_SIZE, pool);
+    }
+    results[1] = benchFinish("score_rank_parallel",
+                             (long)RANK_SIZE*options.repeat, start);
+    threadPoolDestroy(pool);
+    free(total);
+    free(ids);
+    free(order);
+    return 2;
+}
+
+int benchSimulate(BenchOptions options, BenchCase *results){
+    Eurovision eurovision = benchCreateEurovision(options.config);
+    if(!eurovision) return 0;
+    SimulationNoise noise = {SIMULATION_NOISE_POISSON, 1};
+    SimulationOutcome outcome;
+    double start = benchNow();
+    EurovisionResult result = eurovisionSimulate(eurovision, 50,
+                                                 SIMULATION_TRIALS, noise,
+                                                 options.config.seed,
+                                                 &outcome);
+    if(result!=EUROVISION_SUCCESS){
+        if(result!=EUROVISION_OUT_OF_MEMORY){
+            eurovisionDestroy(eurovision);
+        }
+        return 0;
+    }
+    results[0] = benchFinish("eurovision_simulate", SIMULATION_TRIALS, start);
+    simulationOutcomeClear(&outcome);
+    eurovisionDestroy(eurovision);
+    return 1;
+}
+
+int benchVotingBlocs(BenchOptions options, BenchCase *results){
+    Eurovision eurovision = benchCreateEurovision(options.config);
+    if(!eurovision) return 0;
+    VoteGraph graph;
+    double start = benchNow();
+    for(int i=0; i<options.repeat; i++){
+        if(eurovisionGetVoteGraph(eurovision, &graph)!=EUROVISION_SUCCESS){
+            return 0;
+        }
+        voteGraphClear(&graph);
+    }
+    results[0] = benchFinish("eurovision_get_vote_graph", options.repeat,
+                             start);
+    start = benchNow();
+    for(int i=0; i<options.repeat; i++){
+        List blocs = eurovisionRunGetVotingBlocs(eurovision);
+        if(!blocs) return 1;
+        listDestroy(blocs);
+    }
+    results[1] = benchFinish("eurovision_run_get_voting_blocs",
+                             options.repeat, start);
+    eurovisionDestroy(eurovision);
+    return 2;
+}
+
+int benchContestSet(BenchOptions options, BenchCase *results){
+    ContestSet set = contestSetCreate(NUM_OF_SET_CONTESTS);
+    if(!set) return 0;
+    for(int i=0; i<NUM_OF_SET_CONTESTS; i++){
+        GeneratorConfig config = options.config;
+        config.seed += i;
+        Eurovision eurovision = benchCreateEurovision(config);
+        if(!eurovision||contestSetAdd(set, i, eurovision)!=CONTEST_SET_SUCCESS){
+            eurovisionDestroy(eurovision);
+            contestSetDestroy(set);
+            return 0;
+        }
+    }
+    double start = benchNow();
+    for(int i=0; i<options.repeat; i++){
+        contestSetRunContests(set, 50);
+    }
+    results[0] = benchFinish("contest_set_run_contests", options.repeat,
+                             start);
+    contestSetDestroy(set);
+    return 1;
+}
+
+int main(int argc, char **argv){
+    const BenchGroup groups[] = {
+            {"map", benchMap}, {"eurovision", benchEurovision},
+            {"snapshot", benchSnapshotIngest}, {"pipeline", benchPipeline},
+            {"score_rank", benchScoreRank}, {"simulate", benchSimulate},
+            {"voting_blocs", benchVotingBlocs},
+            {"contest_set", benchContestSet}};
+    int numOfGroups = sizeof(groups)/sizeof(groups[0]);
+    BenchOptions options;
+    bool parsed = benchParseOptions(argc, argv, &options);
+    bool known = !options.group;
+    for(int i=0; parsed && !known && i<numOfGroups; i++){
+        known = strcmp(options.group, groups[i].name)==0;
+    }
+    if(!parsed||!known){
+        fprintf(stderr, "usage: %s [--states N] [--judges N] [--votes N] "
+                        "[--skew X] [--seed N] [--map-size N] [--repeat N] "
+                        "[--format csv|json] [--case map|eurovision|snapshot|"
+                        "pipeline|score_rank|simulate|voting_blocs|"
+                        "contest_set]\n", argv[0]);
+        return 1;
+    }
+    BenchCase results[MAX_CASES];
+    int count = 0;
+    for(int i=0; i<numOfGroups; i++){
+        if(!options.group || strcmp(options.group, groups[i].name)==0){
+            count += benchRunGroup(groups[i], options, results+count,
+                                   MAX_CASES-count);
+        }
+    }
+    for(int i=0; i<count; i++){
+        benchPrint(results[i], options.json, i==0);
+    }
+    if(options.json){
+        printf("%s\n]\n", count>0 ? "" : "[");
+    }
+    return count>0 ? 0 : 1;
+}
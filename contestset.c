@@ -0,0 +1,246 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <limits.h>
+#include "contestset.h"
+#include "threadpool.h"
+
+#define INITIAL_CAPACITY 4
+
+/** One contest of the set and the result of its last run */
+typedef struct ContestEntry_t{
+    int id;
+    Eurovision eurovision;
+    RankingResult ranking;
+    int audiencePercent;
+    EurovisionResult runResult;
+    bool ranked;
+}ContestEntry;
+
+/** pool runs the contests, rankPool sorts the large rankings of all of them
+ *  (NULL on a single processor) */
+struct ContestSet_t{
+    ThreadPool pool;
+    ThreadPool rankPool;
+    ContestEntry* entries;
+    int numOfEntries;
+    int capacity;
+};
+
+/** return the index of contestId in the set, -1 if it is not there */
+int contestSetFind(ContestSet set, int contestId);
+
+/** remove the entry at index from the set, its eurovision must already be
+ *  destroyed */
+void contestSetRemoveAt(ContestSet set, int index);
+
+/** the task the thread pool runs for every contest */
+void contestSetRunTask(void* entry);
+
+/** Changing an EurovisionResult of a promotion to ContestSetResult */
+ContestSetResult contestSetErrorTranslate(EurovisionResult result);
+
+int contestSetFind(ContestSet set, int contestId){
+    for(int i=0; i<set->numOfEntries; i++){
+        if(set->entries[i].id == contestId) return i;
+    }
+    return -1;
+}
+
+void contestSetRemoveAt(ContestSet set, int index){
+    rankingDestroy(set->entries[index].ranking);
+    for(int i=index+1; i<set->numOfEntries; i++){
+        set->entries[i-1] = set->entries[i];
+    }
+    set->numOfEntries--;
+}
+
+void contestSetRunTask(void* entry){
+    ContestEntry* contest = entry;
+    contest->runResult = eurovisionRunContestInto(contest->eurovision,
+                                                  contest->audiencePercent,
+                                                  contest->ranking);
+}
+
+ContestSetResult contestSetErrorTranslate(EurovisionResult result){
+    switch(result){
+        case EUROVISION_SUCCESS:
+            return CONTEST_SET_SUCCESS;
+        case EUROVISION_NULL_ARGUMENT:
+            return CONTEST_SET_NULL_ARGUMENT;
+        case EUROVISION_OUT_OF_MEMORY:
+            return CONTEST_SET_OUT_OF_MEMORY;
+        case EUROVISION_INVALID_ID:
+            return CONTEST_SET_INVALID_ID;
+        case EUROVISION_INVALID_NAME:
+            return CONTEST_SET_INVALID_NAME;
+        case EUROVISION_INVALID_PERCENT:
+            return CONTEST_SET_INVALID_PERCENT;
+        case EUROVISION_STATE_ALREADY_EXIST:
+            return CONTEST_SET_STATE_ALREADY_EXIST;
+        case EUROVISION_STATE_NOT_EXIST:
+            return CONTEST_SET_STATE_NOT_EXIST;
+        case EUROVISION_READ_ONLY:
+            return CONTEST_SET_READ_ONLY;
+        /* the set never adds or removes judges or votes */
+        case EUROVISION_JUDGE_ALREADY_EXIST:
+        case EUROVISION_JUDGE_NOT_EXIST:
+        case EUROVISION_SAME_STATE:
+        case EUROVISION_INVALID_ARGUMENT:
+            return CONTEST_SET_INVALID_ARGUMENT;
+    }
+    return CONTEST_SET_INVALID_ARGUMENT;
+}
+
+ContestSet contestSetCreate(int numOfThreads){
+    if(numOfThreads<1) return NULL;
+    ContestSet set = malloc(sizeof(*set));
+    if(!set) return NULL;
+    set->numOfEntries = 0;
+    set->capacity = INITIAL_CAPACITY;
+    set->entries = malloc(sizeof(ContestEntry)*set->capacity);
+    set->pool = threadPoolCreate(numOfThreads);
+    /* one shared pool for the sorts, so concurrent contests do not start
+     * a pool each */
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    set->rankPool = processors>1 ? threadPoolCreate((int)processors) : NULL;
+    if(!set->entries||!set->pool||(processors>1 && !set->rankPool)){
+        contestSetDestroy(set);
+        return NULL;
+    }
+    return set;
+}
+
+void contestSetDestroy(ContestSet set){
+    if(!set) return;
+    threadPoolDestroy(set->pool);
+    for(int i=0; i<set->numOfEntries && set->entries; i++){
+        eurovisionDestroy(set->entries[i].eurovision);
+        rankingDestroy(set->entries[i].ranking);
+    }
+    threadPoolDestroy(set->rankPool);
+    free(set->entries);
+    free(set);
+}
+
+ContestSetResult contestSetAdd(ContestSet set, int contestId,
+                               Eurovision eurovision){
+    if(!set||!eurovision) return CONTEST_SET_NULL_ARGUMENT;
+    if(contestId<0) return CONTEST_SET_INVALID_ID;
+    if(contestSetFind(set, contestId) != -1){
+        return CONTEST_SET_CONTEST_ALREADY_EXIST;
+    }
+    if(set->numOfEntries == set->capacity){
+        ContestEntry* entries = realloc(set->entries, sizeof(ContestEntry)*
+                                                      set->capacity*2);
+        if(!entries) return CONTEST_SET_OUT_OF_MEMORY;
+        set->entries = entries;
+        set->capacity *= 2;
+    }
+    RankingResult ranking = rankingCreate();
+    if(!ranking) return CONTEST_SET_OUT_OF_MEMORY;
+    eurovisionSetRankPool(eurovision, set->rankPool);
+    ContestEntry* entry = set->entries+set->numOfEntries;
+    entry->id = contestId;
+    entry->eurovision = eurovision;
+    entry->ranking = ranking;
+    entry->audiencePercent = 0;
+    entry->runResult = EUROVISION_SUCCESS;
+    entry->ranked = false;
+    set->numOfEntries++;
+    return CONTEST_SET_SUCCESS;
+}
+
+Eurovision contestSetGet(ContestSet set, int contestId){
+    if(!set) return NULL;
+    int index = contestSetFind(set, contestId);
+    if(index == -1) return NULL;
+    return set->entries[index].eurovision;
+}
+
+ContestSetResult contestSetRunContests(ContestSet set, int audiencePercent){
+    if(!set) return CONTEST_SET_NULL_ARGUMENT;
+    if(audiencePercent<1||audiencePercent>100){
+        return CONTEST_SET_INVALID_PERCENT;
+    }
+    ContestSetResult result = CONTEST_SET_SUCCESS;
+    int submitted = 0;
+    for(; submitted<set->numOfEntries; submitted++){
+        ContestEntry* entry = set->entries+submitted;
+        entry->audiencePercent = audiencePercent;
+        entry->ranked = false;
+        if(threadPoolSubmit(set->pool, contestSetRunTask,
+                            entry) != THREAD_POOL_SUCCESS){
+            result = CONTEST_SET_OUT_OF_MEMORY;
+            break;
+        }
+    }
+    threadPoolWait(set->pool);
+    for(int i=submitted-1; i>=0; i--){
+        if(set->entries[i].runResult == EUROVISION_OUT_OF_MEMORY){
+            contestSetRemoveAt(set, i);
+            result = CONTEST_SET_OUT_OF_MEMORY;
+        }
+        else{
+            set->entries[i].ranked = true;
+        }
+    }
+    return result;
+}
+
+RankingResult contestSetGetRanking(ContestSet set, int contestId){
+    if(!set) return NULL;
+    int index = contestSetFind(set, contestId);
+    if(index == -1 || !set->entries[index].ranked) return NULL;
+    return set->entries[index].ranking;
+}
+
+ContestSetResult contestSetPromoteQualifiers(ContestSet set,
+                                             const int *fromIds,
+                                             int numOfContests, int finalId,
+                                             int numOfQualifiers){
+    if(!set||!fromIds) return CONTEST_SET_NULL_ARGUMENT;
+    if(numOfQualifiers<0) return CONTEST_SET_INVALID_ID;
+    if(contestSetFind(set, finalId) == -1){
+        return CONTEST_SET_CONTEST_NOT_EXIST;
+    }
+    long numOfPromoted = 0;
+    for(int i=0; i<numOfContests; i++){
+        if(fromIds[i] == finalId) return CONTEST_SET_INVALID_ID;
+        int index = contestSetFind(set, fromIds[i]);
+        if(index == -1) return CONTEST_SET_CONTEST_NOT_EXIST;
+        if(!set->entries[index].ranked) return CONTEST_SET_CONTEST_NOT_RUN;
+        int size = rankingGetSize(set->entries[index].ranking);
+        numOfPromoted += size < numOfQualifiers ? size : numOfQualifiers;
+    }
+    if(numOfPromoted > INT_MAX) return CONTEST_SET_OUT_OF_MEMORY;
+    /* the qualifiers of all the contests are promoted in one call, so they
+     * are all checked before any of them is added to the final */
+    int *qualifiers = malloc(sizeof(int)*(numOfPromoted+1));
+    Eurovision *sources = malloc(sizeof(Eurovision)*(numOfPromoted+1));
+    if(!qualifiers||!sources){
+        free(qualifiers);
+        free(sources);
+        return CONTEST_SET_OUT_OF_MEMORY;
+    }
+    numOfPromoted = 0;
+    for(int i=0; i<numOfContests; i++){
+        ContestEntry* from = set->entries+contestSetFind(set, fromIds[i]);
+        const RankingEntry* ranked = rankingGetEntries(from->ranking);
+        int size = rankingGetSize(from->ranking);
+        for(int j=0; j<size && j<numOfQualifiers; j++){
+            sources[numOfPromoted] = from->eurovision;
+            qualifiers[numOfPromoted++] = ranked[j].id;
+        }
+    }
+    ContestSetResult result = contestSetErrorTranslate(
+            eurovisionPromoteStatesFrom(sources, contestSetGet(set, finalId),
+                                        qualifiers, (int)numOfPromoted));
+    free(qualifiers);
+    free(sources);
+    if(result == CONTEST_SET_OUT_OF_MEMORY){
+        contestSetRemoveAt(set, contestSetFind(set, finalId));
+    }
+    return result;
+}
@@ -0,0 +1,167 @@
+#ifndef MTM_HW1_EUROVISION_CONTESTSET_H
+#define MTM_HW1_EUROVISION_CONTESTSET_H
+
+#include "eurovision.h"
+#include "ranking.h"
+
+/**
+ * Contest Set
+ *
+ * Owns several independent Eurovision contests (like two semi-finals and a
+ * final), each with an id. All the contests are run at once on a thread
+ * pool, and the qualifiers of contests can be promoted to another contest
+ * in bulk.
+ *
+ * A contest is run by one thread at a time and the contests share no data,
+ * so no locking is needed inside a Eurovision. The large rankings of all
+ * the contests are sorted on one more pool of the set, one thread per
+ * processor (see eurovisionSetRankPool). The set itself must not be
+ * used by two threads at the same time.
+ *
+ * The following functions are available:
+ *
+ * contestSetCreate            - Allocate a new empty set with a thread pool.
+ * contestSetDestroy           - Deallocate a set and all of its contests.
+ * contestSetAdd               - Add a contest to the set.
+ * contestSetGet               - Return a contest of the set.
+ * contestSetRunContests       - Run all the contests concurrently.
+ * contestSetGetRanking        - Return the ranking of the last run of a
+ *                               contest.
+ * contestSetPromoteQualifiers - Add the top states of contests to another
+ *                               contest.
+*/
+
+/** Type for defining a Contest Set */
+typedef struct ContestSet_t *ContestSet;
+
+/** Type used for returning error codes from contest set functions */
+typedef enum ContestSetResult_t{
+    CONTEST_SET_NULL_ARGUMENT,
+    CONTEST_SET_OUT_OF_MEMORY,
+    CONTEST_SET_INVALID_ID,
+    CONTEST_SET_INVALID_PERCENT,
+    CONTEST_SET_CONTEST_ALREADY_EXIST,
+    CONTEST_SET_CONTEST_NOT_EXIST,
+    CONTEST_SET_CONTEST_NOT_RUN,
+    CONTEST_SET_STATE_ALREADY_EXIST,
+    CONTEST_SET_STATE_NOT_EXIST,
+    CONTEST_SET_SUCCESS,
+    CONTEST_SET_INVALID_NAME,
+    CONTEST_SET_READ_ONLY,
+    CONTEST_SET_INVALID_ARGUMENT
+}ContestSetResult;
+
+/**
+* contestSetCreate: Allocates a new empty contest set
+*
+* @param numOfThreads - the number of threads that run the contests
+* @return
+* 	NULL - if numOfThreads<1 or allocations failed.
+* 	A new ContestSet in case of success.
+*/
+ContestSet contestSetCreate(int numOfThreads);
+
+/**
+* contestSetDestroy: Deallocate a contest set, its contests and their
+* rankings
+*
+* @param set - the set to deallocate, if NULL nothing will be done
+*/
+void contestSetDestroy(ContestSet set);
+
+/**
+* contestSetAdd: Add a contest to the set, the set owns the contest from now
+* on and destroys it with the set
+*
+* @param set - the set to add to
+* @param contestId - the id of the contest in the set, not negative
+* @param eurovision - the contest to add
+* @return
+* 	CONTEST_SET_NULL_ARGUMENT - if set or eurovision is NULL
+* 	CONTEST_SET_INVALID_ID - if contestId<0
+* 	CONTEST_SET_CONTEST_ALREADY_EXIST - if contestId is already in the set
+* 	CONTEST_SET_OUT_OF_MEMORY - in case of an allocation error, eurovision
+* 	                            is not added and not destroyed
+* 	CONTEST_SET_SUCCESS - if the contest was added
+*/
+ContestSetResult contestSetAdd(ContestSet set, int contestId,
+                               Eurovision eurovision);
+
+/**
+* contestSetGet: Return a contest of the set, to add states, judges and votes
+* to it. The contest still belongs to the set.
+*
+* @param set - the set
+* @param contestId - the id of the contest
+* @return
+* 	NULL - if set is NULL or contestId is not in the set
+* 	the contest otherwise
+*/
+Eurovision contestSetGet(ContestSet set, int contestId);
+
+/**
+* contestSetRunContests: Run eurovisionRunContestInto on every contest of the
+* set concurrently and wait for all of them
+*
+* A contest whose run fails with EUROVISION_OUT_OF_MEMORY is destroyed by
+* the run (like in eurovisionRunContestInto) and removed from the set.
+*
+* @param set - the set to run
+* @param audiencePercent - the audience percent of all the contests
+* @return
+* 	CONTEST_SET_NULL_ARGUMENT - if set is NULL
+* 	CONTEST_SET_INVALID_PERCENT - if audiencePercent is not between 1 and 100
+* 	CONTEST_SET_OUT_OF_MEMORY - in case of an allocation error in one of the
+* 	                            runs
+* 	CONTEST_SET_SUCCESS - if all the contests were run
+*/
+ContestSetResult contestSetRunContests(ContestSet set, int audiencePercent);
+
+/**
+* contestSetGetRanking: Return the ranking of the last run of a contest
+*
+* @param set - the set
+* @param contestId - the id of the contest
+* @return
+* 	NULL - if set is NULL, contestId is not in the set or was not run yet
+* 	the ranking of the contest otherwise, it belongs to the set and is valid
+* 	until the next run
+*/
+RankingResult contestSetGetRanking(ContestSet set, int contestId);
+
+/**
+* contestSetPromoteQualifiers: Add the numOfQualifiers highest ranked states
+* of every contest in fromIds to the contest finalId, in one bulk
+* eurovisionPromoteStatesFrom
+*
+* The rankings of the last contestSetRunContests are used. A contest with
+* less states than numOfQualifiers promotes all of them. The qualifiers of
+* all the contests are checked before any of them is added, so on an error
+* the final is not changed (or destroyed, on an allocation error).
+*
+* @param set - the set
+* @param fromIds - the ids of the contests to promote from
+* @param numOfContests - the number of ids in fromIds
+* @param finalId - the id of the contest to promote to
+* @param numOfQualifiers - the number of states to promote from each contest
+* @return
+* 	CONTEST_SET_NULL_ARGUMENT - if set or fromIds is NULL
+* 	CONTEST_SET_INVALID_ID - if numOfQualifiers<0 or finalId is in fromIds
+* 	CONTEST_SET_CONTEST_NOT_EXIST - if one of the contests is not in the set
+* 	CONTEST_SET_CONTEST_NOT_RUN - if one of the fromIds contests was not run
+* 	CONTEST_SET_READ_ONLY - if the final is a snapshot
+* 	CONTEST_SET_STATE_ALREADY_EXIST - if a qualifier is already in the final
+* 	                                  or qualified from two contests
+* 	CONTEST_SET_STATE_NOT_EXIST - if a qualifier was removed from its contest
+* 	                              after the run
+* 	CONTEST_SET_OUT_OF_MEMORY - in case of an allocation error, if it
+* 	                            happened while adding the qualifiers the
+* 	                            final is destroyed and removed from the set
+* 	CONTEST_SET_SUCCESS - if all the qualifiers were promoted
+*/
+ContestSetResult contestSetPromoteQualifiers(ContestSet set,
+                                             const int *fromIds,
+                                             int numOfContests, int finalId,
+                                             int numOfQualifiers);
+
+#endif
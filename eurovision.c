@@ -1,17 +1,59 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
+#include <time.h>
+#include <limits.h>
+#include <unistd.h>
 #include "eurovision.h"
 #include "list.h"
 #include "state.h"
 #include "judge.h"
+#include "score.h"
+#include "ranking.h"
+#include "allocator.h"
+#include "typedmap.h"
+#include "statetable.h"
+#include "simulation.h"
+#include "votegraph.h"
 
-#define STATE_ID 0
-#define AUDIENCE_SCORE 1
-#define JUDGES_SCORE 2
-#define NUM_OF_PARAMETERS 3
+#define AUDIENCE_SCORE 0
+#define JUDGES_SCORE 1
+#define NUM_OF_PARAMETERS 2
+#define PARALLEL_RANK_THRESHOLD (1<<16)
 
+/** The range of state ids that takes part in every ranking */
+#define ALL_STATES ((StateRange){0, INT_MAX})
+
+#ifdef EUROVISION_STATS
+/** Start timing the ranking phases */
+#define EUROVISION_PHASE_START(start) clock_t start = clock()
+/** Add the time since start to phase and restart the timing from now */
+#define EUROVISION_PHASE_END(eurovision, phase, start) \
+    do{ \
+        clock_t now = clock(); \
+        (eurovision)->phaseTicks.phase += now-(start); \
+        (start) = now; \
+    }while(0)
+#define EUROVISION_COUNT_RANKING(eurovision) \
+    ((eurovision)->phaseTicks.rankings++)
+#else
+#define EUROVISION_PHASE_START(start)
+#define EUROVISION_PHASE_END(eurovision, phase, start) do{}while(0)
+#define EUROVISION_COUNT_RANKING(eurovision) ((void)0)
+#endif
+
+#define TICKS_TO_SECONDS(ticks) ((double)(ticks)/CLOCKS_PER_SEC)
+
+/** Allocate and free the buffers of the result builders */
+#define RESULT_ALLOCATE(allocator, size) \
+    allocatorAllocate(allocator, ALLOCATOR_RESULTS, size)
+#define RESULT_FREE(allocator, block) allocatorFree(allocator, block)
+
+/** The judges of a eurovision, by id */
+DEFINE_TYPED_MAP(JudgeMap, judgeMap, int, Judge, typedMapCompareInts,
+                 judgeDestroy)
 
 /** check if str contain only lower case letters and spaces return true
  * if it does and false other wise
@@ -21,11 +63,101 @@ bool checkName(const char* str);
 /** check each int in ids array and search for a matching state
  * with the same id in the states map container
  */
-int checkIfStatesExists(Map states, int *ids);
+int checkIfStatesExists(StateTable states, int *ids);
 
 /** check if their is two identical ints in ids arr */
 bool ContainSameState(int *ids);
 
+/** A state id and its index in the arguments of eurovisionAddStates */
+typedef struct IdIndex_t{
+    int id;
+    int index;
+}IdIndex;
+
+/** compare function for IdIndex by id for qsort */
+int idIndexQsortCompare(const void *pair1, const void *pair2);
+
+/** The states a ranking is for, the states with ids from minId to maxId */
+typedef struct StateRange_t{
+    int minId;
+    int maxId;
+}StateRange;
+
+/** The ids of the states removed in lazy removal mode that other states may
+ * still have votes to, in ascending order */
+typedef struct DeadStates_t{
+    int *ids;
+    int size;
+    int capacity;
+    bool lazy;
+    int compactThreshold;
+}DeadStates;
+
+/** check the arguments of eurovisionAddStates, return the error
+ * eurovisionAddState would return for the first bad state in the same
+ * order of checks, and EUROVISION_SUCCESS if all the states can be added.
+ * sortedIds is filled with the ids and their indexes sorted by id */
+EurovisionResult checkNewStates(Eurovision eurovision, const int *stateIds,
+                                const char **stateNames,
+                                const char **songNames, int numOfStates,
+                                IdIndex *sortedIds);
+
+/** create the states of eurovisionAddStates in sortedIds order and add
+ * them to the states table with one stateTableAddBulk */
+EurovisionResult putNewStates(Eurovision eurovision, const int *stateIds,
+                              const char **stateNames,
+                              const char **songNames, int numOfStates,
+                              IdIndex *sortedIds);
+
+/** compare function for ints for qsort */
+int intQsortCompare(const void *n1, const void *n2);
+
+/** add the states stateIds to to like eurovisionPromoteStatesFrom, state i
+ *  comes from sources[i], or from source if sources is NULL */
+EurovisionResult promoteStates(const Eurovision *sources, Eurovision source,
+                               Eurovision to, const int *stateIds,
+                               int numOfStates);
+
+/** check the ids of eurovisionRemoveStates in the order of checks of
+ * eurovisionRemoveState and fill sortedIds with them in ascending order.
+ * Two equal ids give EUROVISION_STATE_NOT_EXIST like a second removal */
+EurovisionResult checkRemovedStates(Eurovision eurovision,
+                                    const int *stateIds, int numOfStates,
+                                    int *sortedIds);
+
+/** remove in one pass over the judges every judge that voted to one of the
+ * states in sortedIds */
+EurovisionResult removeJudgesVotedTo(Eurovision eurovision, int *sortedIds,
+                                     int numOfStates);
+
+/** make room for numOfNew more ids in the dead states */
+EurovisionResult reserveDeadStates(Eurovision eurovision, int numOfNew);
+
+/** add the numOfStates ascending ids of sortedIds to the dead states, there
+ * must be room for them */
+void addDeadStates(Eurovision eurovision, const int *sortedIds,
+                   int numOfStates);
+
+/** delete the votes to the dead states from all the states in one pass and
+ * forget the dead states */
+void purgeDeadStates(Eurovision eurovision);
+
+/** purge the dead states if one of stateIds is dead, so a new state with
+ * the same id does not get the votes of the removed one */
+void purgeDeadStatesIfReused(Eurovision eurovision, const int *stateIds,
+                             int numOfStates);
+
+/** return the id of the state the state voted the most to, skipping the
+ * dead states, -1 if there is none */
+int findFavoriteStateId(Eurovision eurovision, State state);
+
+/** put a frozen copy of every state of eurovision, without the votes to the
+ * dead states, in snapshot */
+EurovisionResult snapshotStates(Eurovision eurovision, Eurovision snapshot);
+
+/** put a copy of every judge of eurovision in snapshot */
+EurovisionResult snapshotJudges(Eurovision eurovision, Eurovision snapshot);
+
 /** copy function for string for list element */
 ListElement stringListCopy (ListElement str);
 
@@ -35,75 +167,172 @@ void stringListFree(ListElement str);
 /** compare function for string for list element */
 int stringListCompare(ListElement str1, ListElement str2);
 
-/** copy function for state for list element */
-ListElement stateListCopy(ListElement state);
-
-/** delete function for state for list element */
-void stateListFree(ListElement state);
+/** copy function for borrowed string for list element, the list shares
+ * the string instead of copying it */
+ListElement stringListBorrow(ListElement str);
 
-/** compare function for state for list element
- * compare the states final score and if the score is the same
- * compare between the states ids*/
-int stateListCompareFinalScore(ListElement state1, ListElement state2);
+/** delete function for borrowed string for list element, does nothing */
+void stringListBorrowFree(ListElement str);
 
 /** compare function for state for list element
  * compare the states name
  */
 int stateListCompareName(ListElement state1, ListElement state2);
 
-/** return the index of the max number in arr */
-int findMaxIndex(double* arr, int size);
+/** enter eurovision valid scores to scores from results arr, scores[i]
+ * is the score of the state ids[i] of the numOfIds ascending ids.
+ * results contain state ids, the state with the highest score is at
+ * index 0 and so on. States that are not in ids are skipped.*/
+void feedScoreTo(double *scores, const int *ids, int numOfIds,
+                 const int *results, int resultsSize);
 
-/** return the index of the toSearch number in arr */
-int findIndex(double* arr, int size, double toSearch);
+/** calculate the audience scores of the numOfRanked rows of the states
+ * table from firstRow (all the states vote, the dead states get no votes)
+ * and feed them into the scores arr */
+EurovisionResult calculateAudienceScore(StateTable states, int firstRow,
+                                        int numOfRanked,
+                                        const DeadStates *dead,
+                                        double *scores);
 
-/** enter eurovision valid scores to arrToFeed in the feedIndex
- * from results arr.
- * results contain state ids, the state with the highest score is at
- * index 0 and so on.*/
-void feedScoreTo(int feedIndex, double **arrToFeed, int arrSize,
-                 int *results, int resultsSize);
-/** calculate the audience scores and feed them into the scores arr */
-EurovisionResult calculateAudienceScore(Map states, double **scores);
+/** calculate the final score of the numOfRanked rows of the states table
+ * from firstRow into the scores column of the table. The judges scores are
+ * used only if withJudges is true */
+EurovisionResult calculateTotalScores(Eurovision eurovision,
+                                      int audiencePercent, bool withJudges,
+                                      int firstRow, int numOfRanked);
 
-/** return the id of the most voted state of this spesific state */
-int findFavoriteStateId(State state);
+/** allocate the score arrays from allocator, the audience and judges
+ * scores are set to 0 */
+EurovisionResult initiateScoreArr(double *scores[NUM_OF_PARAMETERS],
+                                  int numOfStates, Allocator allocator);
+
+/** fill rankedRows with the numOfRanked rows of the states table from
+ * firstRow, from the highest final score to the lowest, sorting on pool
+ * (on the calling thread if pool is NULL) */
+EurovisionResult rankStates(StateTable states, int firstRow,
+                            int numOfRanked, int *rankedRows,
+                            ThreadPool pool);
+
+/** return the pool to rank numOfRanked states of eurovision on, NULL to
+ * rank them on the calling thread. The first large ranking of a eurovision
+ * without a pool of eurovisionSetRankPool starts its own pool */
+ThreadPool getRankPool(Eurovision eurovision, int numOfRanked);
+
+/** run the contest (or the audience only ranking if withJudges is false)
+ * for the states in range and set rankedRows to a new array allocated
+ * from the eurovision allocator of the rows of the numOfRanked ranked
+ * states in the states table, NULL if there are no states in range */
+EurovisionResult runRanking(Eurovision eurovision, int audiencePercent,
+                            bool withJudges, StateRange range,
+                            int **rankedRows, int *numOfRanked);
+
+/** run a ranking and insert the ranked states names to resultList */
+EurovisionResult runRankingToList(Eurovision eurovision, int audiencePercent,
+                                  bool withJudges, StateRange range,
+                                  List resultList);
+
+/** run a ranking and fill ranking with the ranked states */
+EurovisionResult runRankingToResult(Eurovision eurovision,
+                                    int audiencePercent, bool withJudges,
+                                    RankingResult ranking);
+
+/** return the index of stateId in the sorted ids arr, -1 if not found */
+int findStateIndex(const int *ids, int size, int stateId);
+
+/** return the number of (taker, count) votes of state in the vote graph,
+ *  its citizen votes or the top votes of a frozen state */
+int countGraphVotes(State state);
+
+/** fill graph with the votes of the states of eurovision, in one pass over
+ *  the votes of every state, in arrays allocated from allocator (malloc if
+ *  it is NULL). The votes to states that are not in the states table
+ *  (removed states) are left out */
+EurovisionResult buildVoteGraph(Eurovision eurovision, VoteGraph *graph,
+                                Allocator allocator);
+
+/** deallocate the arrays of a graph of buildVoteGraph to allocator */
+void clearVoteGraph(VoteGraph *graph, Allocator allocator);
+
+/** fill contest with the votes of graph and the judges scores of
+ *  eurovision, in a new judges array allocated from the eurovision
+ *  allocator */
+EurovisionResult buildSimulationContest(Eurovision eurovision,
+                                        const VoteGraph *graph,
+                                        SimulationContest *contest);
+
+/** return a new string, allocated from allocator, of the names of the
+ *  numOfNames states in names (which are sorted) separated by " - " */
+char* createVotingBlocStr(char **names, int numOfNames, Allocator allocator);
 
-/** check if two sorted Lists of states is identical */
-bool statesSortedListIdentical(List statesList1, List statesList2);
+/** return a new string, allocated from allocator, of the two states names
+ * ordered by name and separated by " - " */
+char* createFriendlyStatesStr(State state1, State state2,
+                              Allocator allocator);
 
-/** check if the states lists arr contain a spesific states list */
-bool arrContainStatesList(List *friendlyStatesArr, int size,
-                          List friendlyStates);
-/** convert states list arr to string list containing the states names */
-List convertStatesArrToStrList(List *friendlyStatesArr, int size);
+/** compare function for strings for qsort */
+int stringQsortCompare(const void *str1, const void *str2);
 
-/** return an arr that contain states id from the most voted (index 0)
- * state to the least voted */
-int* transformAudienceScoreToArr(Map citizenVotes);
+#ifdef EUROVISION_STATS
+/** Processor time spent in every phase of the rankings */
+typedef struct PhaseTicks_t{
+    long rankings;
+    clock_t audience;
+    clock_t judges;
+    clock_t combine;
+    clock_t sort;
+    clock_t result;
+}PhaseTicks;
+#endif
 
 struct eurovision_t{
-    Map judges;
-    Map states;
+    Allocator allocator;
+    JudgeMap judges;
+    StateTable states;
+    StringPool names;
+    DeadStates dead;
+    bool readOnly;
+    ThreadPool rankPool;
+    bool ownsRankPool;
+    bool rankPoolChosen;
+#ifdef EUROVISION_STATS
+    PhaseTicks phaseTicks;
+#endif
 };
 
 Eurovision eurovisionCreate(){
-    Eurovision newEurovision = malloc(sizeof(*newEurovision));
-    if(!newEurovision) return NULL;
-    newEurovision->judges = mapCreate(judgeMapDataElementCopy,
-                                      judgeMapKeyElementCopy,
-                                      judgeMapDataElementFree,
-                                      judgeMapKeyElementFree,
-                                      judgeMapKeyCompare);
+    return eurovisionCreateWithAllocator(NULL, 0);
+}
+
+Eurovision eurovisionCreateWithAllocator(const AllocatorHooks *hooks,
+                                         size_t memoryLimit){
+    Allocator allocator = allocatorCreate(hooks, memoryLimit);
+    if(!allocator) return NULL;
+    Eurovision newEurovision = allocatorAllocate(allocator, ALLOCATOR_OTHER,
+                                                 sizeof(*newEurovision));
+    if(!newEurovision){
+        allocatorDestroy(allocator);
+        return NULL;
+    }
+    newEurovision->allocator = allocator;
+    newEurovision->judges = NULL;
+    newEurovision->states = NULL;
+    newEurovision->dead = (DeadStates){NULL, 0, 0, false, 0};
+    newEurovision->readOnly = false;
+    newEurovision->rankPool = NULL;
+    newEurovision->ownsRankPool = false;
+    newEurovision->rankPoolChosen = false;
+    eurovisionResetStats(newEurovision);
+    newEurovision->names = stringPoolCreateWithAllocator(allocator);
+    if(!newEurovision->names){
+        eurovisionDestroy(newEurovision);
+        return NULL;
+    }
+    newEurovision->judges = judgeMapCreate(allocator);
     if(!newEurovision->judges){
         eurovisionDestroy(newEurovision);
         return NULL;
     }
-    newEurovision->states = mapCreate(stateMapDataElementCopy,
-                                      stateMapKeyElementCopy,
-                                      stateMapDataElementFree,
-                                      stateMapKeyElementFree,
-                                      stateMapKeyCompare);
+    newEurovision->states = stateTableCreate(allocator);
     if(!newEurovision->states) {
         eurovisionDestroy(newEurovision);
         return NULL;
@@ -113,13 +342,16 @@ Eurovision eurovisionCreate(){
 
 void eurovisionDestroy(Eurovision eurovision){
     if(!eurovision) return;
-    if(eurovision->judges){
-        mapDestroy(eurovision->judges);
-    }
-    if(eurovision->states){
-        mapDestroy(eurovision->states);
-    }
-    free(eurovision);
+    judgeMapDestroy(eurovision->judges);
+    stateTableDestroy(eurovision->states);
+    stringPoolDestroy(eurovision->names);
+    if(eurovision->ownsRankPool){
+        threadPoolDestroy(eurovision->rankPool);
+    }
+    Allocator allocator = eurovision->allocator;
+    allocatorFree(allocator, eurovision->dead.ids);
+    allocatorFree(allocator, eurovision);
+    allocatorDestroy(allocator);
 }
 
 bool checkName(const char* str){
@@ -135,10 +367,10 @@ bool checkName(const char* str){
     return true;
 }
 
-int checkIfStatesExists(Map states, int *ids){
+int checkIfStatesExists(StateTable states, int *ids){
     for(int i=0;i<NUM_OF_JUDGE_RESULTS;i++){
         if(ids[i]<0) return -1;
-        if(!mapContains(states, &ids[i])){
+        if(stateTableFind(states, ids[i])<0){
             return 0;
         }
     }
@@ -163,66 +395,374 @@ EurovisionResult eurovisionAddState(Eurovision eurovision, int stateId,
     if (!eurovision || !stateName || !songName) {
                                             return EUROVISION_NULL_ARGUMENT;
                                         }
+    if (eurovision->readOnly) return EUROVISION_READ_ONLY;
     if (stateId < 0) return EUROVISION_INVALID_ID;
     if (!checkName(stateName) || !checkName(songName)) {
         return EUROVISION_INVALID_NAME;
     }
-    if (mapContains(eurovision->states, &stateId)) {
+    if (stateTableFind(eurovision->states, stateId) >= 0) {
         return EUROVISION_STATE_ALREADY_EXIST;
     }
-    State newState = stateCreate(stateId, stateName, songName);
+    purgeDeadStatesIfReused(eurovision, &stateId, 1);
+    State newState = stateCreateWithAllocator(stateId, stateName, songName,
+                                              eurovision->names,
+                                              eurovision->allocator);
     if(!newState){
        eurovisionDestroy(eurovision);
        return EUROVISION_OUT_OF_MEMORY;
     }
-    if(mapPut(eurovision->states, &stateId, newState) != MAP_SUCCESS){
+    if(stateTableAdd(eurovision->states, newState) != STATE_TABLE_SUCCESS){
+            stateDestroy(newState);
             eurovisionDestroy(eurovision);
             return EUROVISION_OUT_OF_MEMORY;
     }
-    stateDestroy(newState);
     return EUROVISION_SUCCESS;
 }
 
+int idIndexQsortCompare(const void *pair1, const void *pair2){
+    int first = ((const IdIndex*)pair1)->id;
+    int second = ((const IdIndex*)pair2)->id;
+    return (first > second) - (first < second);
+}
+
+EurovisionResult checkNewStates(Eurovision eurovision, const int *stateIds,
+                                const char **stateNames,
+                                const char **songNames, int numOfStates,
+                                IdIndex *sortedIds){
+    for(int i=0; i<numOfStates; i++){
+        if(!stateNames[i]||!songNames[i]) return EUROVISION_NULL_ARGUMENT;
+    }
+    for(int i=0; i<numOfStates; i++){
+        if(stateIds[i]<0) return EUROVISION_INVALID_ID;
+    }
+    for(int i=0; i<numOfStates; i++){
+        if(!checkName(stateNames[i])||!checkName(songNames[i])){
+            return EUROVISION_INVALID_NAME;
+        }
+    }
+    for(int i=0; i<numOfStates; i++){
+        if(stateTableFind(eurovision->states, stateIds[i]) >= 0){
+            return EUROVISION_STATE_ALREADY_EXIST;
+        }
+        sortedIds[i].id = stateIds[i];
+        sortedIds[i].index = i;
+    }
+    qsort(sortedIds, numOfStates, sizeof(IdIndex), idIndexQsortCompare);
+    for(int i=1; i<numOfStates; i++){
+        if(sortedIds[i-1].id == sortedIds[i].id){
+            return EUROVISION_STATE_ALREADY_EXIST;
+        }
+    }
+    return EUROVISION_SUCCESS;
+}
+
+EurovisionResult putNewStates(Eurovision eurovision, const int *stateIds,
+                              const char **stateNames,
+                              const char **songNames, int numOfStates,
+                              IdIndex *sortedIds){
+    State *states = allocatorAllocate(eurovision->allocator, ALLOCATOR_OTHER,
+                                      sizeof(State)*numOfStates);
+    EurovisionResult result = EUROVISION_SUCCESS;
+    int created = 0;
+    if(!states){
+        result = EUROVISION_OUT_OF_MEMORY;
+    }
+    for(; created<numOfStates && result==EUROVISION_SUCCESS; created++){
+        int index = sortedIds[created].index;
+        states[created] = stateCreateWithAllocator(stateIds[index],
+                                                   stateNames[index],
+                                                   songNames[index],
+                                                   eurovision->names,
+                                                   eurovision->allocator);
+        if(!states[created]){
+            result = EUROVISION_OUT_OF_MEMORY;
+            break;
+        }
+    }
+    if(result==EUROVISION_SUCCESS &&
+       stateTableAddBulk(eurovision->states, states,
+                         numOfStates)!=STATE_TABLE_SUCCESS){
+        result = EUROVISION_OUT_OF_MEMORY;
+    }
+    for(int i=0; i<created && result!=EUROVISION_SUCCESS; i++){
+        stateDestroy(states[i]);
+    }
+    allocatorFree(eurovision->allocator, states);
+    return result;
+}
+
+EurovisionResult eurovisionAddStates(Eurovision eurovision,
+                                     const int *stateIds,
+                                     const char **stateNames,
+                                     const char **songNames,
+                                     int numOfStates){
+    if(!eurovision||!stateIds||!stateNames||!songNames){
+        return EUROVISION_NULL_ARGUMENT;
+    }
+    if(eurovision->readOnly) return EUROVISION_READ_ONLY;
+    if(numOfStates<=0) return EUROVISION_SUCCESS;
+    IdIndex *sortedIds = allocatorAllocate(eurovision->allocator,
+                                           ALLOCATOR_OTHER,
+                                           sizeof(IdIndex)*numOfStates);
+    if(!sortedIds){
+        eurovisionDestroy(eurovision);
+        return EUROVISION_OUT_OF_MEMORY;
+    }
+    EurovisionResult result = checkNewStates(eurovision, stateIds, stateNames,
+                                             songNames, numOfStates,
+                                             sortedIds);
+    if(result==EUROVISION_SUCCESS){
+        purgeDeadStatesIfReused(eurovision, stateIds, numOfStates);
+        result = putNewStates(eurovision, stateIds, stateNames, songNames,
+                              numOfStates, sortedIds);
+    }
+    allocatorFree(eurovision->allocator, sortedIds);
+    if(result==EUROVISION_OUT_OF_MEMORY){
+        eurovisionDestroy(eurovision);
+    }
+    return result;
+}
+
+EurovisionResult eurovisionPromoteStates(Eurovision from, Eurovision to,
+                                         const int *stateIds,
+                                         int numOfStates){
+    if(!from) return EUROVISION_NULL_ARGUMENT;
+    return promoteStates(NULL, from, to, stateIds, numOfStates);
+}
+
+EurovisionResult eurovisionPromoteStatesFrom(const Eurovision *from,
+                                             Eurovision to,
+                                             const int *stateIds,
+                                             int numOfStates){
+    if(!from) return EUROVISION_NULL_ARGUMENT;
+    for(int i=0; i<numOfStates; i++){
+        if(!from[i]) return EUROVISION_NULL_ARGUMENT;
+    }
+    return promoteStates(from, NULL, to, stateIds, numOfStates);
+}
+
+EurovisionResult promoteStates(const Eurovision *sources, Eurovision source,
+                               Eurovision to, const int *stateIds,
+                               int numOfStates){
+    if(!to||!stateIds) return EUROVISION_NULL_ARGUMENT;
+    if(to->readOnly) return EUROVISION_READ_ONLY;
+    if(numOfStates<=0) return EUROVISION_SUCCESS;
+    for(int i=0; i<numOfStates; i++){
+        Eurovision from = sources ? sources[i] : source;
+        if(stateIds[i]<0) return EUROVISION_INVALID_ID;
+        if(stateTableFind(from->states, stateIds[i])<0){
+            return EUROVISION_STATE_NOT_EXIST;
+        }
+    }
+    /* the scratch arrays count against the memory of to, the eurovision
+     * that is destroyed when memory runs out */
+    const char **names = allocatorAllocate(to->allocator, ALLOCATOR_OTHER,
+                                           sizeof(char*)*numOfStates);
+    const char **songs = allocatorAllocate(to->allocator, ALLOCATOR_OTHER,
+                                           sizeof(char*)*numOfStates);
+    if(!names||!songs){
+        allocatorFree(to->allocator, names);
+        allocatorFree(to->allocator, songs);
+        eurovisionDestroy(to);
+        return EUROVISION_OUT_OF_MEMORY;
+    }
+    for(int i=0; i<numOfStates; i++){
+        Eurovision from = sources ? sources[i] : source;
+        State state = stateTableGet(from->states, stateIds[i]);
+        names[i] = stateGetName(state);
+        songs[i] = stateGetSong(state);
+    }
+    EurovisionResult result = eurovisionAddStates(to, stateIds, names, songs,
+                                                  numOfStates);
+    allocatorFree(to->allocator, names);
+    allocatorFree(to->allocator, songs);
+    return result;
+}
+
 EurovisionResult eurovisionRemoveState(Eurovision eurovision, int stateId){
-    if(!eurovision) return EUROVISION_NULL_ARGUMENT;
-    if(stateId<0) return EUROVISION_INVALID_ID;
-    if(!mapContains(eurovision->states, &stateId)) {
-        return EUROVISION_STATE_NOT_EXIST;
+    return eurovisionRemoveStates(eurovision, &stateId, 1);
+}
+
+int intQsortCompare(const void *n1, const void *n2){
+    int first = *(const int*)n1;
+    int second = *(const int*)n2;
+    return (first > second) - (first < second);
+}
+
+EurovisionResult checkRemovedStates(Eurovision eurovision,
+                                    const int *stateIds, int numOfStates,
+                                    int *sortedIds){
+    for(int i=0; i<numOfStates; i++){
+        if(stateIds[i]<0) return EUROVISION_INVALID_ID;
+        sortedIds[i] = stateIds[i];
     }
-    int numOfJudges = mapGetSize(eurovision->judges);
-    if(numOfJudges>0) {
-        int* judgesToRemove = malloc(sizeof(int)*numOfJudges);
-        if(!judgesToRemove){
-            eurovisionDestroy(eurovision);
-            return EUROVISION_OUT_OF_MEMORY;
+    qsort(sortedIds, numOfStates, sizeof(int), intQsortCompare);
+    for(int i=0; i<numOfStates; i++){
+        if((i>0 && sortedIds[i-1] == sortedIds[i]) ||
+           stateTableFind(eurovision->states, sortedIds[i])<0){
+            return EUROVISION_STATE_NOT_EXIST;
         }
-        int i=-1;
-        MAP_FOREACH(int*, judgeIdIter, eurovision->judges){
-            Judge tmpJudge = (Judge)mapGet(eurovision->judges, judgeIdIter);
-            if (judgeVotedToState(tmpJudge, stateId)) {
-                i++;
-                judgesToRemove[i] = judgeGetId(tmpJudge);
+    }
+    return EUROVISION_SUCCESS;
+}
+
+EurovisionResult removeJudgesVotedTo(Eurovision eurovision, int *sortedIds,
+                                     int numOfStates){
+    int numOfJudges = judgeMapGetSize(eurovision->judges);
+    if(numOfJudges<=0) return EUROVISION_SUCCESS;
+    int* judgesToRemove = allocatorAllocate(eurovision->allocator,
+                                            ALLOCATOR_OTHER,
+                                            sizeof(int)*numOfJudges);
+    if(!judgesToRemove) return EUROVISION_OUT_OF_MEMORY;
+    int numOfRemoved = 0;
+    TYPED_MAP_FOREACH(JudgeMap, judgeEntry, eurovision->judges){
+        int* tmpJudgeResults = judgeGetResults(judgeEntry->data);
+        for(int i=0; i<NUM_OF_JUDGE_RESULTS; i++){
+            if(findStateIndex(sortedIds, numOfStates,
+                              tmpJudgeResults[i]) != -1){
+                judgesToRemove[numOfRemoved++] = judgeEntry->key;
+                break;
             }
         }
-        for(; i>-1; i--){
-            eurovisionRemoveJudge(eurovision, judgesToRemove[i]);
+    }
+    judgeMapRemoveBulk(eurovision->judges, judgesToRemove, numOfRemoved);
+    allocatorFree(eurovision->allocator, judgesToRemove);
+    return EUROVISION_SUCCESS;
+}
+
+EurovisionResult eurovisionRemoveStates(Eurovision eurovision,
+                                        const int *stateIds,
+                                        int numOfStates){
+    if(!eurovision||!stateIds) return EUROVISION_NULL_ARGUMENT;
+    if(eurovision->readOnly) return EUROVISION_READ_ONLY;
+    if(numOfStates<=0) return EUROVISION_SUCCESS;
+    int *sortedIds = allocatorAllocate(eurovision->allocator, ALLOCATOR_OTHER,
+                                       sizeof(int)*numOfStates);
+    if(!sortedIds){
+        eurovisionDestroy(eurovision);
+        return EUROVISION_OUT_OF_MEMORY;
+    }
+    EurovisionResult result = checkRemovedStates(eurovision, stateIds,
+                                                 numOfStates, sortedIds);
+    if(result==EUROVISION_SUCCESS && eurovision->dead.lazy){
+        result = reserveDeadStates(eurovision, numOfStates);
+    }
+    if(result==EUROVISION_SUCCESS){
+        result = removeJudgesVotedTo(eurovision, sortedIds, numOfStates);
+    }
+    if(result==EUROVISION_SUCCESS){
+        if(eurovision->dead.lazy){
+            addDeadStates(eurovision, sortedIds, numOfStates);
+        }
+        else{
+            State *states = stateTableGetStates(eurovision->states);
+            int size = stateTableGetSize(eurovision->states);
+            for(int i=0; i<size; i++){
+                stateDeleteVotesOfStates(states[i], sortedIds, numOfStates);
+            }
+        }
+        stateTableRemoveBulk(eurovision->states, sortedIds, numOfStates);
+        if(eurovision->dead.compactThreshold>0 &&
+           eurovision->dead.size>=eurovision->dead.compactThreshold){
+            purgeDeadStates(eurovision);
         }
-        free(judgesToRemove);
     }
-    MAP_FOREACH(int*, stateIdIter, eurovision->states){
-        State tmpState = mapGet(eurovision->states, stateIdIter);
-        stateDeleteAllVotesOfSpecificState(tmpState, stateId);
+    allocatorFree(eurovision->allocator, sortedIds);
+    if(result==EUROVISION_OUT_OF_MEMORY){
+        eurovisionDestroy(eurovision);
     }
-    mapRemove(eurovision->states, &stateId);
+    return result;
+}
+
+EurovisionResult reserveDeadStates(Eurovision eurovision, int numOfNew){
+    DeadStates *dead = &eurovision->dead;
+    if(dead->size+numOfNew <= dead->capacity) return EUROVISION_SUCCESS;
+    int capacity = dead->capacity*2;
+    if(capacity < dead->size+numOfNew){
+        capacity = dead->size+numOfNew;
+    }
+    int *ids = allocatorAllocate(eurovision->allocator, ALLOCATOR_OTHER,
+                                 sizeof(int)*capacity);
+    if(!ids) return EUROVISION_OUT_OF_MEMORY;
+    if(dead->size>0){
+        memcpy(ids, dead->ids, sizeof(int)*dead->size);
+    }
+    allocatorFree(eurovision->allocator, dead->ids);
+    dead->ids = ids;
+    dead->capacity = capacity;
+    return EUROVISION_SUCCESS;
+}
+
+void addDeadStates(Eurovision eurovision, const int *sortedIds,
+                   int numOfStates){
+    DeadStates *dead = &eurovision->dead;
+    int i = dead->size-1, j = numOfStates-1;
+    dead->size += numOfStates;
+    for(int k = dead->size-1; j>=0; k--){
+        if(i>=0 && dead->ids[i]>sortedIds[j]){
+            dead->ids[k] = dead->ids[i--];
+        }
+        else{
+            dead->ids[k] = sortedIds[j--];
+        }
+    }
+}
+
+void purgeDeadStates(Eurovision eurovision){
+    DeadStates *dead = &eurovision->dead;
+    if(dead->size==0) return;
+    State *states = stateTableGetStates(eurovision->states);
+    int size = stateTableGetSize(eurovision->states);
+    for(int i=0; i<size; i++){
+        stateDeleteVotesOfStates(states[i], dead->ids, dead->size);
+    }
+    dead->size = 0;
+}
+
+void purgeDeadStatesIfReused(Eurovision eurovision, const int *stateIds,
+                             int numOfStates){
+    for(int i=0; i<numOfStates; i++){
+        if(findStateIndex(eurovision->dead.ids, eurovision->dead.size,
+                          stateIds[i]) != -1){
+            purgeDeadStates(eurovision);
+            return;
+        }
+    }
+}
+
+EurovisionResult eurovisionSetLazyRemoval(Eurovision eurovision, bool lazy,
+                                          int compactThreshold){
+    if(!eurovision) return EUROVISION_NULL_ARGUMENT;
+    eurovision->dead.lazy = lazy;
+    eurovision->dead.compactThreshold = compactThreshold;
+    if(!lazy){
+        purgeDeadStates(eurovision);
+    }
+    return EUROVISION_SUCCESS;
+}
+
+EurovisionResult eurovisionCompact(Eurovision eurovision){
+    if(!eurovision) return EUROVISION_NULL_ARGUMENT;
+    purgeDeadStates(eurovision);
     return EUROVISION_SUCCESS;
 }
 
+int findFavoriteStateId(Eurovision eurovision, State state){
+    int topStates[NUM_OF_TOP_VOTES];
+    if(stateGetTopVotesExcept(state, eurovision->dead.ids,
+                              eurovision->dead.size, topStates, NULL) <= 0){
+        return -1;
+    }
+    return topStates[0];
+}
+
 EurovisionResult eurovisionAddJudge(Eurovision eurovision, int judgeId,
                                     const char *judgeName,
                                     int *judgeResults){
     if(!eurovision || !judgeName || !judgeResults) {
         return EUROVISION_NULL_ARGUMENT;
     }
+    if(eurovision->readOnly) return EUROVISION_READ_ONLY;
     if(judgeId < 0) return EUROVISION_INVALID_ID;
     int resultsCheck = checkIfStatesExists(eurovision->states, judgeResults);
     if(resultsCheck == -1){
@@ -237,43 +777,51 @@ EurovisionResult eurovisionAddJudge(Eurovision eurovision, int judgeId,
     if(resultsCheck == 0){
         return EUROVISION_STATE_NOT_EXIST;
     }
-    if(mapContains(eurovision->judges, &judgeId)) {
+    if(judgeMapContains(eurovision->judges, judgeId)) {
         return EUROVISION_JUDGE_ALREADY_EXIST;
     }
-    Judge newJudge = judgeCreate(judgeId, judgeName, judgeResults);
-    if(mapPut(eurovision->judges, &judgeId, newJudge)== MAP_OUT_OF_MEMORY){
+    Judge newJudge = judgeCreateWithAllocator(judgeId, judgeName,
+                                              judgeResults, eurovision->names,
+                                              eurovision->allocator);
+    if(!newJudge){
+        eurovisionDestroy(eurovision);
+        return EUROVISION_OUT_OF_MEMORY;
+    }
+    if(judgeMapPut(eurovision->judges, judgeId, newJudge)== MAP_OUT_OF_MEMORY){
+        judgeDestroy(newJudge);
         eurovisionDestroy(eurovision);
         return EUROVISION_OUT_OF_MEMORY;
     }
-    judgeDestroy(newJudge);
     return EUROVISION_SUCCESS;
 }
 
 EurovisionResult eurovisionRemoveJudge(Eurovision eurovision, int judgeId){
     if(!eurovision) return EUROVISION_NULL_ARGUMENT;
+    if(eurovision->readOnly) return EUROVISION_READ_ONLY;
     if(judgeId < 0) return EUROVISION_INVALID_ID;
-    if(!mapContains(eurovision->judges, &judgeId)){
+    if(judgeMapRemove(eurovision->judges, judgeId)!=MAP_SUCCESS){
         return EUROVISION_JUDGE_NOT_EXIST;
     }
-    mapRemove(eurovision->judges, &judgeId);
     return EUROVISION_SUCCESS;
 }
 
 EurovisionResult eurovisionAddVote(Eurovision eurovision, int stateGiver,
                                    int stateTaker){
     if(!eurovision) return EUROVISION_NULL_ARGUMENT;
+    if(eurovision->readOnly) return EUROVISION_READ_ONLY;
     if(stateGiver<0||stateTaker<0){
         return EUROVISION_INVALID_ID;
     }
-    if(!mapContains(eurovision->states, &stateGiver)){
+    State giver = stateTableGet(eurovision->states, stateGiver);
+    if(!giver){
         return EUROVISION_STATE_NOT_EXIST;
     }
-    if(!mapContains(eurovision->states, &stateTaker)){
+    if(stateTableFind(eurovision->states, stateTaker)<0){
         return EUROVISION_STATE_NOT_EXIST;
     }
     if(stateGiver==stateTaker) return EUROVISION_SAME_STATE;
     StateResult result;
-    result = stateAddVote(mapGet(eurovision->states, &stateGiver), stateTaker);
+    result = stateAddVote(giver, stateTaker);
     if(result==STATE_OUT_OF_MEMORY){
         eurovisionDestroy(eurovision);
         return EUROVISION_OUT_OF_MEMORY;
@@ -284,19 +832,20 @@ EurovisionResult eurovisionAddVote(Eurovision eurovision, int stateGiver,
 EurovisionResult eurovisionRemoveVote(Eurovision eurovision, int stateGiver,
                                       int stateTaker){
     if(!eurovision) return EUROVISION_NULL_ARGUMENT;
+    if(eurovision->readOnly) return EUROVISION_READ_ONLY;
     if(stateGiver<0||stateTaker<0){
         return EUROVISION_INVALID_ID;
     }
-    if(!mapContains(eurovision->states, &stateGiver)){
+    State giver = stateTableGet(eurovision->states, stateGiver);
+    if(!giver){
         return EUROVISION_STATE_NOT_EXIST;
     }
-    if(!mapContains(eurovision->states, &stateTaker)){
+    if(stateTableFind(eurovision->states, stateTaker)<0){
         return EUROVISION_STATE_NOT_EXIST;
     }
     if(stateGiver==stateTaker) return EUROVISION_SAME_STATE;
     StateResult result;
-    result = stateDeleteVote(mapGet(eurovision->states,
-                             &stateGiver), stateTaker);
+    result = stateDeleteVote(giver, stateTaker);
     if(result==STATE_OUT_OF_MEMORY){
         eurovisionDestroy(eurovision);
         return EUROVISION_OUT_OF_MEMORY;
@@ -304,6 +853,114 @@ EurovisionResult eurovisionRemoveVote(Eurovision eurovision, int stateGiver,
     return EUROVISION_SUCCESS;
 }
 
+EurovisionResult eurovisionAddVotes(Eurovision eurovision,
+                                    const EurovisionVote *votes,
+                                    int numOfVotes, int *numOfSkipped){
+    if(!eurovision||(!votes && numOfVotes>0)){
+        return EUROVISION_NULL_ARGUMENT;
+    }
+    if(eurovision->readOnly) return EUROVISION_READ_ONLY;
+    int skipped = 0, giverId = -1;
+    State giver = NULL;
+    for(int i=0; i<numOfVotes; i++){
+        const EurovisionVote *vote = votes+i;
+        if(vote->giver<0||vote->taker<0||vote->count<=0||
+           vote->giver==vote->taker){
+            skipped++;
+            continue;
+        }
+        if(vote->giver!=giverId){
+            giverId = vote->giver;
+            giver = stateTableGet(eurovision->states, giverId);
+        }
+        if(!giver||stateTableFind(eurovision->states, vote->taker)<0){
+            skipped++;
+            continue;
+        }
+        StateResult result = stateAddVotes(giver, vote->taker, vote->count);
+        if(result==STATE_OUT_OF_MEMORY){
+            eurovisionDestroy(eurovision);
+            return EUROVISION_OUT_OF_MEMORY;
+        }
+        if(result==STATE_VOTES_OVERFLOW){
+            skipped++;
+        }
+    }
+    if(numOfSkipped){
+        *numOfSkipped = skipped;
+    }
+    return EUROVISION_SUCCESS;
+}
+
+EurovisionResult eurovisionMergeVotes(Eurovision eurovision,
+                                     Eurovision shard){
+    if(!eurovision||!shard) return EUROVISION_NULL_ARGUMENT;
+    if(eurovision->readOnly) return EUROVISION_READ_ONLY;
+    const int *ids = stateTableGetIds(shard->states);
+    State *states = stateTableGetStates(shard->states);
+    int size = stateTableGetSize(shard->states);
+    for(int i=0; i<size; i++){
+        if(stateTableFind(eurovision->states, ids[i])<0){
+            return EUROVISION_STATE_NOT_EXIST;
+        }
+    }
+    for(int i=0; i<size; i++){
+        if(stateMergeVotes(stateTableGet(eurovision->states, ids[i]),
+                           states[i])==STATE_OUT_OF_MEMORY){
+            eurovisionDestroy(eurovision);
+            return EUROVISION_OUT_OF_MEMORY;
+        }
+    }
+    return EUROVISION_SUCCESS;
+}
+
+EurovisionResult snapshotStates(Eurovision eurovision, Eurovision snapshot){
+    State *states = stateTableGetStates(eurovision->states);
+    int size = stateTableGetSize(eurovision->states);
+    for(int i=0; i<size; i++){
+        State frozen = stateFreeze(states[i], eurovision->dead.ids,
+                                   eurovision->dead.size, snapshot->names,
+                                   snapshot->allocator);
+        if(!frozen) return EUROVISION_OUT_OF_MEMORY;
+        if(stateTableAdd(snapshot->states, frozen)!=STATE_TABLE_SUCCESS){
+            stateDestroy(frozen);
+            return EUROVISION_OUT_OF_MEMORY;
+        }
+    }
+    return EUROVISION_SUCCESS;
+}
+
+EurovisionResult snapshotJudges(Eurovision eurovision, Eurovision snapshot){
+    TYPED_MAP_FOREACH(JudgeMap, judgeEntry, eurovision->judges){
+        Judge copy = judgeCreateWithAllocator(judgeEntry->key,
+                                              judgeGetName(judgeEntry->data),
+                                              judgeGetResults(judgeEntry->data),
+                                              snapshot->names,
+                                              snapshot->allocator);
+        if(!copy) return EUROVISION_OUT_OF_MEMORY;
+        if(judgeMapPut(snapshot->judges, judgeEntry->key,
+                       copy)!=MAP_SUCCESS){
+            judgeDestroy(copy);
+            return EUROVISION_OUT_OF_MEMORY;
+        }
+    }
+    return EUROVISION_SUCCESS;
+}
+
+Eurovision eurovisionSnapshot(Eurovision eurovision){
+    if(!eurovision) return NULL;
+    Eurovision snapshot = eurovisionCreate();
+    if(!snapshot||
+       snapshotStates(eurovision, snapshot)!=EUROVISION_SUCCESS||
+       snapshotJudges(eurovision, snapshot)!=EUROVISION_SUCCESS){
+        /* only the copy failed, the eurovision is left as it was */
+        eurovisionDestroy(snapshot);
+        return NULL;
+    }
+    snapshot->readOnly = true;
+    return snapshot;
+}
+
 ListElement stringListCopy (ListElement str){
     char* newStr = malloc(sizeof(char)*strlen(str)+1);
     if(!newStr) return NULL;
@@ -319,168 +976,220 @@ int stringListCompare(ListElement str1, ListElement str2){
     return strcmp(str1,str2);
 }
 
-ListElement stateListCopy(ListElement state){
-    if(!state) return NULL;
-    State newState = stateCopy((State)state);
-    assert(newState);
-    return newState;
+ListElement stringListBorrow(ListElement str){
+    return str;
 }
 
-void stateListFree(ListElement state){
-    if(!state) return;
-    stateDestroy((State)state);
-}
-
-int stateListCompareFinalScore(ListElement state1, ListElement state2){
-    double score1 = stateGetFinalScore((State)state1);
-    double score2 = stateGetFinalScore((State)state2);
-    if(score2==score1) {
-        int state1Id = stateGetId((State)state1);
-        int state2Id = stateGetId((State)state2);
-        return state1Id-state2Id;
-    }
-    if(score1>score2) return -1;
-    return 1;
+void stringListBorrowFree(ListElement str){
 }
 
 int stateListCompareName(ListElement state1, ListElement state2){
-    char* stateName1 = stateGetName((State)state1);
-    char* stateName2 = stateGetName((State)state2);
-    return strcmp(stateName1, stateName2);
+    return stateCompareName((State)state1, (State)state2);
 }
 
-int findMaxIndex(double* arr, int size){
-    if(!arr) return -1;
-    double max = *arr;
-    int maxIndex = 0;
-    for(int i=1; i<size; i++){
-        if(*(arr+i)>max){
-            maxIndex = i;
-            max = *(arr+i);
-        }
+void feedScoreTo(double *scores, const int *ids, int numOfIds,
+                 const int *results, int resultsSize){
+    if(!scores || !results || resultsSize <= 0) {
+        return;
     }
-    if(max <=0) return -1;
-    return maxIndex;
-}
-
-int findIndex(double* arr, int size, double toSearch){
-    for(int i=0; i<size; i++){
-        if(*(arr+i) == toSearch) return i;
+    for(int i=0; i<resultsSize; i++){
+        int currentStateId = results[i];
+        if(currentStateId<0) break;
+        int index = findStateIndex(ids, numOfIds, currentStateId);
+        if(index>=0){
+            scores[index]+=scoreTopVotesPoints(i);
+        }
     }
-    return -1;
 }
 
-void feedScoreTo(int feedIndex, double **arrToFeed, int arrSize,
-                 int *results, int resultsSize){
-    if(!arrToFeed || !results || resultsSize <= 0) {
-        return;
+EurovisionResult calculateAudienceScore(StateTable states, int firstRow,
+                                        int numOfRanked,
+                                        const DeadStates *dead,
+                                        double *scores){
+    if(!states||!scores) {
+        return EUROVISION_NULL_ARGUMENT;
     }
-    int score =12;
-    for(int i=0; i<resultsSize; i++){
-        int currentResultsId = *(results+i);
-        if(currentResultsId<0) break;
-        int currentStateId = *(results+i);
-        int index = findIndex(arrToFeed[STATE_ID], arrSize ,currentStateId);
-        *(arrToFeed[feedIndex]+index)+=score;
-        if(score == 0) continue;
-        if(score>8){
-            score -=2;
-        }
-        else{
-            score--;
-        }
+    const int *rankedIds = stateTableGetIds(states)+firstRow;
+    State *voters = stateTableGetStates(states);
+    int numOfStates = stateTableGetSize(states);
+    for(int i=0; i<numOfStates; i++){
+        int topStates[NUM_OF_TOP_VOTES];
+        int numOfTopVotes = stateGetTopVotesExcept(voters[i], dead->ids,
+                                                   dead->size, topStates,
+                                                   NULL);
+        feedScoreTo(scores, rankedIds, numOfRanked, topStates,
+                    numOfTopVotes);
     }
+    return EUROVISION_SUCCESS;
 }
 
-int* transformAudienceScoreToArr(Map citizenVotes){
-    if(!citizenVotes) return NULL;
-    int numOfStates = mapGetSize(citizenVotes);
-    if(numOfStates<=0) return NULL;
-    double* audienceScore[2];
-    for(int i=0; i<2; i++) {
-        audienceScore[i] = malloc(sizeof(double)*numOfStates);
-        if (!audienceScore[i]) {
-            for (; i >= 0; i--) {
-                free(audienceScore[i]);
+EurovisionResult initiateScoreArr(double *scores[NUM_OF_PARAMETERS],
+                                  int numOfStates, Allocator allocator){
+    for(int i = 0; i<NUM_OF_PARAMETERS; i++){
+        scores[i] = RESULT_ALLOCATE(allocator, sizeof(double)*numOfStates);
+        if(!scores[i]) {
+            for(; i>=0; i--){
+                RESULT_FREE(allocator, scores[i]);
             }
-            return NULL;
+            return EUROVISION_OUT_OF_MEMORY;
         }
     }
-    int *results = malloc(sizeof(int)*numOfStates);
-    if(!results) {
-        for (int i=0; i<2; i++) {
-            free(audienceScore[i]);
-        }
-        return NULL;
+    for(int i=0; i<numOfStates; i++){
+        *(scores[AUDIENCE_SCORE]+i) = 0;
+        *(scores[JUDGES_SCORE]+i) = 0;
     }
-    int maxIndex, maxStateId;
-    for(int i=0; i<numOfStates;i++){
-        results[i] = 0;
+    return EUROVISION_SUCCESS;
+}
+
+EurovisionResult calculateTotalScores(Eurovision eurovision,
+                                      int audiencePercent, bool withJudges,
+                                      int firstRow, int numOfRanked){
+    int numOfStates = stateTableGetSize(eurovision->states);
+    int numOfJudges = withJudges ? judgeMapGetSize(eurovision->judges) : 0;
+    const int *rankedIds = stateTableGetIds(eurovision->states)+firstRow;
+    double *totalScores = stateTableGetScores(eurovision->states)+firstRow;
+    double *scores[NUM_OF_PARAMETERS] = {0};
+    if(initiateScoreArr(scores, numOfRanked,
+                        eurovision->allocator)!=EUROVISION_SUCCESS) {
+        return EUROVISION_OUT_OF_MEMORY;
     }
-    int i=0;
-    MAP_FOREACH(int* ,stateIdIter, citizenVotes) {
-        double stateId = (double)*stateIdIter;
-        int num = *((int*)mapGet(citizenVotes, stateIdIter));
-        *(audienceScore[0] + i) = stateId;
-        *(audienceScore[1] + i) = num;
-        i++;
+    EUROVISION_PHASE_START(phaseStart);
+    calculateAudienceScore(eurovision->states, firstRow, numOfRanked,
+                           &eurovision->dead, scores[AUDIENCE_SCORE]);
+    EUROVISION_PHASE_END(eurovision, audience, phaseStart);
+    if(withJudges){
+        TYPED_MAP_FOREACH(JudgeMap, judgeEntry, eurovision->judges){
+            int* tmpJudgeResults = judgeGetResults(judgeEntry->data);
+            feedScoreTo(scores[JUDGES_SCORE], rankedIds, numOfRanked,
+                        tmpJudgeResults, NUM_OF_JUDGE_RESULTS);
+        }
     }
-    for(i=0; i<numOfStates; i++){
-        maxIndex = findMaxIndex(audienceScore[1], numOfStates);
-        if(maxIndex == -1) break;
-        maxStateId = *(audienceScore[0]+maxIndex);
-        results[i] = maxStateId;
-        *(audienceScore[1]+ maxIndex) = 0;
+    EUROVISION_PHASE_END(eurovision, judges, phaseStart);
+    scoreCombine(scores[AUDIENCE_SCORE],
+                 withJudges ? scores[JUDGES_SCORE] : NULL, totalScores,
+                 numOfRanked, numOfStates, numOfJudges,
+                 withJudges ? audiencePercent : 100);
+    EUROVISION_PHASE_END(eurovision, combine, phaseStart);
+    for(int i=0; i<NUM_OF_PARAMETERS; i++){
+        RESULT_FREE(eurovision->allocator, scores[i]);
     }
-    for (i=0; i<2; i++) {
-        free(audienceScore[i]);
+    return EUROVISION_SUCCESS;
+}
+
+ThreadPool getRankPool(Eurovision eurovision, int numOfRanked){
+    if(numOfRanked<PARALLEL_RANK_THRESHOLD) return NULL;
+    if(!eurovision->rankPoolChosen){
+        /* a pool of one thread would only add the cost of the handoff */
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        if(processors>1){
+            eurovision->rankPool = threadPoolCreate((int)processors);
+            eurovision->ownsRankPool = eurovision->rankPool!=NULL;
+        }
+        eurovision->rankPoolChosen = true;
     }
-    return results;
+    return eurovision->rankPool;
 }
 
-EurovisionResult calculateAudienceScore(Map states, double **scores){
-    if(!states||!scores) {
-        return EUROVISION_NULL_ARGUMENT;
+EurovisionResult rankStates(StateTable states, int firstRow,
+                            int numOfRanked, int *rankedRows,
+                            ThreadPool pool){
+    if(scoreRankParallel(stateTableGetScores(states)+firstRow,
+                         stateTableGetIds(states)+firstRow, rankedRows,
+                         numOfRanked, pool)!=SCORE_SUCCESS){
+        return EUROVISION_OUT_OF_MEMORY;
     }
-    int numOfStates = mapGetSize(states);
-    int i = 0;
-    MAP_FOREACH(int*, stateIdIter, states){
-        State tmpState = (State) mapGet(states, stateIdIter);
-        stateSetScore(tmpState, 0);
-        int stateId =  *stateIdIter;
-        *(scores[STATE_ID]+i) = stateId;
-        i++;
+    for(int i=0; i<numOfRanked; i++){
+        rankedRows[i] += firstRow;
     }
+    return EUROVISION_SUCCESS;
+}
 
-    MAP_FOREACH(int*, stateIdIter, states) {
-        State tmpState = (State) mapGet(states, stateIdIter);
-        Map citizensVotes = stateGetCitizenVotes(tmpState);
-        int *results = transformAudienceScoreToArr(citizensVotes);
-        if (results) {
-            int resultsSize = mapGetSize(citizensVotes);
-            feedScoreTo(AUDIENCE_SCORE, scores,
-                        numOfStates, results, resultsSize);
-            free(results);
-        }
+EurovisionResult runRanking(Eurovision eurovision, int audiencePercent,
+                            bool withJudges, StateRange range,
+                            int **rankedRows, int *numOfRanked){
+    *rankedRows = NULL;
+    int firstRow = stateTableLowerBound(eurovision->states, range.minId);
+    int numOfStates = stateTableUpperBound(eurovision->states,
+                                           range.maxId)-firstRow;
+    *numOfRanked = numOfStates > 0 ? numOfStates : 0;
+    if(numOfStates<=0) return EUROVISION_SUCCESS;
+    Allocator allocator = eurovision->allocator;
+    int *ranked = RESULT_ALLOCATE(allocator, sizeof(int)*numOfStates);
+    if(!ranked){
+        return EUROVISION_OUT_OF_MEMORY;
     }
+    EUROVISION_COUNT_RANKING(eurovision);
+    EurovisionResult result = calculateTotalScores(eurovision,
+                                                   audiencePercent,
+                                                   withJudges, firstRow,
+                                                   numOfStates);
+    if(result==EUROVISION_SUCCESS){
+        EUROVISION_PHASE_START(phaseStart);
+        result = rankStates(eurovision->states, firstRow, numOfStates,
+                            ranked, getRankPool(eurovision, numOfStates));
+        EUROVISION_PHASE_END(eurovision, sort, phaseStart);
+    }
+    if(result!=EUROVISION_SUCCESS){
+        RESULT_FREE(allocator, ranked);
+        *numOfRanked = 0;
+        return result;
+    }
+    *rankedRows = ranked;
     return EUROVISION_SUCCESS;
 }
 
-EurovisionResult initiateScoreArr(double *scores[NUM_OF_PARAMETERS],
-                                  int numOfStates){
-    for(int i = 0; i<NUM_OF_PARAMETERS; i++){
-        scores[i] = malloc(sizeof(double)*numOfStates);
-        if(!scores[i]) {
-            for(; i>=0; i--){
-                free(scores[i]);
-            }
-            return EUROVISION_OUT_OF_MEMORY;
+EurovisionResult runRankingToList(Eurovision eurovision, int audiencePercent,
+                                  bool withJudges, StateRange range,
+                                  List resultList){
+    int *rankedRows;
+    int numOfStates;
+    EurovisionResult result = runRanking(eurovision, audiencePercent,
+                                         withJudges, range, &rankedRows,
+                                         &numOfStates);
+    if(result!=EUROVISION_SUCCESS) return result;
+    EUROVISION_PHASE_START(phaseStart);
+    State *states = stateTableGetStates(eurovision->states);
+    for(int i=0; i<numOfStates && rankedRows; i++){
+        if(listInsertLast(resultList,
+                          stateGetName(states[rankedRows[i]]))!=LIST_SUCCESS){
+            result = EUROVISION_OUT_OF_MEMORY;
+            break;
         }
     }
+    RESULT_FREE(eurovision->allocator, rankedRows);
+    EUROVISION_PHASE_END(eurovision, result, phaseStart);
+    return result;
+}
+
+EurovisionResult runRankingToResult(Eurovision eurovision,
+                                    int audiencePercent, bool withJudges,
+                                    RankingResult ranking){
+    int *rankedRows;
+    int numOfStates;
+    rankingClear(ranking);
+    EurovisionResult result = runRanking(eurovision, audiencePercent,
+                                         withJudges, ALL_STATES,
+                                         &rankedRows, &numOfStates);
+    if(result!=EUROVISION_SUCCESS || !rankedRows) return result;
+    EUROVISION_PHASE_START(phaseStart);
+    const int *ids = stateTableGetIds(eurovision->states);
+    const double *scores = stateTableGetScores(eurovision->states);
+    State *states = stateTableGetStates(eurovision->states);
+    int numOfChars = 0;
     for(int i=0; i<numOfStates; i++){
-        *(scores[AUDIENCE_SCORE]+i) = 0;
-        *(scores[JUDGES_SCORE]+i) = 0;
+        numOfChars += (int)strlen(stateGetName(states[rankedRows[i]]))+1;
+    }
+    if(rankingReserve(ranking, numOfStates, numOfChars)!=RANKING_SUCCESS){
+        RESULT_FREE(eurovision->allocator, rankedRows);
+        return EUROVISION_OUT_OF_MEMORY;
     }
+    for(int i=0; i<numOfStates; i++){
+        int row = rankedRows[i];
+        rankingAppend(ranking, ids[row], scores[row],
+                      stateGetName(states[row]));
+    }
+    RESULT_FREE(eurovision->allocator, rankedRows);
+    EUROVISION_PHASE_END(eurovision, result, phaseStart);
     return EUROVISION_SUCCESS;
 }
 
@@ -488,256 +1197,469 @@ List eurovisionRunContest(Eurovision eurovision, int audiencePercent){
     if(audiencePercent<1||audiencePercent>100){
         return NULL;
     }
-    List resultList = listCreate(stringListCopy, stringListFree);
+    List resultList = listCreate(stringListBorrow, stringListBorrowFree);
     if(!resultList){
         eurovisionDestroy(eurovision);
         return NULL;
     }
-    int numOfJudges = mapGetSize(eurovision->judges);
-    int numOfStates = mapGetSize(eurovision->states);
-    if(numOfStates<=0) return resultList;
-    double *scores[NUM_OF_PARAMETERS] = {0};
-    List statesList = listCreate(stateListCopy, stateListFree);
-    if(!statesList){
+    if(runRankingToList(eurovision, audiencePercent, true, ALL_STATES,
+                        resultList)!=EUROVISION_SUCCESS){
         listDestroy(resultList);
-        listDestroy(statesList);
         eurovisionDestroy(eurovision);
         return NULL;
     }
-    if(initiateScoreArr(scores,numOfStates)!=EUROVISION_SUCCESS) {
-        listDestroy(resultList);
-        listDestroy(statesList);
-        eurovisionDestroy(eurovision);
+    return resultList;
+}
+
+List eurovisionRunContestRange(Eurovision eurovision, int audiencePercent,
+                               int minStateId, int maxStateId){
+    if(!eurovision) return NULL;
+    if(audiencePercent<1||audiencePercent>100){
         return NULL;
     }
-    calculateAudienceScore(eurovision->states, scores);
-    MAP_FOREACH(int*, stateIdIter, eurovision->judges){
-        Judge tmpJudge = (Judge)mapGet(eurovision->judges, stateIdIter);
-        int* tmpJudgeResults = judgeGetResults(tmpJudge);
-        feedScoreTo(JUDGES_SCORE,scores, numOfStates,
-                    tmpJudgeResults, NUM_OF_JUDGE_RESULTS);
-    }
-    for(int i=0; i<numOfStates; i++){
-        int stateId = *(scores[STATE_ID]+i);
-        State tmpState = (State)mapGet(eurovision->states, &stateId);
-        double audienceP = (double)audiencePercent/100;
-        double audienceScore = *(scores[AUDIENCE_SCORE]+i);
-        audienceScore = (numOfStates>0)?
-                audienceScore/numOfStates : audienceScore;
-        double judgesScore = *(scores[JUDGES_SCORE]+i);
-        judgesScore = (numOfJudges>0)?
-                        judgesScore/numOfJudges : judgesScore;
-        double totalScore = (audienceScore*audienceP)+
-                            (judgesScore*(1-audienceP));
-        if(totalScore<10e-20) {
-            totalScore = 0;
-        }
-        stateSetScore(tmpState, totalScore);
-        listInsertLast(statesList, tmpState);
-    }
-    listSort(statesList, stateListCompareFinalScore);
-    LIST_FOREACH(State, tmpState, statesList){
-        listInsertLast(resultList, stateGetName(tmpState));
+    List resultList = listCreate(stringListBorrow, stringListBorrowFree);
+    if(!resultList){
+        eurovisionDestroy(eurovision);
+        return NULL;
     }
-    for(int i=0; i<NUM_OF_PARAMETERS; i++){
-        free(scores[i]);
+    StateRange range = {minStateId, maxStateId};
+    if(runRankingToList(eurovision, audiencePercent, true, range,
+                        resultList)!=EUROVISION_SUCCESS){
+        listDestroy(resultList);
+        eurovisionDestroy(eurovision);
+        return NULL;
     }
-    listDestroy(statesList);
     return resultList;
 }
 
 List eurovisionRunAudienceFavorite(Eurovision eurovision){
     if(!eurovision) return NULL;
-    List resultList = listCreate(stringListCopy, stringListFree);
+    List resultList = listCreate(stringListBorrow, stringListBorrowFree);
     if(!resultList){
-        listDestroy(resultList);
         eurovisionDestroy(eurovision);
         return NULL;
     }
-    int numOfStates = mapGetSize(eurovision->states);
-    if(numOfStates<=0) return resultList;
-    double* scores[2] ={0};
-    int i;
-    List statesList = listCreate(stateListCopy, stateListFree);
-    if(!statesList){
+    if(runRankingToList(eurovision, 100, false, ALL_STATES,
+                        resultList)!=EUROVISION_SUCCESS){
         listDestroy(resultList);
-        listDestroy(statesList);
         eurovisionDestroy(eurovision);
         return NULL;
     }
-    for(i = 0; i<2; i++) {
-        scores[i] = malloc(sizeof(double) * numOfStates);
-        if (!scores[i]) {
+    return resultList;
+}
 
-            for(;i<=0 ;i--){
-                free(scores[i]);
-            }
-            listDestroy(statesList);
-            listDestroy(resultList);
-            eurovisionDestroy(eurovision);
-            return NULL;
-        }
+EurovisionResult eurovisionRunContestInto(Eurovision eurovision,
+                                          int audiencePercent,
+                                          RankingResult ranking){
+    if(!eurovision||!ranking) return EUROVISION_NULL_ARGUMENT;
+    if(audiencePercent<1||audiencePercent>100){
+        return EUROVISION_INVALID_PERCENT;
     }
-    for(i=0; i<numOfStates; i++){
-        *(scores[AUDIENCE_SCORE]+i) = 0;
+    EurovisionResult result = runRankingToResult(eurovision, audiencePercent,
+                                                 true, ranking);
+    if(result==EUROVISION_OUT_OF_MEMORY){
+        eurovisionDestroy(eurovision);
     }
-    calculateAudienceScore(eurovision->states, scores);
-    for(i=0; i<numOfStates; i++){
-        int stateId = *(scores[STATE_ID]+i);
-        State tmpState = (State)mapGet(eurovision->states, &stateId);
-        double audienceScore = *(scores[AUDIENCE_SCORE]+i)/numOfStates;
-        if(audienceScore<10e-20) {
-            audienceScore = 0;
-        }
-        stateSetScore(tmpState, audienceScore);
-        listInsertFirst(statesList, tmpState);
+    return result;
+}
+
+EurovisionResult eurovisionRunAudienceFavoriteInto(Eurovision eurovision,
+                                                   RankingResult ranking){
+    if(!eurovision||!ranking) return EUROVISION_NULL_ARGUMENT;
+    EurovisionResult result = runRankingToResult(eurovision, 100, false,
+                                                 ranking);
+    if(result==EUROVISION_OUT_OF_MEMORY){
+        eurovisionDestroy(eurovision);
     }
-    listSort(statesList, stateListCompareFinalScore);
-    LIST_FOREACH(State, tmpState, statesList){
-        char *stateName = stateGetName(tmpState);
-        listInsertLast(resultList, stateName);
+    return result;
+}
+
+int countGraphVotes(State state){
+    Map votes = stateGetCitizenVotes(state);
+    if(votes) return mapGetSize(votes);
+    int topStates[NUM_OF_TOP_VOTES];
+    return stateGetTopVotes(state, topStates, NULL);
+}
+
+EurovisionResult buildVoteGraph(Eurovision eurovision, VoteGraph *graph,
+                                Allocator allocator){
+    int numOfStates = stateTableGetSize(eurovision->states);
+    const int *ids = stateTableGetIds(eurovision->states);
+    State *states = stateTableGetStates(eurovision->states);
+    int numOfVotes = 0;
+    for(int i=0; i<numOfStates; i++){
+        numOfVotes += countGraphVotes(states[i]);
+    }
+    size_t statesSize = sizeof(int)*(numOfStates+1);
+    size_t votesSize = sizeof(int)*(numOfVotes+1);
+    VoteGraph filled = {numOfStates, 0,
+                        RESULT_ALLOCATE(allocator, statesSize),
+                        RESULT_ALLOCATE(allocator, statesSize),
+                        RESULT_ALLOCATE(allocator, votesSize),
+                        RESULT_ALLOCATE(allocator, votesSize)};
+    *graph = filled;
+    if(!graph->ids||!graph->voteStarts||!graph->takers||!graph->counts){
+        clearVoteGraph(graph, allocator);
+        return EUROVISION_OUT_OF_MEMORY;
     }
-    for(i = 0; i<2; i++){
-        free(scores[i]);
+    if(numOfStates>0){
+        memcpy(graph->ids, ids, sizeof(int)*numOfStates);
     }
-    listDestroy(statesList);
-    return resultList;
+    numOfVotes = 0;
+    for(int i=0; i<numOfStates; i++){
+        graph->voteStarts[i] = numOfVotes;
+        Map votes = stateGetCitizenVotes(states[i]);
+        if(!votes){
+            int topStates[NUM_OF_TOP_VOTES], topVotes[NUM_OF_TOP_VOTES];
+            int numOfTopVotes = stateGetTopVotes(states[i], topStates,
+                                                 topVotes);
+            for(int j=0; j<numOfTopVotes; j++){
+                int index = findStateIndex(ids, numOfStates, topStates[j]);
+                if(index<0) continue;
+                graph->takers[numOfVotes] = index;
+                graph->counts[numOfVotes++] = topVotes[j];
+            }
+            continue;
+        }
+        MapCursor cursor;
+        MAP_FOREACH_CURSOR(int*, takerId, votes, cursor){
+            int index = findStateIndex(ids, numOfStates, *takerId);
+            if(index<0) continue;
+            graph->takers[numOfVotes] = index;
+            graph->counts[numOfVotes++] =
+                    *(int*)mapCursorGetData(votes, &cursor);
+        }
+    }
+    graph->voteStarts[numOfStates] = numOfVotes;
+    graph->numOfVotes = numOfVotes;
+    return EUROVISION_SUCCESS;
 }
 
-int findFavoriteStateId(State state){
-    if(!state) return -1;
-    Map citizensVotes = stateGetCitizenVotes(state);
-    if(mapGetSize(citizensVotes)<=0) return -1;
-    int *favoriteStates = transformAudienceScoreToArr(citizensVotes);
-    int favoriteStateId = *favoriteStates;
-    free(favoriteStates);
-    return favoriteStateId;
+void clearVoteGraph(VoteGraph *graph, Allocator allocator){
+    RESULT_FREE(allocator, graph->ids);
+    RESULT_FREE(allocator, graph->voteStarts);
+    RESULT_FREE(allocator, graph->takers);
+    RESULT_FREE(allocator, graph->counts);
+    VoteGraph cleared = {0, 0, NULL, NULL, NULL, NULL};
+    *graph = cleared;
 }
 
-bool statesSortedListIdentical(List statesList1, List statesList2){
-    if(!statesList1) return false;
-    if(!statesList2) return false;
-    int stateId1 = stateGetId((State)listGetFirst(statesList1));
-    int stateId2 = stateGetId((State)listGetFirst(statesList2));
-    if(stateId1==stateId2) return true;
-    return false;
+EurovisionResult buildSimulationContest(Eurovision eurovision,
+                                        const VoteGraph *graph,
+                                        SimulationContest *contest){
+    int numOfStates = graph->numOfStates;
+    double *judges = RESULT_ALLOCATE(eurovision->allocator,
+                                     sizeof(double)*(numOfStates+1));
+    if(!judges) return EUROVISION_OUT_OF_MEMORY;
+    for(int i=0; i<numOfStates; i++){
+        judges[i] = 0;
+    }
+    TYPED_MAP_FOREACH(JudgeMap, judgeEntry, eurovision->judges){
+        feedScoreTo(judges, graph->ids, numOfStates,
+                    judgeGetResults(judgeEntry->data), NUM_OF_JUDGE_RESULTS);
+    }
+    SimulationContest filled = {numOfStates, graph->ids, graph->voteStarts,
+                                graph->takers, graph->counts, judges,
+                                judgeMapGetSize(eurovision->judges)};
+    *contest = filled;
+    return EUROVISION_SUCCESS;
 }
 
-bool arrContainStatesList(List *friendlyStatesArr, int size,
-                          List friendlyStates){
-    if(!friendlyStatesArr) return false;
-    if(!friendlyStates) return false;
-    for(int i=0; i<size; i++){
-        List current = *(friendlyStatesArr+i);
-        if(!current) return false;
-        if(statesSortedListIdentical(current, friendlyStates)){
-            return true;
-        }
+EurovisionResult eurovisionSimulate(Eurovision eurovision,
+                                    int audiencePercent, int trials,
+                                    SimulationNoise noise,
+                                    unsigned long long seed,
+                                    SimulationOutcome *outcome){
+    if(!eurovision||!outcome) return EUROVISION_NULL_ARGUMENT;
+    if(audiencePercent<1||audiencePercent>100){
+        return EUROVISION_INVALID_PERCENT;
     }
-    return false;
+    if(trials<=0||!(noise.scale>=0)) return EUROVISION_INVALID_ARGUMENT;
+    VoteGraph graph;
+    SimulationContest contest;
+    if(buildVoteGraph(eurovision, &graph,
+                      eurovision->allocator)!=EUROVISION_SUCCESS){
+        eurovisionDestroy(eurovision);
+        return EUROVISION_OUT_OF_MEMORY;
+    }
+    if(buildSimulationContest(eurovision, &graph,
+                              &contest)!=EUROVISION_SUCCESS){
+        clearVoteGraph(&graph, eurovision->allocator);
+        eurovisionDestroy(eurovision);
+        return EUROVISION_OUT_OF_MEMORY;
+    }
+    SimulationResult result = simulationRun(&contest, audiencePercent, trials,
+                                            noise, seed, outcome);
+    RESULT_FREE(eurovision->allocator, (double*)contest.judges);
+    clearVoteGraph(&graph, eurovision->allocator);
+    if(result!=SIMULATION_SUCCESS){
+        eurovisionDestroy(eurovision);
+        return EUROVISION_OUT_OF_MEMORY;
+    }
+    return EUROVISION_SUCCESS;
 }
 
-List convertStatesArrToStrList(List *friendlyStatesArr, int size){
-    if(!friendlyStatesArr) {
-        return NULL;
+int findStateIndex(const int *ids, int size, int stateId){
+    int low = 0, high = size-1;
+    while(low<=high){
+        int middle = low+(high-low)/2;
+        if(ids[middle]==stateId) return middle;
+        if(ids[middle]<stateId){
+            low = middle+1;
+        }
+        else{
+            high = middle-1;
+        }
     }
-    List friendlyStatesNames = listCreate(stringListCopy, stringListFree);
-    if(!friendlyStatesNames) {
+    return -1;
+}
 
-        return NULL;
+char* createFriendlyStatesStr(State state1, State state2,
+                              Allocator allocator){
+    if(stateListCompareName(state1, state2)>0){
+        State tmp = state1;
+        state1 = state2;
+        state2 = tmp;
     }
-    if(size==0) return friendlyStatesNames;
     char *spaceStr = " - ";
-    for(int i=0; i<size; i++){
-        List currentPair = *(friendlyStatesArr+i);
-        State state1 = listGetFirst(currentPair);
-        if(!state1){
-            listDestroy(friendlyStatesNames);
-            return NULL;
-        }
-        State state2 = listGetNext(currentPair);
-        if(!state2) {
-            listDestroy(friendlyStatesNames);
-            return NULL;
-        }
-        char *stateName1 = stateGetName(state1);
-        char *stateName2 = stateGetName(state2);
-        int strSize = (int)strlen(stateName1)+
-                      (int)strlen(stateName2)+
-                      (int)strlen(spaceStr)
-                      +1;
-        char *resultStr = malloc(sizeof(char)*strSize);
-        if(!resultStr) {
-            free(resultStr);
-            listDestroy(friendlyStatesNames);
-            return NULL;
-        }
-        *resultStr = '\0';
-        strcat(resultStr, stateName1);
-        strcat(resultStr, spaceStr);
-        strcat(resultStr, stateName2);
-        listInsertFirst(friendlyStatesNames, resultStr);
-        free(resultStr);
-    }
-    return friendlyStatesNames;
+    char *stateName1 = stateGetName(state1);
+    char *stateName2 = stateGetName(state2);
+    int strSize = (int)strlen(stateName1)+
+                  (int)strlen(stateName2)+
+                  (int)strlen(spaceStr)
+                  +1;
+    char *resultStr = RESULT_ALLOCATE(allocator, sizeof(char)*strSize);
+    if(!resultStr) return NULL;
+    *resultStr = '\0';
+    strcat(resultStr, stateName1);
+    strcat(resultStr, spaceStr);
+    strcat(resultStr, stateName2);
+    return resultStr;
+}
+
+char* createVotingBlocStr(char **names, int numOfNames, Allocator allocator){
+    char *spaceStr = " - ";
+    int strSize = 1;
+    for(int i=0; i<numOfNames; i++){
+        strSize += (int)strlen(names[i])+(i>0 ? (int)strlen(spaceStr) : 0);
+    }
+    char *resultStr = RESULT_ALLOCATE(allocator, sizeof(char)*strSize);
+    if(!resultStr) return NULL;
+    *resultStr = '\0';
+    for(int i=0; i<numOfNames; i++){
+        if(i>0) strcat(resultStr, spaceStr);
+        strcat(resultStr, names[i]);
+    }
+    return resultStr;
+}
+
+int stringQsortCompare(const void *str1, const void *str2){
+    return stringListCompare(*(char* const*)str1, *(char* const*)str2);
 }
 
 List eurovisionRunGetFriendlyStates(Eurovision eurovision){
     if(!eurovision) return NULL;
-    int numOfStates = mapGetSize(eurovision->states);
-    int arrSize = 0;
+    int numOfStates = stateTableGetSize(eurovision->states);
     List resultList = listCreate(stringListCopy, stringListFree);
     if(!resultList){
-        listDestroy(resultList);
         eurovisionDestroy(eurovision);
         return NULL;
     }
     if(numOfStates==0) return resultList;
-    listDestroy(resultList);
-    List *friendlyStatesArr = malloc(sizeof(List)*((numOfStates/2)+1));
-    if(!friendlyStatesArr) {
-        free(friendlyStatesArr);
+    Allocator allocator = eurovision->allocator;
+    const int *ids = stateTableGetIds(eurovision->states);
+    State *states = stateTableGetStates(eurovision->states);
+    int *favorites = RESULT_ALLOCATE(allocator, sizeof(int)*numOfStates);
+    char **friendlyStates = RESULT_ALLOCATE(allocator, sizeof(char*)*
+                                                       ((numOfStates/2)+1));
+    if(!favorites||!friendlyStates){
+        RESULT_FREE(allocator, favorites);
+        RESULT_FREE(allocator, friendlyStates);
         listDestroy(resultList);
         eurovisionDestroy(eurovision);
         return NULL;
     }
-    int i=0;
-    MAP_FOREACH(int*, stateIdIter, eurovision->states){
-        List friendlyStates = listCreate(stateListCopy, stateListFree);
-        if(!friendlyStates){
-            listDestroy(friendlyStates);
-            free(friendlyStatesArr);
-            listDestroy(resultList);
-            eurovisionDestroy(eurovision);
-            return NULL;
-        }
-        State state1 = mapGet(eurovision->states, stateIdIter);
-        int favoriteStateId = findFavoriteStateId(state1);
-        State state2 = mapGet(eurovision->states, &favoriteStateId);
-        if(findFavoriteStateId(state2)==*stateIdIter){
-            listInsertFirst(friendlyStates, state1);
-            listInsertFirst(friendlyStates, state2);
-            listSort(friendlyStates, stateListCompareName);
-            if(!arrContainStatesList(friendlyStatesArr, arrSize,
-                                     friendlyStates)){
-                *(friendlyStatesArr+i) = listCopy(friendlyStates);
-                i++;
-                arrSize++;
+    int i;
+    for(i=0; i<numOfStates; i++){
+        favorites[i] = findStateIndex(ids, numOfStates,
+                                      findFavoriteStateId(eurovision,
+                                                          states[i]));
+    }
+    int numOfPairs = 0;
+    bool outOfMemory = false;
+    for(i=0; i<numOfStates && !outOfMemory; i++){
+        int favorite = favorites[i];
+        if(favorite>i && favorites[favorite]==i){
+            friendlyStates[numOfPairs] =
+                    createFriendlyStatesStr(states[i], states[favorite],
+                                            allocator);
+            if(!friendlyStates[numOfPairs]){
+                outOfMemory = true;
+                break;
             }
+            numOfPairs++;
+        }
+    }
+    qsort(friendlyStates, numOfPairs, sizeof(char*), stringQsortCompare);
+    for(i=0; i<numOfPairs; i++){
+        if(!outOfMemory &&
+           listInsertLast(resultList, friendlyStates[i])!=LIST_SUCCESS){
+            outOfMemory = true;
         }
-        listDestroy(friendlyStates);
+        RESULT_FREE(allocator, friendlyStates[i]);
     }
-    resultList = convertStatesArrToStrList(friendlyStatesArr, arrSize);
-    if(resultList == NULL){
-        free(friendlyStatesArr);
+    RESULT_FREE(allocator, favorites);
+    RESULT_FREE(allocator, friendlyStates);
+    if(outOfMemory){
         listDestroy(resultList);
         eurovisionDestroy(eurovision);
         return NULL;
     }
-    listSort(resultList, stringListCompare);
-    for(i=0; i<arrSize; i++){
-        listDestroy(*(friendlyStatesArr+i));
+    return resultList;
+}
+
+EurovisionResult eurovisionGetVoteGraph(Eurovision eurovision,
+                                        VoteGraph *graph){
+    if(!eurovision||!graph) return EUROVISION_NULL_ARGUMENT;
+    /* the caller clears the graph with voteGraphClear, so it is malloced */
+    if(buildVoteGraph(eurovision, graph, NULL)!=EUROVISION_SUCCESS){
+        eurovisionDestroy(eurovision);
+        return EUROVISION_OUT_OF_MEMORY;
+    }
+    return EUROVISION_SUCCESS;
+}
+
+List eurovisionRunGetVotingBlocs(Eurovision eurovision){
+    if(!eurovision) return NULL;
+    int numOfStates = stateTableGetSize(eurovision->states);
+    List resultList = listCreate(stringListCopy, stringListFree);
+    if(!resultList){
+        eurovisionDestroy(eurovision);
+        return NULL;
+    }
+    if(numOfStates==0) return resultList;
+    Allocator allocator = eurovision->allocator;
+    State *states = stateTableGetStates(eurovision->states);
+    VoteGraph graph = {0, 0, NULL, NULL, NULL, NULL};
+    int *blocs = RESULT_ALLOCATE(allocator, sizeof(int)*numOfStates);
+    int *blocStarts = RESULT_ALLOCATE(allocator, sizeof(int)*
+                                                 (numOfStates+1));
+    char **names = RESULT_ALLOCATE(allocator, sizeof(char*)*numOfStates);
+    char **votingBlocs = RESULT_ALLOCATE(allocator, sizeof(char*)*
+                                                    ((numOfStates/2)+1));
+    int numOfBlocs = 0;
+    bool outOfMemory = !blocs||!blocStarts||!names||!votingBlocs||
+                       buildVoteGraph(eurovision, &graph,
+                                      allocator)!=EUROVISION_SUCCESS||
+                       voteGraphFindBlocs(&graph, blocs, &numOfBlocs,
+                                          allocator)!=VOTE_GRAPH_SUCCESS;
+    clearVoteGraph(&graph, allocator);
+    int i;
+    if(!outOfMemory){
+        /* group the names by bloc, blocStarts[b] ends up at the end of
+         * bloc b, which is the start of bloc b+1 */
+        for(i=0; i<=numOfBlocs; i++){
+            blocStarts[i] = 0;
+        }
+        for(i=0; i<numOfStates; i++){
+            if(blocs[i]>=0) blocStarts[blocs[i]+1]++;
+        }
+        for(i=1; i<=numOfBlocs; i++){
+            blocStarts[i] += blocStarts[i-1];
+        }
+        for(i=0; i<numOfStates; i++){
+            if(blocs[i]>=0){
+                names[blocStarts[blocs[i]]++] = stateGetName(states[i]);
+            }
+        }
+    }
+    int numOfStrs = 0;
+    for(i=0; i<numOfBlocs && !outOfMemory; i++){
+        int start = i>0 ? blocStarts[i-1] : 0;
+        int numOfNames = blocStarts[i]-start;
+        qsort(names+start, numOfNames, sizeof(char*), stringQsortCompare);
+        votingBlocs[numOfStrs] = createVotingBlocStr(names+start, numOfNames,
+                                                     allocator);
+        if(!votingBlocs[numOfStrs]){
+            outOfMemory = true;
+            break;
+        }
+        numOfStrs++;
+    }
+    qsort(votingBlocs, numOfStrs, sizeof(char*), stringQsortCompare);
+    for(i=0; i<numOfStrs; i++){
+        if(!outOfMemory &&
+           listInsertLast(resultList, votingBlocs[i])!=LIST_SUCCESS){
+            outOfMemory = true;
+        }
+        RESULT_FREE(allocator, votingBlocs[i]);
+    }
+    RESULT_FREE(allocator, blocs);
+    RESULT_FREE(allocator, blocStarts);
+    RESULT_FREE(allocator, names);
+    RESULT_FREE(allocator, votingBlocs);
+    if(outOfMemory){
+        listDestroy(resultList);
+        eurovisionDestroy(eurovision);
+        return NULL;
     }
-    free(friendlyStatesArr);
     return resultList;
 }
+
+EurovisionResult eurovisionGetStats(Eurovision eurovision,
+                                    EurovisionStats *stats){
+    if(!eurovision||!stats) return EUROVISION_NULL_ARGUMENT;
+    stateTableGetStats(eurovision->states, &stats->states);
+    judgeMapGetStats(eurovision->judges, &stats->judges);
+#ifdef EUROVISION_STATS
+    PhaseTicks ticks = eurovision->phaseTicks;
+    stats->rankings = ticks.rankings;
+    stats->audienceSeconds = TICKS_TO_SECONDS(ticks.audience);
+    stats->judgesSeconds = TICKS_TO_SECONDS(ticks.judges);
+    stats->combineSeconds = TICKS_TO_SECONDS(ticks.combine);
+    stats->sortSeconds = TICKS_TO_SECONDS(ticks.sort);
+    stats->resultSeconds = TICKS_TO_SECONDS(ticks.result);
+#else
+    stats->rankings = 0;
+    stats->audienceSeconds = 0;
+    stats->judgesSeconds = 0;
+    stats->combineSeconds = 0;
+    stats->sortSeconds = 0;
+    stats->resultSeconds = 0;
+#endif
+    return EUROVISION_SUCCESS;
+}
+
+EurovisionResult eurovisionResetStats(Eurovision eurovision){
+    if(!eurovision) return EUROVISION_NULL_ARGUMENT;
+    stateTableResetStats(eurovision->states);
+    judgeMapResetStats(eurovision->judges);
+#ifdef EUROVISION_STATS
+    eurovision->phaseTicks.rankings = 0;
+    eurovision->phaseTicks.audience = 0;
+    eurovision->phaseTicks.judges = 0;
+    eurovision->phaseTicks.combine = 0;
+    eurovision->phaseTicks.sort = 0;
+    eurovision->phaseTicks.result = 0;
+#endif
+    return EUROVISION_SUCCESS;
+}
+
+EurovisionResult eurovisionMemoryUsage(Eurovision eurovision,
+                                       AllocatorUsage *usage){
+    if(!eurovision||!usage) return EUROVISION_NULL_ARGUMENT;
+    allocatorGetUsage(eurovision->allocator, usage);
+    return EUROVISION_SUCCESS;
+}
+
+EurovisionResult eurovisionSetRankPool(Eurovision eurovision,
+                                       ThreadPool pool){
+    if(!eurovision) return EUROVISION_NULL_ARGUMENT;
+    if(eurovision->ownsRankPool){
+        threadPoolDestroy(eurovision->rankPool);
+    }
+    eurovision->rankPool = pool;
+    eurovision->ownsRankPool = false;
+    eurovision->rankPoolChosen = true;
+    return EUROVISION_SUCCESS;
+}
@@ -2,34 +2,125 @@
 #define EUROVISION_H_
 
 
+#include <stddef.h>
 #include "list.h"
-
+#include "map.h"
+#include "ranking.h"
+#include "allocator.h"
+#include "simulation.h"
+#include "votegraph.h"
+#include "threadpool.h"
+
+/* The values are fixed: new codes are added after the last one, so the
+ * values of the codes of the assignment never change. */
 typedef enum eurovisionResult_t {
-    EUROVISION_NULL_ARGUMENT,
-    EUROVISION_OUT_OF_MEMORY,
-    EUROVISION_INVALID_ID,
-    EUROVISION_INVALID_NAME,
-    EUROVISION_STATE_ALREADY_EXIST,
-    EUROVISION_STATE_NOT_EXIST,
-    EUROVISION_JUDGE_ALREADY_EXIST,
-    EUROVISION_JUDGE_NOT_EXIST,
-    EUROVISION_SAME_STATE,
-    EUROVISION_SUCCESS
+    EUROVISION_NULL_ARGUMENT = 0,
+    EUROVISION_OUT_OF_MEMORY = 1,
+    EUROVISION_INVALID_ID = 2,
+    EUROVISION_INVALID_NAME = 3,
+    EUROVISION_STATE_ALREADY_EXIST = 4,
+    EUROVISION_STATE_NOT_EXIST = 5,
+    EUROVISION_JUDGE_ALREADY_EXIST = 6,
+    EUROVISION_JUDGE_NOT_EXIST = 7,
+    EUROVISION_SAME_STATE = 8,
+    EUROVISION_SUCCESS = 9,
+    EUROVISION_INVALID_PERCENT = 10,
+    EUROVISION_READ_ONLY = 11,
+    EUROVISION_INVALID_ARGUMENT = 12
 } EurovisionResult;
 
 
 typedef struct eurovision_t *Eurovision;
 
+/* count votes of the citizens of the state giver to the state taker */
+typedef struct eurovisionVote_t {
+    int giver;
+    int taker;
+    int count;
+} EurovisionVote;
+
+/* Counters of a eurovision. The map counters are collected when compiled
+ * with MAP_STATS and the ranking phase times (in seconds of processor time,
+ * summed over all the contest and audience favorite runs) when compiled with
+ * EUROVISION_STATS, otherwise they are zero. */
+typedef struct eurovisionStats_t {
+    MapStats states;
+    MapStats judges;
+    long rankings;
+    double audienceSeconds;
+    double judgesSeconds;
+    double combineSeconds;
+    double sortSeconds;
+    double resultSeconds;
+} EurovisionStats;
+
 Eurovision eurovisionCreate();
 
+/* Like eurovisionCreate, but all the memory of the eurovision (maps, states,
+ * judges, names and the buffers of the rankings) comes from hooks (malloc and
+ * free if NULL) and is counted for eurovisionMemoryUsage. If memoryLimit is
+ * not 0, an operation that would need more memory than memoryLimit fails with
+ * EUROVISION_OUT_OF_MEMORY. */
+Eurovision eurovisionCreateWithAllocator(const AllocatorHooks *hooks,
+                                         size_t memoryLimit);
+
 void eurovisionDestroy(Eurovision eurovision);
 
 EurovisionResult eurovisionAddState(Eurovision eurovision, int stateId,
                                     const char *stateName,
                                     const char *songName);
 
+/* Adds numOfStates states at once. Every state is checked like in
+ * eurovisionAddState before any of them is added, so on an error none of
+ * them is added. Two equal ids in stateIds give
+ * EUROVISION_STATE_ALREADY_EXIST. */
+EurovisionResult eurovisionAddStates(Eurovision eurovision,
+                                     const int *stateIds,
+                                     const char **stateNames,
+                                     const char **songNames,
+                                     int numOfStates);
+
+/* Adds the states stateIds of from, with their names and songs but without
+ * their votes, to to in one eurovisionAddStates. Gives
+ * EUROVISION_STATE_NOT_EXIST if one of them is not in from. Allocates only
+ * from the allocator of to, and on EUROVISION_OUT_OF_MEMORY to is destroyed
+ * (from never is). */
+EurovisionResult eurovisionPromoteStates(Eurovision from, Eurovision to,
+                                         const int *stateIds,
+                                         int numOfStates);
+
+/* Like eurovisionPromoteStates with the state stateIds[i] taken from
+ * from[i], so the states of several contests are checked together and
+ * added in one eurovisionAddStates: on an error none of them is added. */
+EurovisionResult eurovisionPromoteStatesFrom(const Eurovision *from,
+                                             Eurovision to,
+                                             const int *stateIds,
+                                             int numOfStates);
+
 EurovisionResult eurovisionRemoveState(Eurovision eurovision, int stateId);
 
+/* Removes numOfStates states at once, with the same result as removing
+ * them one by one with eurovisionRemoveState, in one pass over the judges
+ * and the votes. All the ids are checked before any state is removed, so
+ * on an error none of them is removed. Two equal ids in stateIds give
+ * EUROVISION_STATE_NOT_EXIST. */
+EurovisionResult eurovisionRemoveStates(Eurovision eurovision,
+                                        const int *stateIds,
+                                        int numOfStates);
+
+/* In lazy removal mode eurovisionRemoveState and eurovisionRemoveStates do
+ * not delete the votes of the other states to the removed states, they only
+ * mark their ids dead, and the rankings and friendly states skip the votes to
+ * dead ids. The votes to the dead ids are deleted together by
+ * eurovisionCompact, when compactThreshold (if positive) ids are dead, when
+ * a dead id is added again or when lazy removal is turned off. The results
+ * are the same as without lazy removal. The judges that voted to a removed
+ * state are still removed with it. */
+EurovisionResult eurovisionSetLazyRemoval(Eurovision eurovision, bool lazy,
+                                          int compactThreshold);
+
+EurovisionResult eurovisionCompact(Eurovision eurovision);
+
 EurovisionResult eurovisionAddJudge(Eurovision eurovision, int judgeId,
                                     const char *judgeName,
                                     int *judgeResults);
@@ -42,10 +133,109 @@ EurovisionResult eurovisionAddVote(Eurovision eurovision, int stateGiver,
 EurovisionResult eurovisionRemoveVote(Eurovision eurovision, int stateGiver,
                                       int stateTaker);
 
+/* Adds a batch of numOfVotes votes, for vote sources that cannot be
+ * answered one vote at a time. Every vote eurovisionAddVote would refuse
+ * (and every vote with a count that is not positive, or that would take
+ * the votes of its giver to its taker past INT_MAX) is skipped and counted
+ * in numOfSkipped (if not NULL), the other votes are added. Gives
+ * EUROVISION_SUCCESS even if votes were skipped. */
+EurovisionResult eurovisionAddVotes(Eurovision eurovision,
+                                    const EurovisionVote *votes,
+                                    int numOfVotes, int *numOfSkipped);
+
+/* Adds all the votes of shard (a contest that got another part of the
+ * votes) to eurovision, merging the votes of each state in one pass. Every
+ * state of shard must be in eurovision, otherwise gives
+ * EUROVISION_STATE_NOT_EXIST and nothing is merged. A merged count that
+ * would pass INT_MAX is kept at INT_MAX. shard is not changed. */
+EurovisionResult eurovisionMergeVotes(Eurovision eurovision,
+                                     Eurovision shard);
+
+/* Returns a read only copy of the eurovision as it is now. The snapshot has
+ * the states with their cached top votes but not their citizen votes, so it
+ * is made in O(states + judges) and every ranking (eurovisionRun*) of it
+ * gives the same result as the eurovision at the time of the snapshot.
+ * It shares no memory with the eurovision (it allocates with malloc and
+ * free), so it can be ranked on another thread while the eurovision keeps
+ * changing, and it can be destroyed before or after the eurovision. Changing
+ * a snapshot gives EUROVISION_READ_ONLY. On an allocation error NULL is
+ * returned and the eurovision is not changed. */
+Eurovision eurovisionSnapshot(Eurovision eurovision);
+
+/* The names in the lists returned by eurovisionRunContest and
+ * eurovisionRunAudienceFavorite are borrowed from the eurovision and stay
+ * valid until it is destroyed. */
 List eurovisionRunContest(Eurovision eurovision, int audiencePercent);
 
+/* Ranks only the states with ids from minStateId to maxStateId (a region),
+ * by their scores in the whole contest: every state still votes, but the
+ * other states are not scored or ranked. */
+List eurovisionRunContestRange(Eurovision eurovision, int audiencePercent,
+                               int minStateId, int maxStateId);
+
 List eurovisionRunAudienceFavorite(Eurovision eurovision);
 
 List eurovisionRunGetFriendlyStates(Eurovision eurovision);
 
+/* The groups of states that exchange points with each other (see
+ * votegraph.h), a generalization of eurovisionRunGetFriendlyStates to more
+ * than two states. Every bloc is one string of the names of its states,
+ * sorted and separated by " - ", and the list is sorted. */
+List eurovisionRunGetVotingBlocs(Eurovision eurovision);
+
+/* Export the citizen votes of every state as a vote graph in compressed
+ * sparse row form (see votegraph.h), built in one pass over the votes. The
+ * votes to removed states are left out, and a snapshot only has the top ten
+ * votes of every state. The graph is allocated with malloc, outside the
+ * memory limit of the eurovision, and the caller clears it with
+ * voteGraphClear. */
+EurovisionResult eurovisionGetVoteGraph(Eurovision eurovision,
+                                        VoteGraph *graph);
+
+/* Same rankings as eurovisionRunContest and eurovisionRunAudienceFavorite,
+ * written into a reusable RankingResult (cleared first) instead of a new
+ * List. */
+EurovisionResult eurovisionRunContestInto(Eurovision eurovision,
+                                          int audiencePercent,
+                                          RankingResult ranking);
+
+EurovisionResult eurovisionRunAudienceFavoriteInto(Eurovision eurovision,
+                                                   RankingResult ranking);
+
+/* The rankings of 65536 states or more are sorted in parallel (see
+ * scoreRankParallel). By default the eurovision starts its own pool of one
+ * thread per processor on its first such ranking, if there is more than one
+ * processor. This sets the pool to sort on instead, NULL to sort on the
+ * calling thread. The pool is not owned: it must outlive the eurovision (or
+ * be replaced first), and it must not be the pool the ranking runs on. */
+EurovisionResult eurovisionSetRankPool(Eurovision eurovision,
+                                       ThreadPool pool);
+
+/* Run the contest trials times with noise on every citizen votes count (see
+ * simulation.h) and set outcome to how often every state finished at every
+ * place, simulationGetProbability(outcome, id, 0) is the chance of the state
+ * id to win. The trials run on all the processors and depend only on seed.
+ * Works on snapshots too, with the top ten votes of every state. A negative
+ * noise scale or trials that is not positive gives
+ * EUROVISION_INVALID_ARGUMENT. The caller clears outcome with
+ * simulationOutcomeClear. */
+EurovisionResult eurovisionSimulate(Eurovision eurovision,
+                                    int audiencePercent, int trials,
+                                    SimulationNoise noise,
+                                    unsigned long long seed,
+                                    SimulationOutcome *outcome);
+
+EurovisionResult eurovisionGetStats(Eurovision eurovision,
+                                    EurovisionStats *stats);
+
+EurovisionResult eurovisionResetStats(Eurovision eurovision);
+
+/* The bytes the eurovision uses now by category, the peak of the total and
+ * the limit it was created with. The lists, graphs and outcomes returned by
+ * the eurovision are not counted, and neither are the per thread buffers of
+ * the simulation trials (see simulation.h). The work arrays of the bloc
+ * search are counted as results. */
+EurovisionResult eurovisionMemoryUsage(Eurovision eurovision,
+                                       AllocatorUsage *usage);
+
 #endif /* EUROVISION_H_ */
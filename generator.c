@@ -0,0 +1,176 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "generator.h"
+#include "judge.h"
+
+#define NAME_LETTERS 26
+#define MAX_NAME 32
+
+struct Generator_t{
+    GeneratorConfig config;
+    unsigned long long state;
+    double *takerCdf;
+    int *judgeStates;
+};
+
+/** return a uniform double in [0, 1) */
+double generatorUniform(Generator generator);
+
+/** write "prefix" followed by the letters encoding of number to name */
+void generatorName(const char *prefix, int number, char *name, int size);
+
+/** add the generated states to eurovision with one eurovisionAddStates */
+EurovisionResult generatorAddStates(int numOfStates, Eurovision eurovision);
+
+Generator generatorCreate(GeneratorConfig config){
+    if(config.numOfStates<2||config.numOfJudges<0||config.numOfVotes<0||
+       config.voteSkew<0){
+        return NULL;
+    }
+    Generator generator = malloc(sizeof(*generator));
+    if(!generator) return NULL;
+    generator->config = config;
+    generator->state = config.seed;
+    generator->takerCdf = malloc(sizeof(double)*config.numOfStates);
+    generator->judgeStates = malloc(sizeof(int)*config.numOfStates);
+    if(!generator->takerCdf||!generator->judgeStates){
+        generatorDestroy(generator);
+        return NULL;
+    }
+    for(int i=0; i<config.numOfStates; i++){
+        generator->judgeStates[i] = i;
+    }
+    double sum = 0;
+    for(int i=0; i<config.numOfStates; i++){
+        sum += 1/pow(i+1, config.voteSkew);
+        generator->takerCdf[i] = sum;
+    }
+    for(int i=0; i<config.numOfStates; i++){
+        generator->takerCdf[i] /= sum;
+    }
+    return generator;
+}
+
+void generatorDestroy(Generator generator){
+    if(!generator) return;
+    free(generator->takerCdf);
+    free(generator->judgeStates);
+    free(generator);
+}
+
+unsigned long long generatorRandom(Generator generator){
+    unsigned long long z = (generator->state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+double generatorUniform(Generator generator){
+    return (generatorRandom(generator) >> 11) * (1.0/9007199254740992.0);
+}
+
+void generatorNextVote(Generator generator, int *giver, int *taker){
+    int numOfStates = generator->config.numOfStates;
+    *giver = (int)(generatorRandom(generator) % numOfStates);
+    do{
+        double uniform = generatorUniform(generator);
+        int low = 0, high = numOfStates-1;
+        while(low<high){
+            int middle = low+(high-low)/2;
+            if(generator->takerCdf[middle] < uniform){
+                low = middle+1;
+            }
+            else{
+                high = middle;
+            }
+        }
+        *taker = low;
+    } while(*taker == *giver);
+}
+
+void generatorName(const char *prefix, int number, char *name, int size){
+    char letters[MAX_NAME];
+    int length = 0;
+    do{
+        letters[length++] = (char)('a'+number%NAME_LETTERS);
+        number /= NAME_LETTERS;
+    } while(number>0 && length<MAX_NAME-1);
+    int written = snprintf(name, size, "%s", prefix);
+    for(int i=length-1; i>=0 && written<size-1; i--){
+        name[written++] = letters[i];
+    }
+    name[written] = '\0';
+}
+
+void generatorStateName(int stateId, char *name, int size){
+    generatorName("state ", stateId, name, size);
+}
+
+void generatorJudgeName(int judgeId, char *name, int size){
+    generatorName("judge ", judgeId, name, size);
+}
+
+bool generatorNextJudge(Generator generator,
+                        int judgeResults[NUM_OF_JUDGE_RESULTS]){
+    int numOfStates = generator->config.numOfStates;
+    if(numOfStates<NUM_OF_JUDGE_RESULTS) return false;
+    int *states = generator->judgeStates;
+    for(int i=0; i<NUM_OF_JUDGE_RESULTS; i++){
+        int j = i+(int)(generatorRandom(generator)%(numOfStates-i));
+        int tmp = states[i];
+        states[i] = states[j];
+        states[j] = tmp;
+        judgeResults[i] = states[i];
+    }
+    return true;
+}
+
+EurovisionResult generatorAddStates(int numOfStates, Eurovision eurovision){
+    int *ids = malloc(sizeof(int)*numOfStates);
+    char *names = malloc(sizeof(char)*MAX_NAME*numOfStates);
+    const char **stateNames = malloc(sizeof(char*)*numOfStates);
+    const char **songNames = malloc(sizeof(char*)*numOfStates);
+    EurovisionResult result = EUROVISION_OUT_OF_MEMORY;
+    if(ids&&names&&stateNames&&songNames){
+        for(int i=0; i<numOfStates; i++){
+            ids[i] = i;
+            generatorStateName(i, names+i*MAX_NAME, MAX_NAME);
+            stateNames[i] = names+i*MAX_NAME;
+            songNames[i] = "song";
+        }
+        result = eurovisionAddStates(eurovision, ids, stateNames, songNames,
+                                     numOfStates);
+    }
+    else{
+        eurovisionDestroy(eurovision);
+    }
+    free(ids);
+    free(names);
+    free(stateNames);
+    free(songNames);
+    return result;
+}
+
+EurovisionResult generatorFillEurovision(Generator generator,
+                                         Eurovision eurovision){
+    GeneratorConfig config = generator->config;
+    char name[MAX_NAME*2];
+    EurovisionResult result = generatorAddStates(config.numOfStates,
+                                                 eurovision);
+    if(result!=EUROVISION_SUCCESS) return result;
+    int judgeResults[NUM_OF_JUDGE_RESULTS];
+    for(int judge=0; judge<config.numOfJudges &&
+                     generatorNextJudge(generator, judgeResults); judge++){
+        generatorJudgeName(judge, name, sizeof(name));
+        result = eurovisionAddJudge(eurovision, judge, name, judgeResults);
+        if(result!=EUROVISION_SUCCESS) return result;
+    }
+    for(int i=0; i<config.numOfVotes; i++){
+        int giver, taker;
+        generatorNextVote(generator, &giver, &taker);
+        result = eurovisionAddVote(eurovision, giver, taker);
+        if(result!=EUROVISION_SUCCESS) return result;
+    }
+    return EUROVISION_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#ifndef MTM_HW1_EUROVISION_GENERATOR_H
+#define MTM_HW1_EUROVISION_GENERATOR_H
+
+#include <stdbool.h>
+#include "eurovision.h"
+#include "judge.h"
+
+/**
+ * Synthetic Contest Generator
+ *
+ * Produces deterministic contest data for benchmarks: the same config and
+ * seed always give the same states, judges and votes. The vote takers
+ * follow a Zipf distribution so a few states get most of the votes, like
+ * in a real televote.
+ *
+ * The following functions are available:
+ *
+ * generatorCreate         - Allocate a generator for a config.
+ * generatorDestroy        - Deallocate a generator.
+ * generatorRandom         - Return the next pseudo random number.
+ * generatorNextVote       - Return the next (giver, taker) vote.
+ * generatorStateName      - Write the name of a generated state.
+ * generatorJudgeName      - Write the name of a generated judge.
+ * generatorNextJudge      - Draw the results of the next judge.
+ * generatorFillEurovision - Add the generated states, judges and votes to
+ *                           a Eurovision.
+*/
+
+/** Configuration of the generated contest */
+typedef struct GeneratorConfig_t{
+    int numOfStates;
+    int numOfJudges;
+    int numOfVotes;
+    double voteSkew;
+    unsigned long long seed;
+}GeneratorConfig;
+
+/** Type for defining a Generator */
+typedef struct Generator_t *Generator;
+
+/**
+* generatorCreate: Allocates a new generator
+*
+* The generated states have the ids 0 to numOfStates-1. voteSkew is the
+* Zipf exponent of the vote takers, 0 gives uniform votes.
+*
+* @param config - the contest to generate
+* @return
+* 	NULL - if config has less than 2 states, a negative count or skew,
+* 	       or allocations failed.
+* 	A new Generator in case of success.
+*/
+Generator generatorCreate(GeneratorConfig config);
+
+/**
+* generatorDestroy: Deallocate a generator
+*
+* @param generator - the generator to deallocate, if NULL nothing will be done
+*/
+void generatorDestroy(Generator generator);
+
+/**
+* generatorRandom: Return the next number of the generator sequence
+*
+* @param generator - the generator
+* @return
+* 	a pseudo random 64 bit number
+*/
+unsigned long long generatorRandom(Generator generator);
+
+/**
+* generatorNextVote: Draw the next vote, the giver is uniform and the taker
+* follows the configured skew and is never the giver
+*
+* @param generator - the generator
+* @param giver - set to the id of the giving state
+* @param taker - set to the id of the taking state
+*/
+void generatorNextVote(Generator generator, int *giver, int *taker);
+
+/**
+* generatorStateName: Write the name of a generated state, made of lower
+* case letters and spaces only
+*
+* @param stateId - the generated state id
+* @param name - buffer to write the name to
+* @param size - the size of name
+*/
+void generatorStateName(int stateId, char *name, int size);
+
+/**
+* generatorJudgeName: Write the name of a generated judge, made of lower
+* case letters and spaces only
+*
+* @param judgeId - the generated judge id
+* @param name - buffer to write the name to
+* @param size - the size of name
+*/
+void generatorJudgeName(int judgeId, char *name, int size);
+
+/**
+* generatorNextJudge: Draw the results of the next judge, 10 different
+* states. generatorFillEurovision gives its judges the ids 0 to
+* numOfJudges-1 in drawing order.
+*
+* @param generator - the generator
+* @param judgeResults - filled with the state ids of the judge results
+* @return
+* 	false - if the config has less than 10 states, there are no judge
+* 	        results to draw
+* 	true - if judgeResults was filled
+*/
+bool generatorNextJudge(Generator generator,
+                        int judgeResults[NUM_OF_JUDGE_RESULTS]);
+
+/**
+* generatorFillEurovision: Add all the generated states, judges and votes
+* to a Eurovision
+*
+* @param generator - the generator
+* @param eurovision - the eurovision to fill
+* @return
+* 	EUROVISION_SUCCESS if everything was added, the first failure otherwise.
+* 	On EUROVISION_OUT_OF_MEMORY eurovision is destroyed, like in the
+* 	eurovision functions.
+*/
+EurovisionResult generatorFillEurovision(Generator generator,
+                                         Eurovision eurovision);
+
+#endif
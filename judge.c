@@ -6,8 +6,17 @@
 
 
 
+/** allocate a judge from allocator with the given name, the name is
+ *  interned in pool if pool is not NULL, used as is if it is already
+ *  interned and allocated otherwise */
+Judge judgeAllocate(int judgeId, const char* judgeName,
+                    int judgeResults[NUM_OF_JUDGE_RESULTS], StringPool pool,
+                    Allocator allocator, bool interned);
+
 struct Judge_t{
     int id;
+    Allocator allocator;
+    StringPool pool;
     char* name;
     int results[NUM_OF_JUDGE_RESULTS];
 };
@@ -27,33 +36,68 @@ int* judgeGetResults(Judge judge){
     return judge->results;
 }
 
-Judge judgeCreate(int judgeId, const char* judgeName, int judgeResults[NUM_OF_JUDGE_RESULTS]){
-    if(judgeId<0) return NULL;
-    if(!judgeName||!judgeResults) return NULL;
-    Judge newJudge = malloc(sizeof(*newJudge));
+Judge judgeAllocate(int judgeId, const char* judgeName,
+                    int judgeResults[NUM_OF_JUDGE_RESULTS], StringPool pool,
+                    Allocator allocator, bool interned){
+    Judge newJudge = allocatorAllocate(allocator, ALLOCATOR_JUDGES,
+                                       sizeof(*newJudge));
     if(!newJudge) return NULL;
     newJudge ->id = judgeId;
-    newJudge->name = malloc((sizeof(char)*strlen(judgeName))+1);
+    newJudge->allocator = allocator;
+    newJudge->pool = pool;
+    if(interned){
+        newJudge->name = (char*)judgeName;
+    }
+    else if(pool){
+        newJudge->name = stringPoolIntern(pool, judgeName);
+    }
+    else{
+        newJudge->name = allocatorAllocate(allocator, ALLOCATOR_STRINGS,
+                                           (sizeof(char)*strlen(judgeName))+1);
+        if(newJudge->name) {
+            strcpy(newJudge->name,judgeName);
+        }
+    }
     if(!newJudge->name) {
         judgeDestroy(newJudge);
         return NULL;
     }
-    strcpy(newJudge->name,judgeName);
     memcpy(newJudge->results,judgeResults,sizeof(int)*NUM_OF_JUDGE_RESULTS);
     return newJudge;
 }
 
+Judge judgeCreate(int judgeId, const char* judgeName, int judgeResults[NUM_OF_JUDGE_RESULTS]){
+    return judgeCreateInPool(judgeId, judgeName, judgeResults, NULL);
+}
+
+Judge judgeCreateInPool(int judgeId, const char* judgeName,
+                        int judgeResults[NUM_OF_JUDGE_RESULTS],
+                        StringPool pool){
+    return judgeCreateWithAllocator(judgeId, judgeName, judgeResults, pool,
+                                    NULL);
+}
+
+Judge judgeCreateWithAllocator(int judgeId, const char* judgeName,
+                               int judgeResults[NUM_OF_JUDGE_RESULTS],
+                               StringPool pool, Allocator allocator){
+    if(judgeId<0) return NULL;
+    if(!judgeName||!judgeResults) return NULL;
+    return judgeAllocate(judgeId, judgeName, judgeResults, pool, allocator,
+                         false);
+}
+
 Judge judgeCopy(Judge judge){
     if(!judge) return NULL;
-    Judge newJudge = judgeCreate(judge->id, judge->name, judge->results);
-    if(!newJudge) return NULL;
-    return newJudge;
+    return judgeAllocate(judge->id, judge->name, judge->results, judge->pool,
+                         judge->allocator, judge->pool != NULL);
 }
 
 void judgeDestroy(Judge judge){
     if(!judge) return;
-    free(judge->name);
-    free(judge);
+    if(!judge->pool){
+        allocatorFree(judge->allocator, judge->name);
+    }
+    allocatorFree(judge->allocator, judge);
 }
 
 bool judgeVotedToState(Judge judge, int stateId){
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include "map.h"
+#include "stringpool.h"
 
 /**
  * Eurovision Judge ADT
@@ -13,6 +14,9 @@
  * judgeGetId              - Return the Judge Id.
  * judgeGetResult          - Return the judge votes array.
  * judgeCreate             - Allocate a new Judge according to the arguments.
+ * judgeCreateInPool       - Allocate a new Judge with a name interned in a
+ *                           StringPool.
+ * judgeCreateWithAllocator - Allocate a new Judge through an Allocator.
  * judgeCopy               - Return a copy of the Judge send as an argument.
  * judgeDestroy            - Deallocate the Judge send as an argument.
  * judgeVotedToState       - Return true if the Judge as an argument has voted to
@@ -75,6 +79,49 @@ int* judgeGetResults(Judge judge);
 */
 Judge judgeCreate(int judgeId, const char* judgeName, int judgeResults[NUM_OF_JUDGE_RESULTS]);
 
+/**
+* judgeCreateInPool: Allocates a new Eurovision judge that keeps its name
+* in a pool
+*
+* The name is interned in pool instead of being allocated for the judge,
+* copies of the judge share the pooled name and it is not freed with the
+* judge. The pool must outlive the judge and its copies.
+*
+* @param judgeId - the judge id value, most be positive number or 0
+* @param judgeName - the new judge name as a char*
+* @param judgeResults - the new judge results, an array of 10 integers
+* @param pool - the pool to intern the name in, NULL to allocate it like
+*               judgeCreate does.
+* @return
+* 	NULL - if one of the parameters is NULL or allocations failed.
+* 	NULL - if judgeId<0
+* 	A new Judge in case of success.
+*/
+Judge judgeCreateInPool(int judgeId, const char* judgeName,
+                        int judgeResults[NUM_OF_JUDGE_RESULTS],
+                        StringPool pool);
+
+/**
+* judgeCreateWithAllocator: Allocates a new Eurovision judge like
+* judgeCreateInPool, the judge (as ALLOCATOR_JUDGES) and its name when pool
+* is NULL (as ALLOCATOR_STRINGS) are allocated through allocator
+*
+* Copies of the judge use the same allocator, it must outlive them.
+*
+* @param judgeId - the judge id value, most be positive number or 0
+* @param judgeName - the new judge name as a char*
+* @param judgeResults - the new judge results, an array of 10 integers
+* @param pool - the pool to intern the name in, NULL to allocate it.
+* @param allocator - the allocator to use, NULL to use malloc and free.
+* @return
+* 	NULL - if one of the parameters is NULL or allocations failed.
+* 	NULL - if judgeId<0
+* 	A new Judge in case of success.
+*/
+Judge judgeCreateWithAllocator(int judgeId, const char* judgeName,
+                               int judgeResults[NUM_OF_JUDGE_RESULTS],
+                               StringPool pool, Allocator allocator);
+
 /**
 * judgeCopy: Allocates a copy of Eurovision judge
 *
@@ -0,0 +1,356 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "eurovision.h"
+#include "generator.h"
+#include "protocol.h"
+
+#define DEFAULT_SOCKET "/tmp/eurovision.sock"
+#define DEFAULT_STATES 200
+#define DEFAULT_JUDGES 20
+#define DEFAULT_VOTES 200000
+#define DEFAULT_SKEW 1.0
+#define DEFAULT_SEED 1
+#define DEFAULT_PIPELINE 64
+#define DEFAULT_QUERIES 10
+#define MAX_PIPELINE 4096
+#define CONTEST_AUDIENCE_PERCENT 75
+#define MAX_NAME 64
+#define READ_CHUNK 65536
+#define NANO_IN_SECOND 1e9
+#define MICRO_IN_SECOND 1e6
+
+/** Options of one load run */
+typedef struct LoadOptions_t{
+    const char *socketPath;
+    GeneratorConfig config;
+    int pipeline;
+    int queries;
+}LoadOptions;
+
+/** A connection to the server, out holds the requests not written yet and
+ *  in the bytes of the responses not handled yet */
+typedef struct LoadClient_t{
+    int fd;
+    ProtocolBuffer in;
+    ProtocolBuffer out;
+    Generator generator;
+    int pipeline;
+}LoadClient;
+
+/** Result of one phase of the run */
+typedef struct LoadPhase_t{
+    const char *name;
+    int requests;
+    int failures;
+    double seconds;
+    double p50;
+    double p99;
+}LoadPhase;
+
+/** Function appending the request number index of a phase to client->out */
+typedef ProtocolResult (*LoadRequest)(LoadClient *client, int index);
+
+/** return the current monotonic time in seconds */
+double loadNow();
+
+/** parse the command line into options, return false on bad arguments */
+bool loadParseOptions(int argc, char **argv, LoadOptions *options);
+
+/** return a new socket connected to the server at path, -1 on error */
+int loadConnect(const char *path);
+
+/** write all of client->out, return false on error */
+bool loadWrite(LoadClient *client);
+
+/** read what the server sent to client->in, waiting for at least one
+ *  byte, return false on error or if the server closed the connection */
+bool loadRead(LoadClient *client);
+
+/** compare function for doubles for qsort */
+int loadCompareDoubles(const void *n1, const void *n2);
+
+/** send numOfRequests requests made by request with at most
+ *  client->pipeline of them waiting for a response, and fill phase with
+ *  their latencies. Return false on a connection error */
+bool loadRunPhase(LoadClient *client, const char *name, LoadRequest request,
+                  int numOfRequests, LoadPhase *phase);
+
+/** the requests of the phases, the states, judges and votes are the ones
+ *  generatorFillEurovision adds for the same config */
+ProtocolResult loadAddState(LoadClient *client, int index);
+ProtocolResult loadAddJudge(LoadClient *client, int index);
+ProtocolResult loadAddVote(LoadClient *client, int index);
+ProtocolResult loadRunContest(LoadClient *client, int index);
+ProtocolResult loadRunAudienceFavorite(LoadClient *client, int index);
+ProtocolResult loadRunFriendlyStates(LoadClient *client, int index);
+
+/** print one phase result as csv */
+void loadPrint(LoadPhase phase, bool first);
+
+double loadNow(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec+now.tv_nsec/NANO_IN_SECOND;
+}
+
+bool loadParseOptions(int argc, char **argv, LoadOptions *options){
+    options->socketPath = DEFAULT_SOCKET;
+    options->config.numOfStates = DEFAULT_STATES;
+    options->config.numOfJudges = DEFAULT_JUDGES;
+    options->config.numOfVotes = DEFAULT_VOTES;
+    options->config.voteSkew = DEFAULT_SKEW;
+    options->config.seed = DEFAULT_SEED;
+    options->pipeline = DEFAULT_PIPELINE;
+    options->queries = DEFAULT_QUERIES;
+    for(int i=1; i<argc; i++){
+        if(i+1>=argc) return false;
+        char *option = argv[i];
+        char *value = argv[++i];
+        if(strcmp(option, "--socket")==0){
+            options->socketPath = value;
+        }
+        else if(strcmp(option, "--states")==0){
+            options->config.numOfStates = atoi(value);
+        }
+        else if(strcmp(option, "--judges")==0){
+            options->config.numOfJudges = atoi(value);
+        }
+        else if(strcmp(option, "--votes")==0){
+            options->config.numOfVotes = atoi(value);
+        }
+        else if(strcmp(option, "--skew")==0){
+            options->config.voteSkew = atof(value);
+        }
+        else if(strcmp(option, "--seed")==0){
+            options->config.seed = strtoull(value, NULL, 10);
+        }
+        else if(strcmp(option, "--pipeline")==0){
+            options->pipeline = atoi(value);
+        }
+        else if(strcmp(option, "--queries")==0){
+            options->queries = atoi(value);
+        }
+        else{
+            return false;
+        }
+    }
+    if(options->config.numOfStates<NUM_OF_JUDGE_RESULTS){
+        options->config.numOfJudges = 0;
+    }
+    return options->pipeline>0 && options->pipeline<=MAX_PIPELINE &&
+           options->queries>=0;
+}
+
+int loadConnect(const char *path){
+    struct sockaddr_un address;
+    if(strlen(path) >= sizeof(address.sun_path)){
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd<0) return -1;
+    if(connect(fd, (struct sockaddr*)&address, sizeof(address))!=0){
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+bool loadWrite(LoadClient *client){
+    while(protocolBufferGetSize(client->out)>0){
+        ssize_t size = write(client->fd, protocolBufferGetData(client->out),
+                             protocolBufferGetSize(client->out));
+        if(size<0){
+            if(errno==EINTR) continue;
+            return false;
+        }
+        protocolBufferConsume(client->out, (uint32_t)size);
+    }
+    return true;
+}
+
+bool loadRead(LoadClient *client){
+    if(protocolBufferReserve(client->in, READ_CHUNK)!=PROTOCOL_SUCCESS){
+        return false;
+    }
+    uint32_t space;
+    char *data = protocolBufferGetSpace(client->in, &space);
+    ssize_t size;
+    do{
+        size = read(client->fd, data, space);
+    } while(size<0 && errno==EINTR);
+    if(size<=0) return false;
+    protocolBufferCommit(client->in, (uint32_t)size);
+    return true;
+}
+
+int loadCompareDoubles(const void *n1, const void *n2){
+    double first = *(const double*)n1;
+    double second = *(const double*)n2;
+    return (first > second) - (first < second);
+}
+
+bool loadRunPhase(LoadClient *client, const char *name, LoadRequest request,
+                  int numOfRequests, LoadPhase *phase){
+    phase->name = name;
+    phase->requests = numOfRequests;
+    phase->failures = 0;
+    phase->seconds = 0;
+    phase->p50 = 0;
+    phase->p99 = 0;
+    if(numOfRequests<=0) return true;
+    double *sent = malloc(sizeof(double)*numOfRequests);
+    double *latencies = malloc(sizeof(double)*numOfRequests);
+    bool success = sent && latencies;
+    int numOfSent = 0, numOfDone = 0;
+    double start = loadNow();
+    while(success && numOfDone<numOfRequests){
+        int first = numOfSent;
+        while(success && numOfSent<numOfRequests &&
+              numOfSent-numOfDone<client->pipeline){
+            success = request(client, numOfSent++)==PROTOCOL_SUCCESS;
+        }
+        double now = loadNow();
+        for(int i=first; i<numOfSent; i++){
+            sent[i] = now;
+        }
+        success = success && loadWrite(client) && loadRead(client);
+        now = loadNow();
+        ProtocolHeader header;
+        ProtocolReader payload;
+        while(success && protocolNextMessage(client->in, &header,
+                                             &payload)==PROTOCOL_SUCCESS){
+            EurovisionResult result;
+            if(!protocolResultDecode(header.type, &result) ||
+               result!=EUROVISION_SUCCESS){
+                phase->failures++;
+            }
+            latencies[numOfDone] = now-sent[numOfDone];
+            numOfDone++;
+            protocolBufferConsume(client->in,
+                                  sizeof(ProtocolHeader)+header.size);
+        }
+    }
+    phase->seconds = loadNow()-start;
+    if(success){
+        qsort(latencies, numOfRequests, sizeof(double), loadCompareDoubles);
+        phase->p50 = latencies[(numOfRequests-1)*50/100];
+        phase->p99 = latencies[(numOfRequests-1)*99/100];
+    }
+    free(sent);
+    free(latencies);
+    return success;
+}
+
+ProtocolResult loadAddState(LoadClient *client, int index){
+    char name[MAX_NAME];
+    generatorStateName(index, name, sizeof(name));
+    return protocolAppendAddState(client->out, index, name, "song");
+}
+
+ProtocolResult loadAddJudge(LoadClient *client, int index){
+    char name[MAX_NAME];
+    int judgeResults[NUM_OF_JUDGE_RESULTS];
+    if(!generatorNextJudge(client->generator, judgeResults)){
+        return PROTOCOL_BAD_MESSAGE;
+    }
+    generatorJudgeName(index, name, sizeof(name));
+    return protocolAppendAddJudge(client->out, index, name, judgeResults);
+}
+
+ProtocolResult loadAddVote(LoadClient *client, int index){
+    int giver, taker;
+    generatorNextVote(client->generator, &giver, &taker);
+    int32_t vote[2] = {giver, taker};
+    return protocolAppendMessage(client->out, PROTOCOL_ADD_VOTE, vote, 2);
+}
+
+ProtocolResult loadRunContest(LoadClient *client, int index){
+    int32_t audiencePercent = CONTEST_AUDIENCE_PERCENT;
+    return protocolAppendMessage(client->out, PROTOCOL_RUN_CONTEST,
+                                 &audiencePercent, 1);
+}
+
+ProtocolResult loadRunAudienceFavorite(LoadClient *client, int index){
+    return protocolAppendMessage(client->out, PROTOCOL_RUN_AUDIENCE_FAVORITE,
+                                 NULL, 0);
+}
+
+ProtocolResult loadRunFriendlyStates(LoadClient *client, int index){
+    return protocolAppendMessage(client->out, PROTOCOL_RUN_FRIENDLY_STATES,
+                                 NULL, 0);
+}
+
+void loadPrint(LoadPhase phase, bool first){
+    if(first){
+        printf("phase,requests,failures,seconds,requests_per_sec,"
+               "p50_us,p99_us\n");
+    }
+    double perSecond = phase.seconds>0 ? phase.requests/phase.seconds : 0;
+    printf("%s,%d,%d,%.6f,%.1f,%.1f,%.1f\n", phase.name, phase.requests,
+           phase.failures, phase.seconds, perSecond,
+           phase.p50*MICRO_IN_SECOND, phase.p99*MICRO_IN_SECOND);
+}
+
+int main(int argc, char **argv){
+    LoadOptions options;
+    if(!loadParseOptions(argc, argv, &options)){
+        fprintf(stderr, "usage: %s [--socket PATH] [--states N] "
+                        "[--judges N] [--votes N] [--skew X] [--seed N] "
+                        "[--pipeline N] [--queries N]\n", argv[0]);
+        return 1;
+    }
+    LoadClient client;
+    client.pipeline = options.pipeline;
+    client.generator = generatorCreate(options.config);
+    client.in = protocolBufferCreate();
+    client.out = protocolBufferCreate();
+    client.fd = loadConnect(options.socketPath);
+    if(client.fd<0){
+        perror("eurovision_loadgen");
+    }
+    LoadPhase phases[6];
+    int count = 0;
+    bool success = client.generator && client.in && client.out &&
+                   client.fd>=0;
+    success = success &&
+        loadRunPhase(&client, "add_state", loadAddState,
+                     options.config.numOfStates, phases+count++) &&
+        loadRunPhase(&client, "add_judge", loadAddJudge,
+                     options.config.numOfJudges, phases+count++) &&
+        loadRunPhase(&client, "add_vote", loadAddVote,
+                     options.config.numOfVotes, phases+count++) &&
+        loadRunPhase(&client, "run_contest", loadRunContest,
+                     options.queries, phases+count++) &&
+        loadRunPhase(&client, "run_audience_favorite",
+                     loadRunAudienceFavorite, options.queries,
+                     phases+count++) &&
+        loadRunPhase(&client, "run_get_friendly_states",
+                     loadRunFriendlyStates, options.queries,
+                     phases+count++);
+    if(!success){
+        fprintf(stderr, "eurovision_loadgen: the run failed\n");
+        count = 0;
+    }
+    for(int i=0; i<count; i++){
+        loadPrint(phases[i], i==0);
+    }
+    if(client.fd>=0) close(client.fd);
+    protocolBufferDestroy(client.in);
+    protocolBufferDestroy(client.out);
+    generatorDestroy(client.generator);
+    return success ? 0 : 1;
+}
@@ -1,7 +1,41 @@
+#define _POSIX_C_SOURCE 200809L
 #include "map.h"
+#include <pthread.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
+
+#ifdef MAP_STATS
+/** Add amount to one of the operation counters of the map, the counters are
+ *  not collected while the map is concurrent since readers share them */
+#define MAP_STATS_ADD(map, counter, amount) \
+    ((map)->concurrent ? (void)0 : (void)((map)->stats.counter += (amount)))
+#else
+#define MAP_STATS_ADD(map, counter, amount) ((void)0)
+#endif
+
+/** Compare two keys with the compare function of the map */
+#define MAP_COMPARE(map, key1, key2) \
+    (MAP_STATS_ADD(map, compares, 1), (map)->CompareKeys(key1, key2))
+
+/** Lock a concurrent map for reading or for writing, and unlock it */
+#define MAP_READ_LOCK(map) \
+    ((map)->concurrent ? (void)pthread_rwlock_rdlock(&(map)->lock) : (void)0)
+#define MAP_WRITE_LOCK(map) \
+    ((map)->concurrent ? (void)pthread_rwlock_wrlock(&(map)->lock) : (void)0)
+#define MAP_UNLOCK(map) \
+    ((map)->concurrent ? (void)pthread_rwlock_unlock(&(map)->lock) : (void)0)
+/** Unlock a concurrent map locked for writing, deallocating the retired
+ *  elements no read section can hold any more */
+#define MAP_WRITE_UNLOCK(map) \
+    ((map)->concurrent ? (ReclaimRetiredElements(map), \
+                          (void)pthread_rwlock_unlock(&(map)->lock)) : \
+                         (void)0)
+
+/** The number of epochs elements are retired in, see ReclaimRetiredElements */
+#define MAP_EPOCHS 2
 
 /** Type for defining a linked list map elements */
 typedef struct Element_t {
@@ -10,6 +44,14 @@ typedef struct Element_t {
     struct Element_t* next;
 }*Element;
 
+/** Return a copy of a key (or a data element if isKey is false) of the map,
+ *  made by the map allocator if the map stores it and by the copy function
+ *  otherwise */
+void* MapCopyItem(Map map, void* item, bool isKey);
+
+/** Deallocate a key (or a data element if isKey is false) of the map */
+void MapFreeItem(Map map, void* item, bool isKey);
+
 /** Allocate a new map element according to the parameters */
 Element ElementCreate(Map map,MapKeyElement key, MapDataElement data);
 
@@ -25,33 +67,153 @@ void DestroyAllElements(Map map);
 /** Recursion function to delete all the map element in the map */
 void DestroyAllElementsReq(Map map,Element e);
 
-/** Put the elementToAppend next to the map element send as parameter */
-bool AppendElement(Element element, Element elementToAppend);
+/** Return the element a search for keyElement can start after: the
+ *  iterator position or the finger (the element before the last accessed
+ *  key) if its key is smaller than keyElement, NULL if the search must
+ *  start from the head */
+Element FingerSearchStart(Map map, MapKeyElement keyElement);
+
+/** Return the link (the head or the next of an element) that points to the
+ *  element with keyElement or to where it should be put, compareResult is
+ *  set to 0 if the element is there. The finger is moved to the element
+ *  before the link */
+Element* FindLinkInMap(Map map, MapKeyElement keyElement,
+                       int *compareResult);
 
 /** Find the map element with the specific key and return it  */
 Element FindElementInMap(Map map, MapKeyElement keyElement);
 
+/** Return true if keyElements is sorted in ascending order */
+bool KeysSorted(Map map, MapKeyElement *keyElements, int numOfElements);
+
+/** Merge sorted pairs into the map in one pass */
+MapResult MergeSortedElements(Map map, MapKeyElement *keyElements,
+                              MapDataElement *dataElements,
+                              int numOfElements);
+
+/** Put a pair at or after the link a merge walk reached and move the link
+ *  past it. The data of an existing key is combined by combineDataElements,
+ *  or replaced if it is NULL */
+MapResult MergeElementAt(Map map, Element **link, MapKeyElement key,
+                         MapDataElement data,
+                         combineMapDataElements combineDataElements);
+
+/** Remove the element the link points to from the map and retire it */
+void RemoveElementAt(Map map, Element *link);
+
+/** Deallocate an element that was unlinked from the map. While the map is
+ *  concurrent the element is added to the retired elements of the current
+ *  epoch instead, since read sections may still point to it */
+void RetireElement(Map map, Element e);
+
+/** Deallocate the elements of a list of retired elements and empty it */
+void DestroyElementList(Map map, Element *list);
+
+/** Deallocate all the retired elements of the map */
+void DestroyRetiredElements(Map map);
+
+/** Deallocate the retired elements of the previous epoch if no read
+ *  section of that epoch is open, and start a new epoch. The map must be
+ *  locked for writing */
+void ReclaimRetiredElements(Map map);
+
+/** Replace the data of the element the link points to with a copy of data,
+ *  while the map is concurrent the element is replaced by a new one */
+MapResult ReplaceElementData(Map map, Element *link, MapDataElement data);
+
+/** Remove all the elements of the map */
+void ClearElements(Map map);
+
+/** mapPut without locking the map */
+MapResult PutElement(Map map, MapKeyElement keyElement,
+                     MapDataElement dataElement);
+
+/** mapPutBulk without locking the map, after the arguments were checked */
+MapResult PutSortedElements(Map map, MapKeyElement *keyElements,
+                            MapDataElement *dataElements, int numOfElements);
+
+/** Return the first element with a key equal to or bigger than keyElement */
+Element LowerBoundElement(Map map, MapKeyElement keyElement);
+
+/** Return the element whose next is link, NULL if link is the head */
+Element LinkOwner(Map map, Element *link);
+
+/** Set the internal iterator to element and return its key */
+MapKeyElement SetIterator(Map map, Element element);
+
+/** Return the element after the position of the cursor, the position is
+ *  found again by its key if the map changed since the cursor moved */
+Element CursorNextElement(Map map, MapCursor *cursor);
+
 
 struct Map_t{
     Element head;
     Element current;
+    Element finger;
     int num_of_elements;
     copyMapDataElements CopyData;
     copyMapKeyElements CopyKey;
     freeMapDataElements FreeData;
     freeMapKeyElements FreeKey;
     compareMapKeyElements CompareKeys;
+    Allocator allocator;
+    int keySize;
+    int dataSize;
+    AllocatorCategory dataCategory;
+    bool concurrent;
+    pthread_rwlock_t lock;
+    unsigned long version;
+    unsigned long epoch;
+    Element retired[MAP_EPOCHS];
+    int readers[MAP_EPOCHS];
+#ifdef MAP_STATS
+    MapStats stats;
+#endif
 };
 
+void* MapCopyItem(Map map, void* item, bool isKey){
+    int size = isKey ? map->keySize : map->dataSize;
+    if(size<=0){
+        return isKey ? map->CopyKey(item) : map->CopyData(item);
+    }
+    void* copy = allocatorAllocate(map->allocator,
+                                   isKey ? ALLOCATOR_KEYS : map->dataCategory,
+                                   size);
+    if(!copy) return NULL;
+    memcpy(copy, item, size);
+    return copy;
+}
+
+void MapFreeItem(Map map, void* item, bool isKey){
+    if((isKey ? map->keySize : map->dataSize) > 0){
+        allocatorFree(map->allocator, item);
+    }
+    else if(isKey){
+        map->FreeKey(item);
+    }
+    else{
+        map->FreeData(item);
+    }
+}
+
 Element ElementCreate(Map map,MapKeyElement key, MapDataElement data){
     if(!data||!key||!map){
         return NULL;
     }
-    Element e = malloc(sizeof(*e));
+    Element e = allocatorAllocate(map->allocator, ALLOCATOR_MAP_NODES,
+                                  sizeof(*e));
     if(!e) return NULL;
-    e->data = map->CopyData(data);
-    e->key = map->CopyKey(key);
+    MAP_STATS_ADD(map, allocations, 1);
+    MAP_STATS_ADD(map, dataCopies, 1);
+    e->data = MapCopyItem(map, data, false);
+    e->key = MapCopyItem(map, key, true);
     e->next = NULL;
+    if(!e->data||!e->key){
+        if(e->data) MapFreeItem(map, e->data, false);
+        if(e->key) MapFreeItem(map, e->key, true);
+        allocatorFree(map->allocator, e);
+        return NULL;
+    }
     return e;
 }
 
@@ -70,9 +232,9 @@ void ElementDestroy(Map map,Element e){
     if(!e||!map){
         return;
     }
-    map->FreeData(e->data);
-    map->FreeKey(e->key);
-    free(e);
+    MapFreeItem(map, e->data, false);
+    MapFreeItem(map, e->key, true);
+    allocatorFree(map->allocator, e);
 }
 
 
@@ -82,6 +244,7 @@ void DestroyAllElements(Map map){
     }
     DestroyAllElementsReq(map,map->head);
     map->current = NULL;
+    map->finger = NULL;
     map->head = NULL;
 }
 
@@ -93,33 +256,35 @@ void DestroyAllElementsReq(Map map,Element e){
     ElementDestroy(map,e);
 }
 
-bool AppendElement(Element element, Element elementToAppend){
-    if(!element||!elementToAppend) {
-        return false;
-    }
-    if(!element->next){
-        element->next = elementToAppend;
-        return true;
-    }
-    else {
-        Element tmp = element->next;
-        element->next = elementToAppend;
-        elementToAppend ->next = tmp;
-        return true;
-    }
-}
-
 Map mapCreate(copyMapDataElements copyDataElement,
               copyMapKeyElements copyKeyElement,
               freeMapDataElements freeDataElement,
               freeMapKeyElements freeKeyElement,
               compareMapKeyElements compareKeyElements){
+    return mapCreateWithAllocator(copyDataElement, copyKeyElement,
+                                  freeDataElement, freeKeyElement,
+                                  compareKeyElements, NULL, 0, 0,
+                                  ALLOCATOR_OTHER);
+}
+
+Map mapCreateWithAllocator(copyMapDataElements copyDataElement,
+                           copyMapKeyElements copyKeyElement,
+                           freeMapDataElements freeDataElement,
+                           freeMapKeyElements freeKeyElement,
+                           compareMapKeyElements compareKeyElements,
+                           Allocator allocator, int keySize, int dataSize,
+                           AllocatorCategory dataCategory){
     if(!copyDataElement||!copyKeyElement||!freeDataElement||!freeKeyElement
         ||!compareKeyElements){
         return NULL;
     }
-    Map map = malloc(sizeof(*map));
+    if(keySize<0||dataSize<0) return NULL;
+    Map map = allocatorAllocate(allocator, ALLOCATOR_MAP_NODES, sizeof(*map));
     if(!map)return NULL;
+    map->allocator = allocator;
+    map->keySize = keySize;
+    map->dataSize = dataSize;
+    map->dataCategory = dataCategory;
     map->CopyData = copyDataElement;
     map->CopyKey = copyKeyElement;
     map->FreeData = freeDataElement;
@@ -128,18 +293,48 @@ Map mapCreate(copyMapDataElements copyDataElement,
     map->num_of_elements = 0;
     map->head = NULL;
     map->current = NULL;
+    map->finger = NULL;
+    map->concurrent = false;
+    map->version = 0;
+    map->epoch = 0;
+    for(int i=0; i<MAP_EPOCHS; i++){
+        map->retired[i] = NULL;
+        map->readers[i] = 0;
+    }
+    mapResetStats(map);
     return map;
 }
 
 void mapDestroy(Map map){
     if(!map) return;
     DestroyAllElements(map);
-    free(map);
+    mapSetConcurrent(map, false);
+    allocatorFree(map->allocator, map);
+}
+
+MapResult mapSetConcurrent(Map map, bool concurrent){
+    if(!map) return MAP_NULL_ARGUMENT;
+    if(map->concurrent == concurrent) return MAP_SUCCESS;
+    if(concurrent){
+        if(pthread_rwlock_init(&map->lock, NULL)!=0){
+            return MAP_OUT_OF_MEMORY;
+        }
+        map->finger = NULL;
+    }
+    else{
+        pthread_rwlock_destroy(&map->lock);
+    }
+    map->concurrent = concurrent;
+    DestroyRetiredElements(map);
+    map->version++;
+    return MAP_SUCCESS;
 }
 
 int mapGetSize(Map map){
     if(!map) return -1;
+    MAP_READ_LOCK(map);
     int result = map->num_of_elements;
+    MAP_UNLOCK(map);
     return result;
 }
 
@@ -147,81 +342,371 @@ MapResult mapPut(Map map, MapKeyElement keyElement, MapDataElement dataElement){
     if(!map||!keyElement||!dataElement){
         return MAP_NULL_ARGUMENT;
     }
+    MAP_WRITE_LOCK(map);
+    map->version++;
+    MapResult result = PutElement(map, keyElement, dataElement);
+    MAP_WRITE_UNLOCK(map);
+    return result;
+}
+
+MapResult PutElement(Map map, MapKeyElement keyElement,
+                     MapDataElement dataElement){
+    int compareResult;
+    Element* link = FindLinkInMap(map, keyElement, &compareResult);
+    map->current = NULL;
+    if(compareResult==0){
+        return ReplaceElementData(map, link, dataElement);
+    }
     Element newElement = ElementCreate(map, keyElement , dataElement);
     if(!newElement) return MAP_OUT_OF_MEMORY;
-    if(!map->head){
-        map->head = newElement;
+    newElement->next = *link;
+    *link = newElement;
+    map->num_of_elements++;
+    return MAP_SUCCESS;
+}
+
+bool KeysSorted(Map map, MapKeyElement *keyElements, int numOfElements){
+    for(int i=1; i<numOfElements; i++){
+        if(MAP_COMPARE(map, keyElements[i-1], keyElements[i])>0){
+            return false;
+        }
+    }
+    return true;
+}
+
+MapResult MergeElementAt(Map map, Element **link, MapKeyElement key,
+                         MapDataElement data,
+                         combineMapDataElements combineDataElements){
+    int compareResult = 1;
+    while(**link){
+        compareResult = MAP_COMPARE(map, key, (**link)->key);
+        if(compareResult<=0) break;
+        *link = &(**link)->next;
+    }
+    if(**link && compareResult==0){
+        if(combineDataElements){
+            combineDataElements((**link)->data, data);
+        }
+        else{
+            MapResult result = ReplaceElementData(map, *link, data);
+            if(result!=MAP_SUCCESS) return result;
+        }
+    }
+    else{
+        Element newElement = ElementCreate(map, key, data);
+        if(!newElement) return MAP_OUT_OF_MEMORY;
+        newElement->next = **link;
+        **link = newElement;
         map->num_of_elements++;
-        return MAP_SUCCESS;
     }
-    Element tmpElement = map->head;
-    int compareResult = map->CompareKeys(newElement->key,tmpElement->key);
-    if(compareResult<=0){
-        if(!AppendElement(newElement,tmpElement)) return MAP_OUT_OF_MEMORY;
-            map->head = newElement;
-            map->num_of_elements++;
-        if(compareResult==0){
-            newElement->next = tmpElement->next;
-            ElementDestroy(map,tmpElement);
-            map->num_of_elements--;
+    *link = &(**link)->next;
+    return MAP_SUCCESS;
+}
+
+void RemoveElementAt(Map map, Element *link){
+    Element elementToDestroy = *link;
+    *link = elementToDestroy->next;
+    map->num_of_elements--;
+    RetireElement(map,elementToDestroy);
+}
+
+void RetireElement(Map map, Element e){
+    if(!map->concurrent){
+        ElementDestroy(map,e);
+        return;
+    }
+    Element *retired = &map->retired[map->epoch % MAP_EPOCHS];
+    e->next = *retired;
+    *retired = e;
+}
+
+void DestroyElementList(Map map, Element *list){
+    while(*list){
+        Element elementToDestroy = *list;
+        *list = elementToDestroy->next;
+        ElementDestroy(map,elementToDestroy);
+    }
+}
+
+void DestroyRetiredElements(Map map){
+    for(int i=0; i<MAP_EPOCHS; i++){
+        DestroyElementList(map, &map->retired[i]);
+    }
+}
+
+void ReclaimRetiredElements(Map map){
+    /* an element retired in epoch e can only be held by the sections that
+     * began in epoch e or before, since sections begin under the read lock
+     * and the element was unlinked under the write lock. Once the sections
+     * of the previous epoch ended its elements are deallocated and its slot
+     * is reused by the next epoch. Advancing twice frees the current epoch
+     * too when no section is open at all */
+    for(int i=0; i<MAP_EPOCHS; i++){
+        int previous = (int)((map->epoch+1) % MAP_EPOCHS);
+        int current = (int)(map->epoch % MAP_EPOCHS);
+        if(!map->retired[previous] && !map->retired[current]) return;
+        if(__atomic_load_n(&map->readers[previous], __ATOMIC_ACQUIRE)!=0){
+            return;
         }
-        map->current = NULL;
+        DestroyElementList(map, &map->retired[previous]);
+        map->epoch++;
+    }
+}
+
+MapResult mapReadBegin(Map map, MapReadSection *section){
+    if(!map||!section) return MAP_NULL_ARGUMENT;
+    section->active = map->concurrent;
+    if(!section->active) return MAP_SUCCESS;
+    MAP_READ_LOCK(map);
+    section->epoch = map->epoch;
+    __atomic_add_fetch(&map->readers[section->epoch % MAP_EPOCHS], 1,
+                       __ATOMIC_RELAXED);
+    MAP_UNLOCK(map);
+    return MAP_SUCCESS;
+}
+
+MapResult mapReadEnd(Map map, MapReadSection *section){
+    if(!map||!section) return MAP_NULL_ARGUMENT;
+    if(section->active){
+        __atomic_sub_fetch(&map->readers[section->epoch % MAP_EPOCHS], 1,
+                           __ATOMIC_RELEASE);
+        section->active = 0;
+    }
+    return MAP_SUCCESS;
+}
+
+MapResult ReplaceElementData(Map map, Element *link, MapDataElement data){
+    if(map->concurrent){
+        Element newElement = ElementCreate(map, (*link)->key, data);
+        if(!newElement) return MAP_OUT_OF_MEMORY;
+        Element oldElement = *link;
+        newElement->next = oldElement->next;
+        *link = newElement;
+        RetireElement(map, oldElement);
         return MAP_SUCCESS;
     }
-    else {
-        while (tmpElement->next) {
-            compareResult = map->CompareKeys(newElement->key,
-                                             tmpElement->next->key);
-            if (compareResult > 0) {
-                tmpElement = tmpElement->next;
-                continue;
-            }
-            else if (compareResult < 0) {
-                break;
-            }
-            else if(compareResult == 0){
-                bool result = AppendElement(tmpElement,newElement);
-                if(!result) return MAP_OUT_OF_MEMORY;
-                Element elementToDestroy = newElement->next;
-                newElement->next = newElement->next->next;
-                ElementDestroy(map,elementToDestroy);
-                map->current = NULL;
-                return MAP_SUCCESS;
-            }
+    MapDataElement copy = MapCopyItem(map, data, false);
+    if(!copy) return MAP_OUT_OF_MEMORY;
+    MAP_STATS_ADD(map, dataCopies, 1);
+    MapFreeItem(map, (*link)->data, false);
+    (*link)->data = copy;
+    return MAP_SUCCESS;
+}
+
+void ClearElements(Map map){
+    if(map->concurrent && map->head){
+        Element *retired = &map->retired[map->epoch % MAP_EPOCHS];
+        Element last = map->head;
+        while(last->next){
+            last = last->next;
+        }
+        last->next = *retired;
+        *retired = map->head;
+        map->head = NULL;
+    }
+    DestroyAllElements(map);
+    map->num_of_elements = 0;
+}
+
+MapResult MergeSortedElements(Map map, MapKeyElement *keyElements,
+                              MapDataElement *dataElements,
+                              int numOfElements){
+    Element* link = &map->head;
+    for(int i=0; i<numOfElements; i++){
+        if(i+1<numOfElements &&
+           MAP_COMPARE(map, keyElements[i], keyElements[i+1])==0){
+            continue;
+        }
+        MapResult result = MergeElementAt(map, &link, keyElements[i],
+                                          dataElements[i], NULL);
+        if(result!=MAP_SUCCESS) return result;
+    }
+    return MAP_SUCCESS;
+}
+
+MapResult mapPutBulk(Map map, MapKeyElement *keyElements,
+                     MapDataElement *dataElements, int numOfElements){
+    if(!map||!keyElements||!dataElements){
+        return MAP_NULL_ARGUMENT;
+    }
+    for(int i=0; i<numOfElements; i++){
+        if(!keyElements[i]||!dataElements[i]) return MAP_NULL_ARGUMENT;
+    }
+    MAP_WRITE_LOCK(map);
+    map->version++;
+    MapResult result = PutSortedElements(map, keyElements, dataElements,
+                                         numOfElements);
+    MAP_WRITE_UNLOCK(map);
+    return result;
+}
+
+MapResult PutSortedElements(Map map, MapKeyElement *keyElements,
+                            MapDataElement *dataElements, int numOfElements){
+    map->current = NULL;
+    if(!KeysSorted(map, keyElements, numOfElements)){
+        for(int i=0; i<numOfElements; i++){
+            MapResult result = PutElement(map, keyElements[i],
+                                          dataElements[i]);
+            if(result!=MAP_SUCCESS) return result;
         }
-        AppendElement(tmpElement, newElement);
-        map->num_of_elements++;
-        map->current = NULL;
         return MAP_SUCCESS;
     }
+    MapResult result = MergeSortedElements(map, keyElements, dataElements,
+                                           numOfElements);
+    map->current = NULL;
+    return result;
 }
 
-Element FindElementInMap(Map map, MapKeyElement keyElement){
-    if(!map||!keyElement){
-        return NULL;
+MapResult mapMerge(Map destination, Map source,
+                   combineMapDataElements combineDataElements){
+    if(!destination||!source) return MAP_NULL_ARGUMENT;
+    MAP_WRITE_LOCK(destination);
+    if(source != destination) MAP_READ_LOCK(source);
+    destination->version++;
+    destination->current = NULL;
+    Element* link = &destination->head;
+    MapResult result = MAP_SUCCESS;
+    for(Element element = source->head; element && result==MAP_SUCCESS;
+        element = element->next){
+        result = MergeElementAt(destination, &link, element->key,
+                                element->data, combineDataElements);
     }
-    Element tmpElement = map->head;
-    int compareResult;
-    while(tmpElement){
-        compareResult = map->CompareKeys(keyElement,tmpElement->key);
-        if(compareResult==0){
-            return tmpElement;
+    if(source != destination) MAP_UNLOCK(source);
+    MAP_WRITE_UNLOCK(destination);
+    return result;
+}
+
+MapResult mapIntersect(Map destination, Map source,
+                       combineMapDataElements combineDataElements){
+    if(!destination||!source) return MAP_NULL_ARGUMENT;
+    MAP_WRITE_LOCK(destination);
+    if(source != destination) MAP_READ_LOCK(source);
+    destination->version++;
+    destination->current = NULL;
+    destination->finger = NULL;
+    Element* link = &destination->head;
+    Element element = source->head;
+    while(*link){
+        int compareResult = -1;
+        while(element){
+            compareResult = MAP_COMPARE(destination, (*link)->key,
+                                        element->key);
+            if(compareResult<=0) break;
+            element = element->next;
         }
-        else if(compareResult<0){
-            break;
+        if(element && compareResult==0){
+            if(combineDataElements){
+                combineDataElements((*link)->data, element->data);
+            }
+            link = &(*link)->next;
+            element = element->next;
+        }
+        else{
+            RemoveElementAt(destination, link);
+        }
+    }
+    if(source != destination) MAP_UNLOCK(source);
+    MAP_WRITE_UNLOCK(destination);
+    return MAP_SUCCESS;
+}
+
+MapResult mapDifference(Map destination, Map source){
+    if(!destination||!source) return MAP_NULL_ARGUMENT;
+    if(destination == source) return mapClear(destination);
+    MAP_WRITE_LOCK(destination);
+    MAP_READ_LOCK(source);
+    destination->version++;
+    destination->current = NULL;
+    destination->finger = NULL;
+    Element* link = &destination->head;
+    Element element = source->head;
+    while(*link && element){
+        int compareResult = MAP_COMPARE(destination, (*link)->key,
+                                        element->key);
+        if(compareResult<0){
+            link = &(*link)->next;
         }
         else if(compareResult>0){
-            tmpElement = tmpElement->next;
+            element = element->next;
+        }
+        else{
+            RemoveElementAt(destination, link);
+            element = element->next;
+        }
+    }
+    MAP_UNLOCK(source);
+    MAP_WRITE_UNLOCK(destination);
+    return MAP_SUCCESS;
+}
+
+MapResult mapBuildFromSorted(Map map, MapKeyElement *keyElements,
+                             MapDataElement *dataElements, int numOfElements){
+    if(!map||!keyElements||!dataElements){
+        return MAP_NULL_ARGUMENT;
+    }
+    for(int i=0; i<numOfElements; i++){
+        if(!keyElements[i]||!dataElements[i]) return MAP_NULL_ARGUMENT;
+    }
+    MAP_WRITE_LOCK(map);
+    map->version++;
+    ClearElements(map);
+    MapResult result = PutSortedElements(map, keyElements, dataElements,
+                                         numOfElements);
+    MAP_WRITE_UNLOCK(map);
+    return result;
+}
+
+Element FingerSearchStart(Map map, MapKeyElement keyElement){
+    Element candidates[] = {map->current, map->finger};
+    for(int i=0; i<2; i++){
+        if(candidates[i] &&
+           MAP_COMPARE(map, keyElement, candidates[i]->key)>0){
+            MAP_STATS_ADD(map, fingerHits, 1);
+            return candidates[i];
         }
     }
+    MAP_STATS_ADD(map, fingerMisses, 1);
     return NULL;
 }
 
+Element* FindLinkInMap(Map map, MapKeyElement keyElement,
+                       int *compareResult){
+    Element previous = FingerSearchStart(map, keyElement);
+    Element* link = previous ? &previous->next : &map->head;
+    *compareResult = 1;
+    while(*link){
+        MAP_STATS_ADD(map, nodesTraversed, 1);
+        *compareResult = MAP_COMPARE(map, keyElement, (*link)->key);
+        if(*compareResult<=0) break;
+        previous = *link;
+        link = &previous->next;
+    }
+    if(!map->concurrent){
+        map->finger = previous;
+    }
+    return link;
+}
+
+Element FindElementInMap(Map map, MapKeyElement keyElement){
+    if(!map||!keyElement){
+        return NULL;
+    }
+    int compareResult;
+    Element* link = FindLinkInMap(map, keyElement, &compareResult);
+    if(compareResult!=0){
+        return NULL;
+    }
+    return *link;
+}
+
 bool mapContains(Map map, MapKeyElement element){
     if(!map||!element){
         return false;
     }
-    if(FindElementInMap(map,element)){
+    MAP_READ_LOCK(map);
+    Element found = FindElementInMap(map,element);
+    MAP_UNLOCK(map);
+    if(found){
         return true;
     }
     else {
@@ -231,20 +716,35 @@ bool mapContains(Map map, MapKeyElement element){
 
 Map mapCopy(Map map){
     if(!map) return NULL;
-    Map newMap = mapCreate(map->CopyData, map->CopyKey,
-                           map->FreeData, map->FreeKey, map->CompareKeys);
+    Map newMap = mapCreateWithAllocator(map->CopyData, map->CopyKey,
+                                        map->FreeData, map->FreeKey,
+                                        map->CompareKeys, map->allocator,
+                                        map->keySize, map->dataSize,
+                                        map->dataCategory);
     if(!newMap) return NULL;
-    if(!map->head) return newMap;
+    MAP_READ_LOCK(map);
+    if(!map->head){
+        MAP_UNLOCK(map);
+        return newMap;
+    }
     Element srcElement = map->head;
     Element tmpElement;
     Element destElement = ElementCopy(map, srcElement);
-    if(!destElement) return NULL;
+    if(!destElement){
+        MAP_UNLOCK(map);
+        mapDestroy(newMap);
+        return NULL;
+    }
     newMap->head = destElement;
     newMap->num_of_elements++;
     srcElement = srcElement->next;
     while (srcElement) {
         tmpElement = ElementCopy(map, srcElement);
-        if(!tmpElement) return NULL;
+        if(!tmpElement){
+            MAP_UNLOCK(map);
+            mapDestroy(newMap);
+            return NULL;
+        }
         destElement->next = tmpElement;
         newMap->num_of_elements++;
         destElement = destElement->next;
@@ -253,6 +753,7 @@ Map mapCopy(Map map){
     if(map->current){
         newMap->current = FindElementInMap(newMap,map->current->key);
     }
+    MAP_UNLOCK(map);
     return newMap;
 }
 
@@ -260,7 +761,9 @@ MapDataElement mapGet(Map map, MapKeyElement keyElement){
     if(!map||!keyElement) {
         return NULL;
     }
+    MAP_READ_LOCK(map);
     Element tmpElement = FindElementInMap(map,keyElement);
+    MAP_UNLOCK(map);
     if(!tmpElement){
         return NULL;
     }
@@ -273,56 +776,176 @@ MapResult mapRemove(Map map, MapKeyElement keyElement){
     if(!map||!keyElement) {
         return MAP_NULL_ARGUMENT;
     }
-    if(!map->head) return MAP_ITEM_DOES_NOT_EXIST;
-    Element tmpElement = map->head;
-    int compareResult = map->CompareKeys(tmpElement->key,keyElement);
+    MAP_WRITE_LOCK(map);
+    map->version++;
+    int compareResult;
+    Element* link = FindLinkInMap(map, keyElement, &compareResult);
+    MapResult result = MAP_ITEM_DOES_NOT_EXIST;
     if(compareResult==0){
-        Element elementToDestroy = tmpElement;
-        map->head = map->head->next;
-        map->num_of_elements--;
-        ElementDestroy(map,elementToDestroy);
+        RemoveElementAt(map, link);
         map->current = NULL;
-        return MAP_SUCCESS;
-    }
-    while(tmpElement->next){
-        compareResult = map->CompareKeys(tmpElement->next->key,keyElement);
-        if(compareResult>0){
-            return MAP_ITEM_DOES_NOT_EXIST;
-        }
-        else if(compareResult==0){
-            Element elementToDestroy = tmpElement->next;
-            tmpElement->next = elementToDestroy->next;
-            map->num_of_elements--;
-            ElementDestroy(map,elementToDestroy);
-            map->current = NULL;
-            return MAP_SUCCESS;
-        }
-        else{
-            tmpElement = tmpElement->next;
-        }
+        result = MAP_SUCCESS;
     }
-    return MAP_ITEM_DOES_NOT_EXIST;
+    MAP_WRITE_UNLOCK(map);
+    return result;
+}
+
+MapKeyElement SetIterator(Map map, Element element){
+    map->current = element;
+    if(!element) return NULL;
+    return element->key;
+}
+
+Element LinkOwner(Map map, Element *link){
+    if(link == &map->head) return NULL;
+    return (Element)((char*)link-offsetof(struct Element_t, next));
 }
 
 MapKeyElement mapGetFirst(Map map){
     if(!map) return NULL;
-    if(!map->head) return NULL;
-    map->current = map->head;
-    return map->head->key;
+    MAP_WRITE_LOCK(map);
+    MapKeyElement first = SetIterator(map, map->head);
+    MAP_UNLOCK(map);
+    return first;
 }
 
 MapKeyElement mapGetNext(Map map){
     if(!map) return NULL;
-    if(!map->current) return NULL;
-    if(!map->current->next) return NULL;
-    map->current = map->current->next;
-    return map->current->key;
+    MAP_WRITE_LOCK(map);
+    MapKeyElement next = NULL;
+    if(map->current && map->current->next){
+        map->current = map->current->next;
+        next = map->current->key;
+    }
+    MAP_UNLOCK(map);
+    return next;
+}
+
+Element LowerBoundElement(Map map, MapKeyElement keyElement){
+    int compareResult;
+    Element* link = FindLinkInMap(map, keyElement, &compareResult);
+    return *link;
+}
+
+MapKeyElement mapLowerBound(Map map, MapKeyElement keyElement){
+    if(!map||!keyElement) return NULL;
+    MAP_WRITE_LOCK(map);
+    MapKeyElement lowerBound = SetIterator(map,
+                                           LowerBoundElement(map, keyElement));
+    MAP_UNLOCK(map);
+    return lowerBound;
+}
+
+MapKeyElement mapUpperBound(Map map, MapKeyElement keyElement){
+    if(!map||!keyElement) return NULL;
+    MAP_WRITE_LOCK(map);
+    int compareResult;
+    Element* link = FindLinkInMap(map, keyElement, &compareResult);
+    MapKeyElement upperBound = SetIterator(map, compareResult==0 ?
+                                                *link : LinkOwner(map, link));
+    MAP_UNLOCK(map);
+    return upperBound;
+}
+
+MapKeyElement mapGetFirstInRange(Map map, MapKeyElement fromKey,
+                                 MapKeyElement toKey){
+    if(!map||!fromKey||!toKey) return NULL;
+    MapKeyElement first = mapLowerBound(map, fromKey);
+    if(!first||MAP_COMPARE(map, first, toKey)>0) return NULL;
+    return first;
+}
+
+MapKeyElement mapGetNextInRange(Map map, MapKeyElement toKey){
+    if(!map||!toKey) return NULL;
+    MapKeyElement next = mapGetNext(map);
+    if(!next||MAP_COMPARE(map, next, toKey)>0) return NULL;
+    return next;
+}
+
+Element CursorNextElement(Map map, MapCursor *cursor){
+    Element position = cursor->position;
+    if(cursor->version == map->version){
+        return position->next;
+    }
+    if(!map->concurrent){
+        return NULL;
+    }
+    int compareResult;
+    Element* link = FindLinkInMap(map, position->key, &compareResult);
+    if(*link && compareResult==0){
+        return (*link)->next;
+    }
+    return *link;
+}
+
+MapKeyElement mapCursorFirst(Map map, MapCursor *cursor){
+    if(!map||!cursor) return NULL;
+    MAP_READ_LOCK(map);
+    Element first = map->head;
+    cursor->position = first;
+    cursor->version = map->version;
+    MAP_UNLOCK(map);
+    if(!first) return NULL;
+    return first->key;
+}
+
+MapKeyElement mapCursorNext(Map map, MapCursor *cursor){
+    if(!map||!cursor||!cursor->position) return NULL;
+    MAP_READ_LOCK(map);
+    Element next = CursorNextElement(map, cursor);
+    cursor->position = next;
+    cursor->version = map->version;
+    MAP_UNLOCK(map);
+    if(!next) return NULL;
+    return next->key;
+}
+
+MapDataElement mapCursorGetData(Map map, MapCursor *cursor){
+    if(!map||!cursor||!cursor->position) return NULL;
+    MAP_READ_LOCK(map);
+    MapDataElement data = NULL;
+    if(map->concurrent || cursor->version == map->version){
+        data = ((Element)cursor->position)->data;
+    }
+    MAP_UNLOCK(map);
+    return data;
 }
 
 MapResult mapClear(Map map){
     if(!map) return MAP_NULL_ARGUMENT;
-    DestroyAllElements(map);
-    map->num_of_elements = 0;
-    map->current = NULL;
+    MAP_WRITE_LOCK(map);
+    map->version++;
+    ClearElements(map);
+    MAP_WRITE_UNLOCK(map);
+    return MAP_SUCCESS;
+}
+
+MapResult mapGetStats(Map map, MapStats *stats){
+    if(!map||!stats) return MAP_NULL_ARGUMENT;
+#ifdef MAP_STATS
+    MAP_READ_LOCK(map);
+    *stats = map->stats;
+    MAP_UNLOCK(map);
+#else
+    stats->compares = 0;
+    stats->nodesTraversed = 0;
+    stats->allocations = 0;
+    stats->dataCopies = 0;
+    stats->fingerHits = 0;
+    stats->fingerMisses = 0;
+#endif
+    return MAP_SUCCESS;
+}
+
+MapResult mapResetStats(Map map){
+    if(!map) return MAP_NULL_ARGUMENT;
+#ifdef MAP_STATS
+    map->stats.compares = 0;
+    map->stats.nodesTraversed = 0;
+    map->stats.allocations = 0;
+    map->stats.dataCopies = 0;
+    map->stats.fingerHits = 0;
+    map->stats.fingerMisses = 0;
+#endif
     return MAP_SUCCESS;
 }
@@ -2,6 +2,7 @@
 #define MAP_H_
 
 #include <stdbool.h>
+#include "allocator.h"
 
 /**
 * Generic Map Container
@@ -11,8 +12,17 @@
 * where the state of the iterator after calling that function is not stated,
 * it is undefined. That is you cannot assume anything about it.
 *
+* A map can be made concurrent with mapSetConcurrent. A concurrent map is
+* guarded by a reader-writer lock, so lookups from many threads run in
+* parallel while changes wait for them. Threads that iterate over a
+* concurrent map use their own MapCursor instead of the internal iterator,
+* inside a read section (mapReadBegin and mapReadEnd) that keeps the keys,
+* data and cursor positions they hold from being deallocated.
+*
 * The following functions are available:
 *   mapCreate		- Creates a new empty map
+*   mapCreateWithAllocator - Creates a new empty map that allocates through
+*   				  an Allocator
 *   mapDestroy		- Deletes an existing map and frees all resources
 *   mapCopy		- Copies an existing map
 *   mapGetSize		- Returns the size of a given map
@@ -21,6 +31,17 @@
 *   mapPut		    - Gives a specific key a given value.
 *   				  If the key exists, the value is overridden.
 *   				  This resets the internal iterator.
+*   mapPutBulk	    - Gives many keys given values in one pass over the map.
+*   				  This resets the internal iterator.
+*   mapBuildFromSorted - Replaces the contents of the map with sorted pairs.
+*   				  This resets the internal iterator.
+*   mapMerge		- Puts all the pairs of another map in the map, combining
+*   				  the data of keys that are in both.
+*   				  This resets the internal iterator.
+*   mapIntersect	- Removes the keys that are not in another map.
+*   				  This resets the internal iterator.
+*   mapDifference	- Removes the keys that are in another map.
+*   				  This resets the internal iterator.
 *   mapGet  	    - Returns the data paired to a key which matches the given key.
 *					  Iterator status unchanged
 *   mapRemove		- Removes a pair of (key,data) elements for which the key
@@ -30,14 +51,53 @@
 *   				  map, and returns it.
 *   mapGetNext		- Advances the internal iterator to the next key and
 *   				  returns it.
+*   mapLowerBound	- Sets the internal iterator to the first key that is not
+*   				  smaller than a given key, and returns it.
+*   mapUpperBound	- Sets the internal iterator to the last key that is not
+*   				  bigger than a given key, and returns it.
+*   mapGetFirstInRange - Sets the internal iterator to the first key of a
+*   				  range of keys, and returns it.
+*   mapGetNextInRange - Advances the internal iterator to the next key of a
+*   				  range of keys and returns it.
+*   mapCursorFirst	- Sets a cursor to the first key in the map, and returns it.
+*   mapCursorNext	- Advances a cursor to the next key and returns it.
+*   mapCursorGetData - Returns the data paired to the key of a cursor.
+*   mapSetConcurrent - Makes the map safe (or not) to use from many threads.
+*   mapReadBegin	- Starts a read section of a concurrent map.
+*   mapReadEnd		- Ends a read section of a concurrent map.
 *	 mapClear		- Clears the contents of the map. Frees all the elements of
 *	 				  the map using the free function.
+*	 mapGetStats	- Returns the operation counters of the map.
+*	 mapResetStats	- Sets the operation counters of the map to zero.
 * 	 MAP_FOREACH	- A macro for iterating over the map's elements.
+* 	 MAP_FOREACH_RANGE - A macro for iterating over the elements of a range
+* 	 				  of keys.
+* 	 MAP_FOREACH_CURSOR - A macro for iterating over the map's elements with
+* 	 				  a cursor.
 */
 
 /** Type for defining the map */
 typedef struct Map_t *Map;
 
+/**
+* The position of an iteration over a map, kept by the caller instead of the
+* internal iterator of the map so every thread can iterate with its own
+* cursor. The fields are private to the map.
+*/
+typedef struct MapCursor_t {
+    void *position;
+    unsigned long version;
+} MapCursor;
+
+/**
+* A read section of a concurrent map, see mapReadBegin. The fields are
+* private to the map.
+*/
+typedef struct MapReadSection_t {
+    unsigned long epoch;
+    int active;
+} MapReadSection;
+
 /** Type used for returning error codes from map functions */
 typedef enum MapResult_t {
     MAP_SUCCESS,
@@ -75,6 +135,34 @@ typedef void(*freeMapKeyElements)(MapKeyElement);
 */
 typedef int(*compareMapKeyElements)(MapKeyElement, MapKeyElement);
 
+/**
+* Type of function used by mapMerge and mapIntersect to combine the data of
+* a key that is in both maps. The function adds the second data element into
+* the first one in place (like adding counters).
+*/
+typedef void(*combineMapDataElements)(MapDataElement, MapDataElement);
+
+/**
+* Operation counters of a map. The counters are only collected when the map
+* is compiled with MAP_STATS defined, otherwise they are always zero and
+* cost nothing.
+*   compares       - calls to the key compare function
+*   nodesTraversed - elements visited while searching for a key
+*   allocations    - elements allocated
+*   dataCopies     - calls to the data copy function
+*   fingerHits     - searches that started from the last accessed element or
+*                    the iterator instead of the head
+*   fingerMisses   - searches that had to start from the head
+*/
+typedef struct MapStats_t {
+    long compares;
+    long nodesTraversed;
+    long allocations;
+    long dataCopies;
+    long fingerHits;
+    long fingerMisses;
+} MapStats;
+
 /**
 * mapCreate: Allocates a new empty map.
 *
@@ -98,6 +186,37 @@ Map mapCreate(copyMapDataElements copyDataElement,
               freeMapKeyElements freeKeyElement,
               compareMapKeyElements compareKeyElements);
 
+/**
+* mapCreateWithAllocator: Allocates a new empty map like mapCreate, the map
+* and its elements are allocated through allocator (as ALLOCATOR_MAP_NODES).
+*
+* Keys and data of a fixed size (like ints) can be stored by the map itself:
+* when keySize is positive the keys are copied with memcpy into blocks of the
+* allocator counted as ALLOCATOR_KEYS instead of using copyKeyElement and
+* freeKeyElement, and the same for the data with dataSize and dataCategory.
+* Copies of the map use the same allocator and sizes.
+*
+* @param copyDataElement, copyKeyElement, freeDataElement, freeKeyElement,
+* 		compareKeyElements - like in mapCreate
+* @param allocator - the allocator to use, NULL to use malloc and free
+* @param keySize - the size of every key, 0 to use the key functions
+* @param dataSize - the size of every data element, 0 to use the data
+* 		functions
+* @param dataCategory - the category the data is counted in when dataSize is
+* 		positive
+* @return
+* 	NULL - if one of the functions is NULL, a size is negative or allocations
+* 	failed.
+* 	A new Map in case of success.
+*/
+Map mapCreateWithAllocator(copyMapDataElements copyDataElement,
+                           copyMapKeyElements copyKeyElement,
+                           freeMapDataElements freeDataElement,
+                           freeMapKeyElements freeKeyElement,
+                           compareMapKeyElements compareKeyElements,
+                           Allocator allocator, int keySize, int dataSize,
+                           AllocatorCategory dataCategory);
+
 /**
 * mapDestroy: Deallocates an existing map. Clears all elements by using the
 * stored free functions.
@@ -159,6 +278,99 @@ bool mapContains(Map map, MapKeyElement element);
 */
 MapResult mapPut(Map map, MapKeyElement keyElement, MapDataElement dataElement);
 
+/**
+*	mapPutBulk: Gives numOfElements keys their values, like calling mapPut for
+*  every pair in order, but in one pass over the map when keyElements is
+*  sorted in ascending order. The map is walked once and every pair is linked
+*  after the previous one, so the cost is O(size + numOfElements) instead of
+*  O(size * numOfElements).
+*  If keyElements is not sorted the pairs are put one by one with mapPut.
+*  Equal keys in keyElements are allowed, the last one's value is kept.
+*  Iterator's value is undefined after this operation.
+*
+* @param map - The map to put the pairs in
+* @param keyElements - The key elements, copied like in mapPut
+* @param dataElements - The data element of every key, copied like in mapPut
+* @param numOfElements - The number of pairs
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL was sent as map, keyElements, dataElements or
+* 	one of the elements, nothing is put in this case
+* 	MAP_OUT_OF_MEMORY if an allocation failed, the pairs before the failed
+* 	one stay in the map
+* 	MAP_SUCCESS all the pairs had been inserted successfully
+*/
+MapResult mapPutBulk(Map map, MapKeyElement *keyElements,
+                     MapDataElement *dataElements, int numOfElements);
+
+/**
+*	mapBuildFromSorted: Removes all the elements of the map and fills it with
+*  the given pairs, keyElements is expected to be sorted in ascending order,
+*  see mapPutBulk.
+*  Iterator's value is undefined after this operation.
+*
+* @param map - The map to fill
+* @param keyElements - The key elements
+* @param dataElements - The data element of every key
+* @param numOfElements - The number of pairs
+* @return
+* 	Same as mapPutBulk
+*/
+MapResult mapBuildFromSorted(Map map, MapKeyElement *keyElements,
+                             MapDataElement *dataElements, int numOfElements);
+
+/**
+*	mapMerge: Puts every pair of source in destination in one pass over both
+*  maps. The keys that are only in source are copied into destination, and
+*  the data of a key that is in both is combined by combineDataElements (or
+*  replaced by a copy of the source data if it is NULL).
+*  Both maps must order their keys with the same compare function.
+*  Iterator's value is undefined after this operation.
+*
+* @param destination - The map to merge into
+* @param source - The map to merge from, it is not changed
+* @param combineDataElements - Function that adds the source data of a key
+* 		into its destination data, NULL to replace the destination data
+* @return
+* 	MAP_NULL_ARGUMENT if destination or source is NULL
+* 	MAP_OUT_OF_MEMORY if an allocation failed, the pairs before the failure
+* 	are already merged
+* 	MAP_SUCCESS if all the pairs were merged
+*/
+MapResult mapMerge(Map destination, Map source,
+                   combineMapDataElements combineDataElements);
+
+/**
+*	mapIntersect: Removes from destination every key that is not in source,
+*  in one pass over both maps. The data of the remaining keys is combined
+*  with the source data by combineDataElements if it is not NULL.
+*  Both maps must order their keys with the same compare function.
+*  Iterator's value is undefined after this operation.
+*
+* @param destination - The map to remove from
+* @param source - The map with the keys to keep, it is not changed
+* @param combineDataElements - Function that adds the source data of a key
+* 		into its destination data, NULL to keep the destination data
+* @return
+* 	MAP_NULL_ARGUMENT if destination or source is NULL
+* 	MAP_SUCCESS otherwise
+*/
+MapResult mapIntersect(Map destination, Map source,
+                       combineMapDataElements combineDataElements);
+
+/**
+*	mapDifference: Removes from destination every key that is in source, in
+*  one pass over both maps.
+*  Both maps must order their keys with the same compare function.
+*  Iterator's value is undefined after this operation.
+*
+* @param destination - The map to remove from
+* @param source - The map with the keys to remove, it is not changed
+* @return
+* 	MAP_NULL_ARGUMENT if destination or source is NULL
+* 	MAP_SUCCESS otherwise
+*/
+MapResult mapDifference(Map destination, Map source);
+
 /**
 *	mapGet: Returns the data associated with a specific key in the map.
 *			Iterator status unchanged
@@ -218,6 +430,153 @@ MapKeyElement mapGetFirst(Map map);
 */
 MapKeyElement mapGetNext(Map map);
 
+/**
+*	mapLowerBound: Sets the internal iterator to the first key element in the
+*	map (by the key compare function) that is equal to or bigger than
+*	keyElement, and returns it. To continue iteration use mapGetNext.
+*	The seek starts from the last accessed key when it is before keyElement,
+*	so seeking forward in order does not walk the map from its start.
+* @param map - The map to search in
+* @param keyElement - The key to search for
+* @return
+* 	NULL if a NULL pointer was sent or all the keys are smaller than
+* 	keyElement, the iterator is undefined in this case.
+* 	The first key element that is not smaller than keyElement otherwise
+*/
+MapKeyElement mapLowerBound(Map map, MapKeyElement keyElement);
+
+/**
+*	mapUpperBound: Sets the internal iterator to the last key element in the
+*	map (by the key compare function) that is equal to or smaller than
+*	keyElement, and returns it. To continue iteration use mapGetNext.
+* @param map - The map to search in
+* @param keyElement - The key to search for
+* @return
+* 	NULL if a NULL pointer was sent or all the keys are bigger than
+* 	keyElement, the iterator is undefined in this case.
+* 	The last key element that is not bigger than keyElement otherwise
+*/
+MapKeyElement mapUpperBound(Map map, MapKeyElement keyElement);
+
+/**
+*	mapGetFirstInRange: Sets the internal iterator to the first key element
+*	that is between fromKey and toKey (both included), and returns it.
+*	To continue iteration use mapGetNextInRange.
+* @param map - The map to iterate over
+* @param fromKey - The smallest key of the range
+* @param toKey - The biggest key of the range
+* @return
+* 	NULL if a NULL pointer was sent or no key is in the range.
+* 	The first key element of the range otherwise
+*/
+MapKeyElement mapGetFirstInRange(Map map, MapKeyElement fromKey,
+                                 MapKeyElement toKey);
+
+/**
+*	mapGetNextInRange: Advances the map iterator to the next key element and
+*	returns it if it is not bigger than toKey.
+* @param map - The map for which to advance the iterator
+* @param toKey - The biggest key of the range
+* @return
+* 	NULL if reached the end of the range or of the map, or the iterator is
+* 	at an invalid state or a NULL sent as argument
+* 	The next key element of the range in case of success
+*/
+MapKeyElement mapGetNextInRange(Map map, MapKeyElement toKey);
+
+/**
+*	mapCursorFirst: Sets cursor to the first key element in the map and
+*	returns it. The internal iterator is not used or changed.
+*	To continue iteration use mapCursorNext. The cursor of a concurrent map
+*	must be used inside one read section (see mapReadBegin).
+* @param map - The map to iterate over
+* @param cursor - The cursor to set
+* @return
+* 	NULL if a NULL pointer was sent or the map is empty.
+* 	The first key element of the map otherwise
+*/
+MapKeyElement mapCursorFirst(Map map, MapCursor *cursor);
+
+/**
+*	mapCursorNext: Advances cursor to the next key element in the map and
+*	returns it. If a concurrent map was changed since the cursor moved, the
+*	cursor continues from the first key after its last key. Any change of a
+*	map that is not concurrent ends the iteration of its cursors.
+* @param map - The map the cursor iterates over
+* @param cursor - The cursor to advance
+* @return
+* 	NULL if reached the end of the map, the cursor ended or a NULL sent as
+* 	argument
+* 	The next key element on the map in case of success
+*/
+MapKeyElement mapCursorNext(Map map, MapCursor *cursor);
+
+/**
+*	mapCursorGetData: Returns the data element paired to the key element
+*	cursor is at, without searching for it.
+* @param map - The map the cursor iterates over
+* @param cursor - The cursor
+* @return
+* 	NULL if a NULL pointer was sent or the cursor is not at a key element.
+* 	The data element paired to the key element of the cursor, as it was
+* 	when the cursor reached it
+*/
+MapDataElement mapCursorGetData(Map map, MapCursor *cursor);
+
+/**
+*	mapSetConcurrent: Makes a map safe to use from many threads at once, or
+*	back to a map for one thread.
+*
+*	Every function of a concurrent map takes its reader-writer lock: mapGet,
+*	mapContains, mapGetSize, mapCopy, the cursor functions and mapGetStats
+*	share it, the rest take it alone (mapMerge, mapIntersect and
+*	mapDifference also share the lock of the source map, so two of them must
+*	not run between the same two maps in opposite directions at the same
+*	time). The internal iterator is shared by all
+*	the threads, so threads that iterate at the same time must use cursors.
+*	Elements removed or replaced while the map is concurrent are deallocated
+*	by a later change once every read section that was open when they were
+*	removed has ended, so keys, data and cursors a reader keeps between calls
+*	must be used inside a read section (see mapReadBegin). Data elements
+*	changed in place by a combine function are not guarded. The operation
+*	counters are not collected while the map is concurrent.
+*	Must be called when no other thread uses the map.
+*
+* @param map - The map to change
+* @param concurrent - true to make the map concurrent, false to stop
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL pointer was sent.
+* 	MAP_OUT_OF_MEMORY if the lock could not be created.
+* 	MAP_SUCCESS otherwise
+*/
+MapResult mapSetConcurrent(Map map, bool concurrent);
+
+/**
+*	mapReadBegin: Starts a read section of a concurrent map. The keys and
+*	data a thread gets from the map, and the positions of its cursors, stay
+*	allocated until the thread ends the section with mapReadEnd, even if
+*	another thread removes or replaces them. Sections should be short: the
+*	elements removed while a section is open are kept until it ends. Does
+*	nothing on a map that is not concurrent.
+* @param map - The map to read
+* @param section - Set to the section, passed to mapReadEnd
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL pointer was sent.
+* 	MAP_SUCCESS otherwise
+*/
+MapResult mapReadBegin(Map map, MapReadSection *section);
+
+/**
+*	mapReadEnd: Ends a read section of mapReadBegin, the keys and data read
+*	in it must not be used after it ends
+* @param map - The map of the section
+* @param section - The section to end
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL pointer was sent.
+* 	MAP_SUCCESS otherwise
+*/
+MapResult mapReadEnd(Map map, MapReadSection *section);
+
 
 /**
 * mapClear: Removes all key and data elements from target map.
@@ -230,6 +589,27 @@ MapKeyElement mapGetNext(Map map);
 */
 MapResult mapClear(Map map);
 
+/**
+* mapGetStats: Returns the operation counters of a map, counted since the map
+* was created or since the last mapResetStats.
+* @param map - The map to get the counters of
+* @param stats - Set to the counters of the map, all zero if the map was
+* 		compiled without MAP_STATS
+* @return
+* 	MAP_NULL_ARGUMENT - if a NULL pointer was sent.
+* 	MAP_SUCCESS - Otherwise.
+*/
+MapResult mapGetStats(Map map, MapStats *stats);
+
+/**
+* mapResetStats: Sets all the operation counters of a map to zero.
+* @param map - The map to reset the counters of
+* @return
+* 	MAP_NULL_ARGUMENT - if a NULL pointer was sent.
+* 	MAP_SUCCESS - Otherwise.
+*/
+MapResult mapResetStats(Map map);
+
 /*!
 * Macro for iterating over a map.
 * Declares a new iterator for the loop.
@@ -239,4 +619,24 @@ MapResult mapClear(Map map);
         iterator ;\
         iterator = mapGetNext(map))
 
+/*!
+* Macro for iterating over the keys of a map between fromKey and toKey
+* (both included), in ascending order.
+* Declares a new iterator for the loop.
+*/
+#define MAP_FOREACH_RANGE(type, iterator, map, fromKey, toKey) \
+    for(type iterator = (type) mapGetFirstInRange(map, fromKey, toKey) ; \
+        iterator ;\
+        iterator = mapGetNextInRange(map, toKey))
+
+/*!
+* Macro for iterating over a map with a cursor (a MapCursor variable) instead
+* of the internal iterator.
+* Declares a new iterator for the loop.
+*/
+#define MAP_FOREACH_CURSOR(type, iterator, map, cursor) \
+    for(type iterator = (type) mapCursorFirst(map, &(cursor)) ; \
+        iterator ;\
+        iterator = mapCursorNext(map, &(cursor)))
+
 #endif /* MAP_H_ */
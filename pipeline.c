@@ -0,0 +1,875 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include "pipeline.h"
+#include "protocol.h"
+
+#define PIPELINE_BATCH 256
+#define PIPELINE_TABLE_SIZE 65536
+#define PIPELINE_TABLE_FILL 32768
+#define PIPELINE_MAX_QUEUE_CAPACITY (1<<20)
+#define PIPELINE_SPIN_ROUNDS 64
+#define PIPELINE_SLEEP_NANOSECONDS 50000
+#define CACHE_LINE 64
+#define NANO_IN_SECOND 1000000000LL
+#define NANO_IN_MILLISECOND 1000000LL
+
+/** A bounded single producer single consumer queue of pointers, head (the
+ *  next position of the producer) and tail (the next position of the
+ *  consumer) are on their own cache lines */
+typedef struct PipelineQueue_t{
+    void** items;
+    uint64_t mask;
+    char headPadding[CACHE_LINE-sizeof(void**)-sizeof(uint64_t)];
+    uint64_t head;
+    char tailPadding[CACHE_LINE-sizeof(uint64_t)];
+    uint64_t tail;
+    char endPadding[CACHE_LINE-sizeof(uint64_t)];
+}PipelineQueue;
+
+/** Submitted bytes on their way to a parser */
+typedef struct PipelineChunk_t{
+    int64_t submitted;
+    int size;
+    char data[];
+}*PipelineChunk;
+
+/** Votes (or sums of votes) on their way to the next stage. queued is when
+ *  the batch entered its queue and origin when its oldest vote was
+ *  submitted */
+typedef struct PipelineBatch_t{
+    int64_t queued;
+    int64_t origin;
+    int size;
+    EurovisionVote votes[PIPELINE_BATCH];
+}*PipelineBatch;
+
+/** The counters of one thread, in nanoseconds for the times. Only the thread
+ *  writes them, the padding keeps two threads off the same cache line */
+typedef struct PipelineCounters_t{
+    int64_t items;
+    int64_t batches;
+    int64_t busy;
+    int64_t stall;
+    int64_t latency;
+    int64_t maxLatency;
+    char padding[CACHE_LINE];
+}PipelineCounters;
+
+/** A (giver, taker) sum of an aggregator table, a free slot has count 0 */
+typedef struct PipelineSum_t{
+    int giver;
+    int taker;
+    int count;
+}PipelineSum;
+
+/** A thread of a stage. batches are the open batches of a parser (one per
+ *  aggregator), table and used the sums of an aggregator and the slots of
+ *  table in use, sorted the room to sort the sums before sending them,
+ *  marked the input queues that delivered the marker being
+ *  collected by an aggregator or the scorer */
+typedef struct PipelineWorker_t{
+    VotePipeline pipeline;
+    int index;
+    pthread_t thread;
+    bool started;
+    PipelineBatch* batches;
+    PipelineSum* table;
+    int* used;
+    PipelineSum* sorted;
+    int numOfUsed;
+    int64_t origin;
+    bool* marked;
+    PipelineCounters counters;
+}PipelineWorker;
+
+/** The aggregator queues are numOfAggregators rows of numOfParsers queues,
+ *  one per parser. workers are the parsers, the aggregators and the scorer
+ *  in this order. The markers are items that are not chunks or batches, they
+ *  go through every queue of a stage and each thread forwards them once it
+ *  got them from all of its input queues. failure is a VotePipelineResult,
+ *  VOTE_PIPELINE_SUCCESS until something failed. */
+struct VotePipeline_t{
+    Eurovision eurovision;
+    VotePipelineConfig config;
+    PipelineQueue* parserQueues;
+    PipelineQueue* aggregatorQueues;
+    PipelineQueue* scorerQueues;
+    PipelineWorker* workers;
+    int numOfWorkers;
+    int nextParser;
+    char flushMarker;
+    char stopMarker;
+    int failure;
+    pthread_mutex_t lock;
+    pthread_cond_t flushed;
+    long flushes;
+    Eurovision standings;
+    int64_t votes;
+    int64_t rejected;
+    int64_t refreshes;
+    int64_t standingsLatency;
+    int64_t maxStandingsLatency;
+    PipelineCounters submitter;
+};
+
+/** return the monotonic time in nanoseconds */
+int64_t pipelineNow();
+
+/** wait a little for a queue, yield the processor for the first rounds and
+ *  sleep after them */
+void pipelineBackoff(int *rounds);
+
+/** add value to a counter of the calling thread */
+void pipelineCount(int64_t *counter, int64_t value);
+
+/** add one batch of latency nanoseconds to counters */
+void pipelineCountLatency(PipelineCounters *counters, int64_t latency);
+
+/** record the first failure of the pipeline */
+void pipelineFail(VotePipeline pipeline, VotePipelineResult result);
+
+/** allocate the items of an empty queue of capacity (a power of 2) items,
+ *  return false on an allocation error */
+bool pipelineQueueInit(PipelineQueue *queue, uint64_t capacity);
+
+/** push item to queue, return false if it is full */
+bool pipelineQueuePush(PipelineQueue *queue, void *item);
+
+/** pop the first item of queue, return NULL if it is empty */
+void* pipelineQueuePop(PipelineQueue *queue);
+
+/** has the consumer of queue taken every item pushed to it */
+bool pipelineQueueIsEmpty(PipelineQueue *queue);
+
+/** push item to queue, waiting while it is full, and return the nanoseconds
+ *  waited, counted as stall in counters */
+int64_t pipelineSend(PipelineQueue *queue, void *item,
+                     PipelineCounters *counters);
+
+/** send the batch *batch (if any) to queue and forget it, return the
+ *  nanoseconds waited */
+int64_t pipelineSendBatch(PipelineQueue *queue, PipelineBatch *batch,
+                          PipelineCounters *counters);
+
+/** is item one of the markers of pipeline */
+bool pipelineIsMarker(VotePipeline pipeline, void *item);
+
+/** the parser thread: decode chunks into batches for the aggregators */
+void* pipelineParser(void* argument);
+
+/** decode the messages of chunk and send the votes to the aggregators */
+void pipelineParseChunk(PipelineWorker *worker, PipelineChunk chunk);
+
+/** the aggregator thread: sum the votes of its shard for the scorer */
+void* pipelineAggregator(void* argument);
+
+/** add the votes of batch to the table of the aggregator, return the
+ *  nanoseconds waited for the scorer (when the table got full) */
+int64_t pipelineAggregate(PipelineWorker *worker, PipelineBatch batch);
+
+/** compare two sums by (giver, taker) */
+int pipelineCompareSums(const void *sum1, const void *sum2);
+
+/** send the sums of the table of the aggregator to the scorer, in (giver,
+ *  taker) order so the scorer walks the votes of each state forward, and
+ *  empty the table, return the nanoseconds waited */
+int64_t pipelineSendSums(PipelineWorker *worker);
+
+/** the scorer thread: add the sums to the eurovision and refresh the
+ *  standings */
+void* pipelineScorer(void* argument);
+
+/** add the sums of batch to the eurovision */
+void pipelineScore(PipelineWorker *worker, PipelineBatch batch);
+
+/** replace the standings with a snapshot of the eurovision, origin is when
+ *  the oldest vote not in the standings yet was submitted */
+void pipelineRefresh(VotePipeline pipeline, int64_t origin);
+
+/** send the stop marker through the pipeline (on behalf of the threads that
+ *  were not started), wait for the threads and deallocate the pipeline */
+void pipelineStop(VotePipeline pipeline);
+
+/** sum the counters of the threads of a stage into stats */
+void pipelineSumStage(VotePipeline pipeline, int first, int numOfWorkers,
+                      VotePipelineStageStats *stats);
+
+int64_t pipelineNow(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec*NANO_IN_SECOND+now.tv_nsec;
+}
+
+void pipelineBackoff(int *rounds){
+    if(*rounds < PIPELINE_SPIN_ROUNDS){
+        (*rounds)++;
+        sched_yield();
+        return;
+    }
+    struct timespec pause = {0, PIPELINE_SLEEP_NANOSECONDS};
+    nanosleep(&pause, NULL);
+}
+
+void pipelineCount(int64_t *counter, int64_t value){
+    __atomic_store_n(counter, *counter+value, __ATOMIC_RELAXED);
+}
+
+void pipelineCountLatency(PipelineCounters *counters, int64_t latency){
+    pipelineCount(&counters->latency, latency);
+    if(latency > counters->maxLatency){
+        __atomic_store_n(&counters->maxLatency, latency, __ATOMIC_RELAXED);
+    }
+}
+
+void pipelineFail(VotePipeline pipeline, VotePipelineResult result){
+    int expected = VOTE_PIPELINE_SUCCESS;
+    __atomic_compare_exchange_n(&pipeline->failure, &expected, result, false,
+                                __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+bool pipelineQueueInit(PipelineQueue *queue, uint64_t capacity){
+    queue->items = malloc(sizeof(void*)*capacity);
+    queue->mask = capacity-1;
+    queue->head = 0;
+    queue->tail = 0;
+    return queue->items!=NULL;
+}
+
+bool pipelineQueuePush(PipelineQueue *queue, void *item){
+    uint64_t head = queue->head;
+    if(head-__atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE) > queue->mask){
+        return false;
+    }
+    queue->items[head & queue->mask] = item;
+    __atomic_store_n(&queue->head, head+1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void* pipelineQueuePop(PipelineQueue *queue){
+    uint64_t tail = queue->tail;
+    if(tail==__atomic_load_n(&queue->head, __ATOMIC_ACQUIRE)) return NULL;
+    void *item = queue->items[tail & queue->mask];
+    __atomic_store_n(&queue->tail, tail+1, __ATOMIC_RELEASE);
+    return item;
+}
+
+bool pipelineQueueIsEmpty(PipelineQueue *queue){
+    return __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE)==
+           __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+}
+
+int64_t pipelineSend(PipelineQueue *queue, void *item,
+                     PipelineCounters *counters){
+    if(pipelineQueuePush(queue, item)) return 0;
+    int64_t start = pipelineNow();
+    int rounds = 0;
+    while(!pipelineQueuePush(queue, item)){
+        pipelineBackoff(&rounds);
+    }
+    int64_t stall = pipelineNow()-start;
+    pipelineCount(&counters->stall, stall);
+    return stall;
+}
+
+int64_t pipelineSendBatch(PipelineQueue *queue, PipelineBatch *batch,
+                          PipelineCounters *counters){
+    if(!*batch) return 0;
+    (*batch)->queued = pipelineNow();
+    int64_t stall = pipelineSend(queue, *batch, counters);
+    *batch = NULL;
+    return stall;
+}
+
+bool pipelineIsMarker(VotePipeline pipeline, void *item){
+    return item==&pipeline->flushMarker||item==&pipeline->stopMarker;
+}
+
+void* pipelineParser(void* argument){
+    PipelineWorker *worker = argument;
+    VotePipeline pipeline = worker->pipeline;
+    int numOfParsers = pipeline->config.numOfParsers;
+    int numOfAggregators = pipeline->config.numOfAggregators;
+    PipelineQueue *input = pipeline->parserQueues+worker->index;
+    int rounds = 0;
+    while(true){
+        void *item = pipelineQueuePop(input);
+        if(!item){
+            pipelineBackoff(&rounds);
+            continue;
+        }
+        rounds = 0;
+        if(!pipelineIsMarker(pipeline, item)){
+            pipelineParseChunk(worker, item);
+            free(item);
+            continue;
+        }
+        for(int i=0; i<numOfAggregators; i++){
+            pipelineSend(pipeline->aggregatorQueues+i*numOfParsers+
+                         worker->index, item, &worker->counters);
+        }
+        if(item==&pipeline->stopMarker) return NULL;
+    }
+}
+
+void pipelineParseChunk(PipelineWorker *worker, PipelineChunk chunk){
+    VotePipeline pipeline = worker->pipeline;
+    int numOfParsers = pipeline->config.numOfParsers;
+    int numOfAggregators = pipeline->config.numOfAggregators;
+    int64_t start = pipelineNow(), stall = 0;
+    int64_t messages = 0, votes = 0, rejected = 0;
+    uint32_t offset = 0, size = (uint32_t)chunk->size;
+    while(size-offset >= sizeof(ProtocolHeader)){
+        ProtocolHeader header;
+        memcpy(&header, chunk->data+offset, sizeof(header));
+        offset += sizeof(header);
+        messages++;
+        if(header.size > size-offset){
+            rejected++;
+            offset = size;
+            break;
+        }
+        ProtocolReader payload = {chunk->data+offset, header.size, 0};
+        offset += header.size;
+        EurovisionVote vote = {0, 0, 1};
+        if(header.type!=PROTOCOL_ADD_VOTE||
+           !protocolReadInt(&payload, &vote.giver)||
+           !protocolReadInt(&payload, &vote.taker)||
+           !protocolReaderDone(&payload)||
+           vote.giver<0||vote.taker<0||vote.giver==vote.taker){
+            rejected++;
+            continue;
+        }
+        int aggregator = vote.giver%numOfAggregators;
+        PipelineBatch *batch = worker->batches+aggregator;
+        if(!*batch){
+            *batch = malloc(sizeof(**batch));
+            if(!*batch){
+                pipelineFail(pipeline, VOTE_PIPELINE_OUT_OF_MEMORY);
+                continue;
+            }
+            (*batch)->origin = chunk->submitted;
+            (*batch)->size = 0;
+        }
+        (*batch)->votes[(*batch)->size++] = vote;
+        votes++;
+        if((*batch)->size==PIPELINE_BATCH){
+            stall += pipelineSendBatch(pipeline->aggregatorQueues+
+                                       aggregator*numOfParsers+worker->index,
+                                       batch, &worker->counters);
+        }
+    }
+    if(offset<size){
+        messages++;
+        rejected++;
+    }
+    for(int i=0; i<numOfAggregators; i++){
+        stall += pipelineSendBatch(pipeline->aggregatorQueues+
+                                   i*numOfParsers+worker->index,
+                                   worker->batches+i, &worker->counters);
+    }
+    __atomic_fetch_add(&pipeline->votes, votes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&pipeline->rejected, rejected, __ATOMIC_RELAXED);
+    int64_t end = pipelineNow();
+    pipelineCount(&worker->counters.items, messages);
+    pipelineCount(&worker->counters.batches, 1);
+    pipelineCount(&worker->counters.busy, end-start-stall);
+    pipelineCountLatency(&worker->counters, end-chunk->submitted);
+}
+
+void* pipelineAggregator(void* argument){
+    PipelineWorker *worker = argument;
+    VotePipeline pipeline = worker->pipeline;
+    int numOfParsers = pipeline->config.numOfParsers;
+    PipelineQueue *inputs = pipeline->aggregatorQueues+
+                            worker->index*numOfParsers;
+    PipelineQueue *output = pipeline->scorerQueues+worker->index;
+    int64_t maxAge = pipeline->config.refreshMilliseconds*NANO_IN_MILLISECOND;
+    int numOfMarked = 0, rounds = 0;
+    while(true){
+        bool received = false;
+        for(int i=0; i<numOfParsers; i++){
+            if(worker->marked[i]) continue;
+            void *item = pipelineQueuePop(inputs+i);
+            if(!item) continue;
+            received = true;
+            if(!pipelineIsMarker(pipeline, item)){
+                PipelineBatch batch = item;
+                int64_t start = pipelineNow();
+                int64_t stall = pipelineAggregate(worker, batch);
+                int64_t end = pipelineNow();
+                pipelineCount(&worker->counters.items, batch->size);
+                pipelineCount(&worker->counters.batches, 1);
+                pipelineCount(&worker->counters.busy, end-start-stall);
+                pipelineCountLatency(&worker->counters, end-batch->queued);
+                free(batch);
+                continue;
+            }
+            worker->marked[i] = true;
+            if(++numOfMarked < numOfParsers) continue;
+            pipelineSendSums(worker);
+            pipelineSend(output, item, &worker->counters);
+            if(item==&pipeline->stopMarker) return NULL;
+            memset(worker->marked, 0, sizeof(bool)*numOfParsers);
+            numOfMarked = 0;
+        }
+        /* the sums are sent when they get old, and when the input is empty
+         * while the scorer waits for work */
+        bool aged = worker->numOfUsed>0 && maxAge>0 &&
+                    pipelineNow()-worker->origin >= maxAge;
+        bool idle = !received && worker->numOfUsed>0 &&
+                    pipelineQueueIsEmpty(output);
+        if(aged||idle){
+            int64_t start = pipelineNow();
+            int64_t stall = pipelineSendSums(worker);
+            pipelineCount(&worker->counters.busy, pipelineNow()-start-stall);
+            received = true;
+        }
+        if(received){
+            rounds = 0;
+            continue;
+        }
+        pipelineBackoff(&rounds);
+    }
+}
+
+int64_t pipelineAggregate(PipelineWorker *worker, PipelineBatch batch){
+    int64_t stall = 0;
+    if(worker->numOfUsed==0 || batch->origin < worker->origin){
+        worker->origin = batch->origin;
+    }
+    for(int i=0; i<batch->size; i++){
+        EurovisionVote *vote = batch->votes+i;
+        uint32_t hash = (uint32_t)vote->giver*2654435761u^
+                        (uint32_t)vote->taker*2246822519u;
+        uint32_t slot = hash&(PIPELINE_TABLE_SIZE-1);
+        PipelineSum *sum = worker->table+slot;
+        while(sum->count>0 &&
+              (sum->giver!=vote->giver||sum->taker!=vote->taker)){
+            slot = (slot+1)&(PIPELINE_TABLE_SIZE-1);
+            sum = worker->table+slot;
+        }
+        if(sum->count==0){
+            sum->giver = vote->giver;
+            sum->taker = vote->taker;
+            worker->used[worker->numOfUsed++] = (int)slot;
+        }
+        sum->count += vote->count;
+        if(sum->count==INT_MAX){
+            stall += pipelineSendSums(worker);
+            worker->origin = batch->origin;
+        }
+    }
+    if(worker->numOfUsed >= PIPELINE_TABLE_FILL){
+        stall += pipelineSendSums(worker);
+    }
+    return stall;
+}
+
+int pipelineCompareSums(const void *sum1, const void *sum2){
+    const PipelineSum *first = sum1, *second = sum2;
+    if(first->giver!=second->giver){
+        return first->giver < second->giver ? -1 : 1;
+    }
+    return (first->taker > second->taker)-(first->taker < second->taker);
+}
+
+int64_t pipelineSendSums(PipelineWorker *worker){
+    VotePipeline pipeline = worker->pipeline;
+    PipelineQueue *output = pipeline->scorerQueues+worker->index;
+    for(int i=0; i<worker->numOfUsed; i++){
+        PipelineSum *sum = worker->table+worker->used[i];
+        worker->sorted[i] = *sum;
+        sum->count = 0;
+    }
+    qsort(worker->sorted, worker->numOfUsed, sizeof(PipelineSum),
+          pipelineCompareSums);
+    PipelineBatch batch = NULL;
+    int64_t stall = 0;
+    for(int i=0; i<worker->numOfUsed; i++){
+        PipelineSum *sum = worker->sorted+i;
+        if(!batch){
+            batch = malloc(sizeof(*batch));
+            if(!batch){
+                pipelineFail(pipeline, VOTE_PIPELINE_OUT_OF_MEMORY);
+                continue;
+            }
+            batch->origin = worker->origin;
+            batch->size = 0;
+        }
+        batch->votes[batch->size++] = (EurovisionVote){sum->giver, sum->taker,
+                                                       sum->count};
+        if(batch->size==PIPELINE_BATCH){
+            stall += pipelineSendBatch(output, &batch, &worker->counters);
+        }
+    }
+    stall += pipelineSendBatch(output, &batch, &worker->counters);
+    worker->numOfUsed = 0;
+    return stall;
+}
+
+void* pipelineScorer(void* argument){
+    PipelineWorker *worker = argument;
+    VotePipeline pipeline = worker->pipeline;
+    int numOfAggregators = pipeline->config.numOfAggregators;
+    int64_t interval = pipeline->config.refreshMilliseconds*
+                       NANO_IN_MILLISECOND;
+    int64_t lastRefresh = pipelineNow();
+    int numOfMarked = 0, rounds = 0;
+    bool refreshed = false;
+    worker->origin = INT64_MAX;
+    while(true){
+        bool received = false;
+        for(int i=0; i<numOfAggregators; i++){
+            if(worker->marked[i]) continue;
+            void *item = pipelineQueuePop(pipeline->scorerQueues+i);
+            if(!item) continue;
+            received = true;
+            if(!pipelineIsMarker(pipeline, item)){
+                pipelineScore(worker, item);
+                free(item);
+                continue;
+            }
+            worker->marked[i] = true;
+            if(++numOfMarked < numOfAggregators) continue;
+            if(item==&pipeline->stopMarker) return NULL;
+            if(worker->origin!=INT64_MAX||!refreshed){
+                pipelineRefresh(pipeline, worker->origin);
+                worker->origin = INT64_MAX;
+                lastRefresh = pipelineNow();
+                refreshed = true;
+            }
+            pthread_mutex_lock(&pipeline->lock);
+            pipeline->flushes++;
+            pthread_cond_broadcast(&pipeline->flushed);
+            pthread_mutex_unlock(&pipeline->lock);
+            memset(worker->marked, 0, sizeof(bool)*numOfAggregators);
+            numOfMarked = 0;
+        }
+        if(interval>0 && worker->origin!=INT64_MAX &&
+           pipelineNow()-lastRefresh >= interval){
+            int64_t start = pipelineNow();
+            pipelineRefresh(pipeline, worker->origin);
+            worker->origin = INT64_MAX;
+            lastRefresh = pipelineNow();
+            refreshed = true;
+            pipelineCount(&worker->counters.busy, lastRefresh-start);
+        }
+        if(received){
+            rounds = 0;
+            continue;
+        }
+        pipelineBackoff(&rounds);
+    }
+}
+
+void pipelineScore(PipelineWorker *worker, PipelineBatch batch){
+    VotePipeline pipeline = worker->pipeline;
+    int64_t start = pipelineNow();
+    int64_t rejected = 0;
+    for(int i=0; i<batch->size && pipeline->eurovision; i++){
+        int skipped;
+        EurovisionResult result = eurovisionAddVotes(pipeline->eurovision,
+                                                     batch->votes+i, 1,
+                                                     &skipped);
+        if(result==EUROVISION_OUT_OF_MEMORY){
+            pipeline->eurovision = NULL;
+            pipelineFail(pipeline, VOTE_PIPELINE_EUROVISION_OUT_OF_MEMORY);
+        }
+        else if(skipped>0){
+            rejected += batch->votes[i].count;
+        }
+    }
+    if(batch->origin < worker->origin){
+        worker->origin = batch->origin;
+    }
+    __atomic_fetch_add(&pipeline->rejected, rejected, __ATOMIC_RELAXED);
+    int64_t end = pipelineNow();
+    pipelineCount(&worker->counters.items, batch->size);
+    pipelineCount(&worker->counters.batches, 1);
+    pipelineCount(&worker->counters.busy, end-start);
+    pipelineCountLatency(&worker->counters, end-batch->queued);
+}
+
+void pipelineRefresh(VotePipeline pipeline, int64_t origin){
+    if(!pipeline->eurovision) return;
+    Eurovision standings = eurovisionSnapshot(pipeline->eurovision);
+    /* the eurovision survives a failed snapshot, the old standings are kept
+     * until the next refresh */
+    if(!standings) return;
+    pthread_mutex_lock(&pipeline->lock);
+    Eurovision old = pipeline->standings;
+    pipeline->standings = standings;
+    pthread_mutex_unlock(&pipeline->lock);
+    eurovisionDestroy(old);
+    pipelineCount(&pipeline->refreshes, 1);
+    if(origin==INT64_MAX) return;
+    int64_t latency = pipelineNow()-origin;
+    pipelineCount(&pipeline->standingsLatency, latency);
+    if(latency > pipeline->maxStandingsLatency){
+        __atomic_store_n(&pipeline->maxStandingsLatency, latency,
+                         __ATOMIC_RELAXED);
+    }
+}
+
+void pipelineStop(VotePipeline pipeline){
+    int numOfParsers = pipeline->config.numOfParsers;
+    int numOfAggregators = pipeline->config.numOfAggregators;
+    PipelineWorker *workers = pipeline->workers;
+    PipelineWorker *aggregators = workers ? workers+numOfParsers : NULL;
+    PipelineWorker *scorer = workers ? aggregators+numOfAggregators : NULL;
+    void *stop = &pipeline->stopMarker;
+    for(int i=0; workers && i<numOfParsers; i++){
+        for(int j=0; !workers[i].started && j<numOfAggregators; j++){
+            if(aggregators[j].started){
+                pipelineSend(pipeline->aggregatorQueues+j*numOfParsers+i,
+                             stop, &pipeline->submitter);
+            }
+        }
+    }
+    for(int i=0; workers && i<numOfAggregators; i++){
+        if(!aggregators[i].started && scorer->started){
+            pipelineSend(pipeline->scorerQueues+i, stop,
+                         &pipeline->submitter);
+        }
+    }
+    for(int i=0; workers && i<numOfParsers; i++){
+        if(workers[i].started){
+            pipelineSend(pipeline->parserQueues+i, stop,
+                         &pipeline->submitter);
+        }
+    }
+    for(int i=0; workers && i<pipeline->numOfWorkers; i++){
+        if(workers[i].started){
+            pthread_join(workers[i].thread, NULL);
+        }
+    }
+    for(int i=0; workers && i<pipeline->numOfWorkers; i++){
+        PipelineWorker *worker = workers+i;
+        free(worker->batches);
+        free(worker->table);
+        free(worker->used);
+        free(worker->sorted);
+        free(worker->marked);
+    }
+    int numOfQueues[] = {numOfParsers, numOfParsers*numOfAggregators,
+                         numOfAggregators};
+    PipelineQueue *queues[] = {pipeline->parserQueues,
+                               pipeline->aggregatorQueues,
+                               pipeline->scorerQueues};
+    for(int i=0; i<3; i++){
+        for(int j=0; queues[i] && j<numOfQueues[i]; j++){
+            free(queues[i][j].items);
+        }
+        free(queues[i]);
+    }
+    eurovisionDestroy(pipeline->standings);
+    pthread_cond_destroy(&pipeline->flushed);
+    pthread_mutex_destroy(&pipeline->lock);
+    free(pipeline->workers);
+    free(pipeline);
+}
+
+void pipelineSumStage(VotePipeline pipeline, int first, int numOfWorkers,
+                      VotePipelineStageStats *stats){
+    int64_t items = 0, batches = 0, busy = 0, stall = 0, latency = 0;
+    int64_t maxLatency = 0;
+    for(int i=first; i<first+numOfWorkers; i++){
+        PipelineCounters *counters = &pipeline->workers[i].counters;
+        items += __atomic_load_n(&counters->items, __ATOMIC_RELAXED);
+        batches += __atomic_load_n(&counters->batches, __ATOMIC_RELAXED);
+        busy += __atomic_load_n(&counters->busy, __ATOMIC_RELAXED);
+        stall += __atomic_load_n(&counters->stall, __ATOMIC_RELAXED);
+        latency += __atomic_load_n(&counters->latency, __ATOMIC_RELAXED);
+        int64_t threadMax = __atomic_load_n(&counters->maxLatency,
+                                            __ATOMIC_RELAXED);
+        if(threadMax > maxLatency){
+            maxLatency = threadMax;
+        }
+    }
+    stats->items = (long)items;
+    stats->batches = (long)batches;
+    stats->busySeconds = (double)busy/NANO_IN_SECOND;
+    stats->stallSeconds = (double)stall/NANO_IN_SECOND;
+    stats->meanLatencySeconds = batches>0 ?
+            (double)latency/batches/NANO_IN_SECOND : 0;
+    stats->maxLatencySeconds = (double)maxLatency/NANO_IN_SECOND;
+}
+
+VotePipeline votePipelineCreate(Eurovision eurovision,
+                                VotePipelineConfig config){
+    if(!eurovision||config.numOfParsers<=0||config.numOfAggregators<=0||
+       config.queueCapacity<=0||
+       config.queueCapacity>PIPELINE_MAX_QUEUE_CAPACITY||
+       config.refreshMilliseconds<0){
+        return NULL;
+    }
+    VotePipeline pipeline = calloc(1, sizeof(*pipeline));
+    if(!pipeline) return NULL;
+    int numOfParsers = config.numOfParsers;
+    int numOfAggregators = config.numOfAggregators;
+    pipeline->eurovision = eurovision;
+    pipeline->config = config;
+    pipeline->failure = VOTE_PIPELINE_SUCCESS;
+    pipeline->numOfWorkers = numOfParsers+numOfAggregators+1;
+    pthread_mutex_init(&pipeline->lock, NULL);
+    pthread_cond_init(&pipeline->flushed, NULL);
+    pipeline->workers = calloc(pipeline->numOfWorkers,
+                               sizeof(PipelineWorker));
+    pipeline->parserQueues = calloc(numOfParsers, sizeof(PipelineQueue));
+    pipeline->aggregatorQueues = calloc(numOfParsers*numOfAggregators,
+                                        sizeof(PipelineQueue));
+    pipeline->scorerQueues = calloc(numOfAggregators, sizeof(PipelineQueue));
+    if(!pipeline->workers||!pipeline->parserQueues||
+       !pipeline->aggregatorQueues||!pipeline->scorerQueues){
+        pipelineStop(pipeline);
+        return NULL;
+    }
+    uint64_t capacity = 1;
+    while(capacity < (uint64_t)config.queueCapacity){
+        capacity *= 2;
+    }
+    bool allocated = true;
+    for(int i=0; i<numOfParsers; i++){
+        allocated = pipelineQueueInit(pipeline->parserQueues+i, capacity) &&
+                    allocated;
+    }
+    for(int i=0; i<numOfParsers*numOfAggregators; i++){
+        allocated = pipelineQueueInit(pipeline->aggregatorQueues+i,
+                                      capacity) && allocated;
+    }
+    for(int i=0; i<numOfAggregators; i++){
+        allocated = pipelineQueueInit(pipeline->scorerQueues+i, capacity) &&
+                    allocated;
+    }
+    for(int i=0; i<pipeline->numOfWorkers; i++){
+        PipelineWorker *worker = pipeline->workers+i;
+        worker->pipeline = pipeline;
+        if(i<numOfParsers){
+            worker->index = i;
+            worker->batches = calloc(numOfAggregators, sizeof(PipelineBatch));
+            allocated = worker->batches && allocated;
+        }
+        else if(i<numOfParsers+numOfAggregators){
+            worker->index = i-numOfParsers;
+            worker->table = calloc(PIPELINE_TABLE_SIZE, sizeof(PipelineSum));
+            worker->used = malloc(sizeof(int)*
+                                  (PIPELINE_TABLE_FILL+PIPELINE_BATCH));
+            worker->sorted = malloc(sizeof(PipelineSum)*
+                                    (PIPELINE_TABLE_FILL+PIPELINE_BATCH));
+            worker->marked = calloc(numOfParsers, sizeof(bool));
+            allocated = worker->table && worker->used && worker->sorted &&
+                        worker->marked && allocated;
+        }
+        else{
+            worker->marked = calloc(numOfAggregators, sizeof(bool));
+            allocated = worker->marked && allocated;
+        }
+    }
+    if(!allocated){
+        pipelineStop(pipeline);
+        return NULL;
+    }
+    /* the scorer first and the parsers last, so a stage only runs when the
+     * stages after it run */
+    for(int i=pipeline->numOfWorkers-1; i>=0; i--){
+        PipelineWorker *worker = pipeline->workers+i;
+        void* (*run)(void*) = i<numOfParsers ? pipelineParser :
+                              i<numOfParsers+numOfAggregators ?
+                              pipelineAggregator : pipelineScorer;
+        if(pthread_create(&worker->thread, NULL, run, worker)!=0){
+            pipelineStop(pipeline);
+            return NULL;
+        }
+        worker->started = true;
+    }
+    return pipeline;
+}
+
+void votePipelineDestroy(VotePipeline pipeline){
+    if(!pipeline) return;
+    pipelineStop(pipeline);
+}
+
+VotePipelineResult votePipelineSubmit(VotePipeline pipeline,
+                                      const char *data, int size){
+    if(!pipeline||!data) return VOTE_PIPELINE_NULL_ARGUMENT;
+    VotePipelineResult failure = __atomic_load_n(&pipeline->failure,
+                                                 __ATOMIC_RELAXED);
+    if(failure==VOTE_PIPELINE_EUROVISION_OUT_OF_MEMORY||size<=0){
+        return failure;
+    }
+    PipelineChunk chunk = malloc(sizeof(*chunk)+size);
+    if(!chunk) return VOTE_PIPELINE_OUT_OF_MEMORY;
+    memcpy(chunk->data, data, size);
+    chunk->size = size;
+    chunk->submitted = pipelineNow();
+    pipelineSend(pipeline->parserQueues+pipeline->nextParser, chunk,
+                 &pipeline->submitter);
+    pipeline->nextParser = (pipeline->nextParser+1)%
+                           pipeline->config.numOfParsers;
+    return __atomic_load_n(&pipeline->failure, __ATOMIC_RELAXED);
+}
+
+VotePipelineResult votePipelineFlush(VotePipeline pipeline){
+    if(!pipeline) return VOTE_PIPELINE_NULL_ARGUMENT;
+    pthread_mutex_lock(&pipeline->lock);
+    long flushes = pipeline->flushes;
+    pthread_mutex_unlock(&pipeline->lock);
+    for(int i=0; i<pipeline->config.numOfParsers; i++){
+        pipelineSend(pipeline->parserQueues+i, &pipeline->flushMarker,
+                     &pipeline->submitter);
+    }
+    pthread_mutex_lock(&pipeline->lock);
+    while(pipeline->flushes==flushes){
+        pthread_cond_wait(&pipeline->flushed, &pipeline->lock);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+    return __atomic_load_n(&pipeline->failure, __ATOMIC_RELAXED);
+}
+
+Eurovision votePipelineGetStandings(VotePipeline pipeline){
+    if(!pipeline) return NULL;
+    pthread_mutex_lock(&pipeline->lock);
+    Eurovision standings = NULL;
+    if(pipeline->standings){
+        standings = eurovisionSnapshot(pipeline->standings);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+    return standings;
+}
+
+VotePipelineResult votePipelineGetStats(VotePipeline pipeline,
+                                        VotePipelineStats *stats){
+    if(!pipeline||!stats) return VOTE_PIPELINE_NULL_ARGUMENT;
+    int numOfParsers = pipeline->config.numOfParsers;
+    int numOfAggregators = pipeline->config.numOfAggregators;
+    pipelineSumStage(pipeline, 0, numOfParsers,
+                     stats->stages+VOTE_PIPELINE_PARSE);
+    pipelineSumStage(pipeline, numOfParsers, numOfAggregators,
+                     stats->stages+VOTE_PIPELINE_AGGREGATE);
+    pipelineSumStage(pipeline, numOfParsers+numOfAggregators, 1,
+                     stats->stages+VOTE_PIPELINE_SCORE);
+    stats->votes = (long)__atomic_load_n(&pipeline->votes, __ATOMIC_RELAXED);
+    stats->rejected = (long)__atomic_load_n(&pipeline->rejected,
+                                            __ATOMIC_RELAXED);
+    int64_t refreshes = __atomic_load_n(&pipeline->refreshes,
+                                        __ATOMIC_RELAXED);
+    stats->refreshes = (long)refreshes;
+    stats->submitStallSeconds = (double)pipeline->submitter.stall/
+                                NANO_IN_SECOND;
+    stats->meanStandingsLatencySeconds = refreshes>0 ?
+            (double)__atomic_load_n(&pipeline->standingsLatency,
+                                    __ATOMIC_RELAXED)/refreshes/
+            NANO_IN_SECOND : 0;
+    stats->maxStandingsLatencySeconds =
+            (double)__atomic_load_n(&pipeline->maxStandingsLatency,
+                                    __ATOMIC_RELAXED)/NANO_IN_SECOND;
+    return VOTE_PIPELINE_SUCCESS;
+}
@@ -0,0 +1,187 @@
+#ifndef MTM_HW1_EUROVISION_PIPELINE_H
+#define MTM_HW1_EUROVISION_PIPELINE_H
+
+#include "eurovision.h"
+
+/**
+ * Vote Pipeline
+ *
+ * Ingests PROTOCOL_ADD_VOTE messages (see protocol.h) into a Eurovision on
+ * three stages of threads, so the caller only copies the bytes:
+ *
+ * parse     - parser threads decode the messages into votes and send each
+ *             vote to the aggregator of its giver.
+ * aggregate - aggregator threads add up the votes of each (giver, taker)
+ *             pair of their shard and send the sums on, when their table is
+ *             full, when they run out of input or when the sums get older
+ *             than the refresh interval.
+ * score     - one scorer thread adds the sums to the Eurovision with the
+ *             eurovisionAddVote rules, and refreshes the standings (a
+ *             eurovisionSnapshot) every refresh interval.
+ *
+ * The stages are connected by bounded single producer single consumer
+ * queues that need no locks. A stage waits while the queue it sends to is
+ * full, so a slow scorer slows down the submitter instead of using more
+ * memory (backpressure). Every stage counts what it processed, the time it
+ * was busy, the time it waited for a full queue and the latency of its
+ * batches (from entering its queue to being processed).
+ *
+ * Votes are only added, so the order in which the sums reach the Eurovision
+ * does not change the results: after votePipelineFlush the Eurovision is the
+ * same as if every vote was given to eurovisionAddVote.
+ *
+ * The Eurovision belongs to the pipeline from votePipelineCreate until
+ * votePipelineDestroy, and must not be used by the caller in between. A
+ * pipeline must be used by one thread at a time.
+ *
+ * The following functions are available:
+ *
+ * votePipelineCreate       - Start the threads of a new pipeline.
+ * votePipelineDestroy      - Add the remaining votes and stop a pipeline.
+ * votePipelineSubmit       - Queue a buffer of vote messages.
+ * votePipelineFlush        - Wait until every queued vote is added.
+ * votePipelineGetStandings - Return a copy of the latest standings.
+ * votePipelineGetStats     - Return the counters of the stages.
+*/
+
+/** Type for defining a Vote Pipeline */
+typedef struct VotePipeline_t *VotePipeline;
+
+/** The stages of a pipeline */
+typedef enum VotePipelineStage_t{
+    VOTE_PIPELINE_PARSE,
+    VOTE_PIPELINE_AGGREGATE,
+    VOTE_PIPELINE_SCORE,
+    VOTE_PIPELINE_NUM_OF_STAGES
+}VotePipelineStage;
+
+/** The shape of a pipeline, queueCapacity is the number of batches in each
+ *  queue (rounded up to a power of 2) and refreshMilliseconds the interval
+ *  between two refreshes of the standings, 0 to refresh them only on
+ *  votePipelineFlush */
+typedef struct VotePipelineConfig_t{
+    int numOfParsers;
+    int numOfAggregators;
+    int queueCapacity;
+    int refreshMilliseconds;
+}VotePipelineConfig;
+
+/** The counters of one stage, summed over its threads. items are the
+ *  messages parsed, the votes aggregated and the sums scored */
+typedef struct VotePipelineStageStats_t{
+    long items;
+    long batches;
+    double busySeconds;
+    double stallSeconds;
+    double meanLatencySeconds;
+    double maxLatencySeconds;
+}VotePipelineStageStats;
+
+/** The counters of a pipeline. votes are the votes the parsers decoded,
+ *  rejected the messages that are not whole PROTOCOL_ADD_VOTE messages and
+ *  the votes eurovisionAddVote would refuse, submitStallSeconds the time
+ *  votePipelineSubmit waited for the parsers, and the standings latency the
+ *  time from submitting a vote to the first refresh of the standings that
+ *  has it */
+typedef struct VotePipelineStats_t{
+    VotePipelineStageStats stages[VOTE_PIPELINE_NUM_OF_STAGES];
+    long votes;
+    long rejected;
+    long refreshes;
+    double submitStallSeconds;
+    double meanStandingsLatencySeconds;
+    double maxStandingsLatencySeconds;
+}VotePipelineStats;
+
+/** Type used for returning error codes from vote pipeline functions */
+typedef enum VotePipelineResult_t{
+    VOTE_PIPELINE_NULL_ARGUMENT,
+    VOTE_PIPELINE_OUT_OF_MEMORY,
+    VOTE_PIPELINE_EUROVISION_OUT_OF_MEMORY,
+    VOTE_PIPELINE_SUCCESS
+}VotePipelineResult;
+
+/**
+* votePipelineCreate: Start the threads of a new pipeline that adds votes to
+* eurovision
+*
+* @param eurovision - the eurovision, with its states and judges, it is used
+*                     by the pipeline until votePipelineDestroy
+* @param config - the number of threads of the stages, the size of the
+*                 queues and the refresh interval
+* @return
+* 	NULL - if eurovision is NULL, a number in config is not positive (or
+* 	       refreshMilliseconds is negative), allocations failed or a thread
+* 	       could not be started.
+* 	A new VotePipeline in case of success.
+*/
+VotePipeline votePipelineCreate(Eurovision eurovision,
+                                VotePipelineConfig config);
+
+/**
+* votePipelineDestroy: Add every queued vote to the eurovision, stop the
+* threads and deallocate the pipeline. The eurovision is the caller's again.
+*
+* @param pipeline - the pipeline to destroy, if NULL nothing will be done
+*/
+void votePipelineDestroy(VotePipeline pipeline);
+
+/**
+* votePipelineSubmit: Copy size bytes of PROTOCOL_ADD_VOTE messages to the
+* next parser, waits while its queue is full. The bytes must hold whole
+* messages, the other messages are rejected.
+*
+* @param pipeline - the pipeline
+* @param data - the messages
+* @param size - the number of bytes
+* @return
+* 	VOTE_PIPELINE_NULL_ARGUMENT - if pipeline or data is NULL
+* 	VOTE_PIPELINE_OUT_OF_MEMORY - in case of an allocation error of the
+* 	                              pipeline, some votes may have been lost
+* 	VOTE_PIPELINE_EUROVISION_OUT_OF_MEMORY - if the eurovision ran out of
+* 	                              memory, it was destroyed (like in the
+* 	                              eurovision functions) and no more votes
+* 	                              are added
+* 	VOTE_PIPELINE_SUCCESS - if the messages were queued
+*/
+VotePipelineResult votePipelineSubmit(VotePipeline pipeline,
+                                      const char *data, int size);
+
+/**
+* votePipelineFlush: Wait until every vote submitted so far is added to the
+* eurovision and the standings are refreshed
+*
+* @param pipeline - the pipeline
+* @return
+* 	the results of votePipelineSubmit, VOTE_PIPELINE_SUCCESS if every vote
+* 	was added
+*/
+VotePipelineResult votePipelineFlush(VotePipeline pipeline);
+
+/**
+* votePipelineGetStandings: Return a read only copy of the eurovision as it
+* was at the latest refresh of the standings, see eurovisionSnapshot. The
+* copy may be ranked while the pipeline keeps adding votes.
+*
+* @param pipeline - the pipeline
+* @return
+* 	NULL - if pipeline is NULL, the standings were not refreshed yet or
+* 	       allocations failed.
+* 	A new read only Eurovision the caller destroys in case of success.
+*/
+Eurovision votePipelineGetStandings(VotePipeline pipeline);
+
+/**
+* votePipelineGetStats: Return the counters of a pipeline, may be called
+* while it is running
+*
+* @param pipeline - the pipeline
+* @param stats - set to the counters
+* @return
+* 	VOTE_PIPELINE_NULL_ARGUMENT - if pipeline or stats is NULL
+* 	VOTE_PIPELINE_SUCCESS - otherwise
+*/
+VotePipelineResult votePipelineGetStats(VotePipeline pipeline,
+                                        VotePipelineStats *stats);
+
+#endif
@@ -0,0 +1,217 @@
+#include <stdlib.h>
+#include <string.h>
+#include "protocol.h"
+
+#define PROTOCOL_INITIAL_CAPACITY 4096
+#define PROTOCOL_NUM_OF_RESULTS PROTOCOL_RESULT_UNKNOWN
+
+/** The result of every wire code, by ProtocolResultCode */
+static const EurovisionResult protocolResults[PROTOCOL_NUM_OF_RESULTS] = {
+    EUROVISION_SUCCESS,
+    EUROVISION_NULL_ARGUMENT,
+    EUROVISION_OUT_OF_MEMORY,
+    EUROVISION_INVALID_ID,
+    EUROVISION_INVALID_NAME,
+    EUROVISION_STATE_ALREADY_EXIST,
+    EUROVISION_STATE_NOT_EXIST,
+    EUROVISION_JUDGE_ALREADY_EXIST,
+    EUROVISION_JUDGE_NOT_EXIST,
+    EUROVISION_SAME_STATE,
+    EUROVISION_INVALID_PERCENT,
+    EUROVISION_READ_ONLY,
+    EUROVISION_INVALID_ARGUMENT
+};
+
+struct ProtocolBuffer_t{
+    char* data;
+    uint32_t start;
+    uint32_t end;
+    uint32_t capacity;
+};
+
+ProtocolBuffer protocolBufferCreate(){
+    ProtocolBuffer buffer = malloc(sizeof(*buffer));
+    if(!buffer) return NULL;
+    buffer->data = NULL;
+    buffer->start = 0;
+    buffer->end = 0;
+    buffer->capacity = 0;
+    return buffer;
+}
+
+void protocolBufferDestroy(ProtocolBuffer buffer){
+    if(!buffer) return;
+    free(buffer->data);
+    free(buffer);
+}
+
+const char* protocolBufferGetData(ProtocolBuffer buffer){
+    return buffer ? buffer->data+buffer->start : NULL;
+}
+
+uint32_t protocolBufferGetSize(ProtocolBuffer buffer){
+    return buffer ? buffer->end-buffer->start : 0;
+}
+
+ProtocolResult protocolBufferReserve(ProtocolBuffer buffer, uint32_t size){
+    if(!buffer) return PROTOCOL_NULL_ARGUMENT;
+    if(buffer->end+size <= buffer->capacity) return PROTOCOL_SUCCESS;
+    uint32_t used = buffer->end-buffer->start;
+    if(buffer->start>0){
+        memmove(buffer->data, buffer->data+buffer->start, used);
+        buffer->start = 0;
+        buffer->end = used;
+        if(used+size <= buffer->capacity) return PROTOCOL_SUCCESS;
+    }
+    uint32_t capacity = buffer->capacity > 0 ? buffer->capacity*2 :
+                                               PROTOCOL_INITIAL_CAPACITY;
+    if(capacity < used+size){
+        capacity = used+size;
+    }
+    char* data = realloc(buffer->data, capacity);
+    if(!data) return PROTOCOL_OUT_OF_MEMORY;
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return PROTOCOL_SUCCESS;
+}
+
+char* protocolBufferGetSpace(ProtocolBuffer buffer, uint32_t *size){
+    if(!buffer||!size) return NULL;
+    *size = buffer->capacity-buffer->end;
+    return buffer->data+buffer->end;
+}
+
+void protocolBufferCommit(ProtocolBuffer buffer, uint32_t size){
+    if(!buffer) return;
+    buffer->end += size;
+}
+
+void protocolBufferConsume(ProtocolBuffer buffer, uint32_t size){
+    if(!buffer) return;
+    buffer->start += size;
+    if(buffer->start == buffer->end){
+        buffer->start = 0;
+        buffer->end = 0;
+    }
+}
+
+ProtocolResult protocolAppend(ProtocolBuffer buffer, const void *data,
+                              uint32_t size){
+    if(!buffer||!data) return PROTOCOL_NULL_ARGUMENT;
+    ProtocolResult result = protocolBufferReserve(buffer, size);
+    if(result!=PROTOCOL_SUCCESS) return result;
+    memcpy(buffer->data+buffer->end, data, size);
+    buffer->end += size;
+    return PROTOCOL_SUCCESS;
+}
+
+ProtocolResult protocolAppendHeader(ProtocolBuffer buffer, uint32_t type,
+                                    uint32_t size){
+    ProtocolHeader header = {type, size};
+    return protocolAppend(buffer, &header, sizeof(header));
+}
+
+ProtocolResult protocolAppendMessage(ProtocolBuffer buffer, uint32_t type,
+                                     const int32_t *ints, int numOfInts){
+    if(!buffer||(!ints && numOfInts>0)) return PROTOCOL_NULL_ARGUMENT;
+    uint32_t size = sizeof(int32_t)*numOfInts;
+    ProtocolResult result = protocolBufferReserve(buffer,
+                                                  sizeof(ProtocolHeader)+size);
+    if(result!=PROTOCOL_SUCCESS) return result;
+    protocolAppendHeader(buffer, type, size);
+    if(numOfInts>0){
+        protocolAppend(buffer, ints, size);
+    }
+    return PROTOCOL_SUCCESS;
+}
+
+ProtocolResult protocolAppendAddState(ProtocolBuffer buffer, int stateId,
+                                      const char *stateName,
+                                      const char *songName){
+    if(!buffer||!stateName||!songName) return PROTOCOL_NULL_ARGUMENT;
+    int32_t id = stateId;
+    uint32_t nameSize = strlen(stateName)+1, songSize = strlen(songName)+1;
+    uint32_t size = sizeof(id)+nameSize+songSize;
+    ProtocolResult result = protocolBufferReserve(buffer,
+                                                  sizeof(ProtocolHeader)+size);
+    if(result!=PROTOCOL_SUCCESS) return result;
+    protocolAppendHeader(buffer, PROTOCOL_ADD_STATE, size);
+    protocolAppend(buffer, &id, sizeof(id));
+    protocolAppend(buffer, stateName, nameSize);
+    protocolAppend(buffer, songName, songSize);
+    return PROTOCOL_SUCCESS;
+}
+
+ProtocolResult protocolAppendAddJudge(ProtocolBuffer buffer, int judgeId,
+                                      const char *judgeName,
+                                      const int *judgeResults){
+    if(!buffer||!judgeName||!judgeResults) return PROTOCOL_NULL_ARGUMENT;
+    int32_t ints[NUM_OF_JUDGE_RESULTS+1];
+    ints[0] = judgeId;
+    for(int i=0; i<NUM_OF_JUDGE_RESULTS; i++){
+        ints[i+1] = judgeResults[i];
+    }
+    uint32_t nameSize = strlen(judgeName)+1;
+    uint32_t size = sizeof(ints)+nameSize;
+    ProtocolResult result = protocolBufferReserve(buffer,
+                                                  sizeof(ProtocolHeader)+size);
+    if(result!=PROTOCOL_SUCCESS) return result;
+    protocolAppendHeader(buffer, PROTOCOL_ADD_JUDGE, size);
+    protocolAppend(buffer, ints, sizeof(ints));
+    protocolAppend(buffer, judgeName, nameSize);
+    return PROTOCOL_SUCCESS;
+}
+
+ProtocolResult protocolNextMessage(ProtocolBuffer buffer,
+                                   ProtocolHeader *header,
+                                   ProtocolReader *payload){
+    if(!buffer||!header||!payload) return PROTOCOL_NULL_ARGUMENT;
+    uint32_t available = buffer->end-buffer->start;
+    if(available < sizeof(ProtocolHeader)) return PROTOCOL_INCOMPLETE;
+    memcpy(header, buffer->data+buffer->start, sizeof(ProtocolHeader));
+    if(header->size > PROTOCOL_MAX_PAYLOAD) return PROTOCOL_BAD_MESSAGE;
+    if(available-sizeof(ProtocolHeader) < header->size){
+        return PROTOCOL_INCOMPLETE;
+    }
+    payload->data = buffer->data+buffer->start+sizeof(ProtocolHeader);
+    payload->size = header->size;
+    payload->offset = 0;
+    return PROTOCOL_SUCCESS;
+}
+
+bool protocolReadInt(ProtocolReader *reader, int *value){
+    if(!reader||!value) return false;
+    int32_t read;
+    if(reader->size-reader->offset < sizeof(read)) return false;
+    memcpy(&read, reader->data+reader->offset, sizeof(read));
+    reader->offset += sizeof(read);
+    *value = read;
+    return true;
+}
+
+bool protocolReadString(ProtocolReader *reader, const char **value){
+    if(!reader||!value) return false;
+    const char *start = reader->data+reader->offset;
+    const char *end = memchr(start, '\0', reader->size-reader->offset);
+    if(!end) return false;
+    *value = start;
+    reader->offset += (uint32_t)(end-start)+1;
+    return true;
+}
+
+bool protocolReaderDone(const ProtocolReader *reader){
+    return reader && reader->offset==reader->size;
+}
+
+uint32_t protocolResultEncode(EurovisionResult result){
+    for(int i=0; i<PROTOCOL_NUM_OF_RESULTS; i++){
+        if(protocolResults[i]==result) return (uint32_t)i;
+    }
+    return PROTOCOL_RESULT_UNKNOWN;
+}
+
+bool protocolResultDecode(uint32_t code, EurovisionResult *result){
+    if(!result||code>=PROTOCOL_NUM_OF_RESULTS) return false;
+    *result = protocolResults[code];
+    return true;
+}
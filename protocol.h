@@ -0,0 +1,355 @@
+#ifndef MTM_HW1_EUROVISION_PROTOCOL_H
+#define MTM_HW1_EUROVISION_PROTOCOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "judge.h"
+#include "eurovision.h"
+
+/**
+ * Vote Server Wire Protocol
+ *
+ * The messages the vote server and its clients exchange over a Unix domain
+ * socket. Every message is a ProtocolHeader followed by size bytes of
+ * payload. The socket is local, so the numbers are in the byte order of the
+ * machine. A client may send many requests without waiting (pipelining),
+ * the server answers every request with one response, in request order.
+ *
+ * The payloads of the requests are made of 32 bit ints and of strings
+ * ending with '\0':
+ *
+ * PROTOCOL_ADD_STATE             - stateId, stateName, songName
+ * PROTOCOL_REMOVE_STATE          - stateId
+ * PROTOCOL_ADD_JUDGE             - judgeId, 10 state ids, judgeName
+ * PROTOCOL_REMOVE_JUDGE          - judgeId
+ * PROTOCOL_ADD_VOTE              - stateGiver, stateTaker
+ * PROTOCOL_REMOVE_VOTE           - stateGiver, stateTaker
+ * PROTOCOL_RUN_CONTEST           - audiencePercent
+ * PROTOCOL_RUN_AUDIENCE_FAVORITE - nothing
+ * PROTOCOL_RUN_FRIENDLY_STATES   - nothing
+ *
+ * The type of a response is the ProtocolResultCode of the request, the
+ * EurovisionResult translated to a fixed wire code, so the codes on the
+ * socket do not move when EurovisionResult gets new values. The payload of
+ * the responses to the three queries is the number of names followed by the
+ * names, the payload of the other responses is empty.
+ *
+ * The following functions are available:
+ *
+ * protocolBufferCreate     - Allocate a new empty byte buffer.
+ * protocolBufferDestroy    - Deallocate a buffer.
+ * protocolBufferGetData    - Return the bytes in a buffer.
+ * protocolBufferGetSize    - Return the number of bytes in a buffer.
+ * protocolBufferReserve    - Make room for more bytes at the end of a buffer.
+ * protocolBufferGetSpace   - Return the free room at the end of a buffer.
+ * protocolBufferCommit     - Add bytes written to the free room.
+ * protocolBufferConsume    - Drop bytes from the start of a buffer.
+ * protocolAppend           - Append bytes to a buffer.
+ * protocolAppendHeader     - Append a message header to a buffer.
+ * protocolAppendMessage    - Append a message of ints to a buffer.
+ * protocolAppendAddState   - Append a PROTOCOL_ADD_STATE request.
+ * protocolAppendAddJudge   - Append a PROTOCOL_ADD_JUDGE request.
+ * protocolNextMessage      - Take the next complete message of a buffer.
+ * protocolReadInt          - Read an int of a payload.
+ * protocolReadString       - Read a string of a payload.
+ * protocolReaderDone       - Tell if a payload was read to its end.
+ * protocolResultEncode     - Translate a EurovisionResult to its wire code.
+ * protocolResultDecode     - Translate a wire code to its EurovisionResult.
+*/
+
+/** The largest payload of a message, bigger messages are bad messages */
+#define PROTOCOL_MAX_PAYLOAD (1<<24)
+
+/** Type of the requests */
+typedef enum ProtocolType_t{
+    PROTOCOL_ADD_STATE,
+    PROTOCOL_REMOVE_STATE,
+    PROTOCOL_ADD_JUDGE,
+    PROTOCOL_REMOVE_JUDGE,
+    PROTOCOL_ADD_VOTE,
+    PROTOCOL_REMOVE_VOTE,
+    PROTOCOL_RUN_CONTEST,
+    PROTOCOL_RUN_AUDIENCE_FAVORITE,
+    PROTOCOL_RUN_FRIENDLY_STATES,
+    PROTOCOL_NUM_OF_TYPES
+}ProtocolType;
+
+/** Type of the responses, the wire codes of the results. The values are
+ *  part of the protocol: never change one, add new codes at the end */
+typedef enum ProtocolResultCode_t{
+    PROTOCOL_RESULT_SUCCESS = 0,
+    PROTOCOL_RESULT_NULL_ARGUMENT = 1,
+    PROTOCOL_RESULT_OUT_OF_MEMORY = 2,
+    PROTOCOL_RESULT_INVALID_ID = 3,
+    PROTOCOL_RESULT_INVALID_NAME = 4,
+    PROTOCOL_RESULT_STATE_ALREADY_EXIST = 5,
+    PROTOCOL_RESULT_STATE_NOT_EXIST = 6,
+    PROTOCOL_RESULT_JUDGE_ALREADY_EXIST = 7,
+    PROTOCOL_RESULT_JUDGE_NOT_EXIST = 8,
+    PROTOCOL_RESULT_SAME_STATE = 9,
+    PROTOCOL_RESULT_INVALID_PERCENT = 10,
+    PROTOCOL_RESULT_READ_ONLY = 11,
+    PROTOCOL_RESULT_INVALID_ARGUMENT = 12,
+    PROTOCOL_RESULT_UNKNOWN = 13
+}ProtocolResultCode;
+
+/** The header of every message */
+typedef struct ProtocolHeader_t{
+    uint32_t type;
+    uint32_t size;
+}ProtocolHeader;
+
+/** A payload being read, offset is the first byte not read yet */
+typedef struct ProtocolReader_t{
+    const char *data;
+    uint32_t size;
+    uint32_t offset;
+}ProtocolReader;
+
+/** Type for defining a growable byte buffer */
+typedef struct ProtocolBuffer_t *ProtocolBuffer;
+
+/** Type used for returning error codes from protocol functions */
+typedef enum ProtocolResult_t{
+    PROTOCOL_NULL_ARGUMENT,
+    PROTOCOL_OUT_OF_MEMORY,
+    PROTOCOL_BAD_MESSAGE,
+    PROTOCOL_INCOMPLETE,
+    PROTOCOL_SUCCESS
+}ProtocolResult;
+
+/**
+* protocolBufferCreate: Allocates a new empty byte buffer
+*
+* @return
+* 	NULL - if allocations failed.
+* 	A new ProtocolBuffer in case of success.
+*/
+ProtocolBuffer protocolBufferCreate();
+
+/**
+* protocolBufferDestroy: Deallocate a byte buffer
+*
+* @param buffer - the buffer to deallocate, if NULL nothing will be done
+*/
+void protocolBufferDestroy(ProtocolBuffer buffer);
+
+/**
+* protocolBufferGetData: Return the bytes in a buffer, valid until the
+* buffer is changed
+*
+* @param buffer - the buffer
+* @return
+* 	NULL - if buffer is NULL
+* 	the first byte in the buffer otherwise
+*/
+const char* protocolBufferGetData(ProtocolBuffer buffer);
+
+/**
+* protocolBufferGetSize: Return the number of bytes in a buffer
+*
+* @param buffer - the buffer
+* @return
+* 	0 - if buffer is NULL
+* 	the number of bytes otherwise
+*/
+uint32_t protocolBufferGetSize(ProtocolBuffer buffer);
+
+/**
+* protocolBufferReserve: Make room for size more bytes at the end of a
+* buffer
+*
+* @param buffer - the buffer
+* @param size - the number of bytes
+* @return
+* 	PROTOCOL_NULL_ARGUMENT - if buffer is NULL
+* 	PROTOCOL_OUT_OF_MEMORY - in case of an allocation error
+* 	PROTOCOL_SUCCESS - otherwise
+*/
+ProtocolResult protocolBufferReserve(ProtocolBuffer buffer, uint32_t size);
+
+/**
+* protocolBufferGetSpace: Return the free room at the end of a buffer, for
+* reading into the buffer directly. The bytes written there are added to
+* the buffer by protocolBufferCommit.
+*
+* @param buffer - the buffer
+* @param size - set to the number of free bytes
+* @return
+* 	NULL - if buffer or size is NULL
+* 	the first free byte otherwise
+*/
+char* protocolBufferGetSpace(ProtocolBuffer buffer, uint32_t *size);
+
+/**
+* protocolBufferCommit: Add size bytes written to the free room of a buffer
+* to the end of the buffer
+*
+* @param buffer - the buffer
+* @param size - the number of bytes written, not more than the free room
+*/
+void protocolBufferCommit(ProtocolBuffer buffer, uint32_t size);
+
+/**
+* protocolBufferConsume: Drop size bytes from the start of a buffer
+*
+* @param buffer - the buffer
+* @param size - the number of bytes, not more than the size of the buffer
+*/
+void protocolBufferConsume(ProtocolBuffer buffer, uint32_t size);
+
+/**
+* protocolAppend: Append size bytes to the end of a buffer
+*
+* @param buffer - the buffer
+* @param data - the bytes to append
+* @param size - the number of bytes
+* @return
+* 	PROTOCOL_NULL_ARGUMENT - if buffer or data is NULL
+* 	PROTOCOL_OUT_OF_MEMORY - in case of an allocation error
+* 	PROTOCOL_SUCCESS - otherwise
+*/
+ProtocolResult protocolAppend(ProtocolBuffer buffer, const void *data,
+                              uint32_t size);
+
+/**
+* protocolAppendHeader: Append the header of a message, the caller appends
+* size bytes of payload after it
+*
+* @param buffer - the buffer
+* @param type - the ProtocolType of a request or the result of a response
+* @param size - the size of the payload
+* @return
+* 	PROTOCOL_NULL_ARGUMENT - if buffer is NULL
+* 	PROTOCOL_OUT_OF_MEMORY - in case of an allocation error
+* 	PROTOCOL_SUCCESS - otherwise
+*/
+ProtocolResult protocolAppendHeader(ProtocolBuffer buffer, uint32_t type,
+                                    uint32_t size);
+
+/**
+* protocolAppendMessage: Append a message whose payload is numOfInts ints,
+* like the vote requests, the query requests and the empty responses
+*
+* @param buffer - the buffer
+* @param type - the ProtocolType of a request or the result of a response
+* @param ints - the payload, may be NULL if numOfInts is 0
+* @param numOfInts - the number of ints
+* @return
+* 	PROTOCOL_NULL_ARGUMENT - if buffer is NULL, or ints is NULL and
+* 	                         numOfInts is not 0
+* 	PROTOCOL_OUT_OF_MEMORY - in case of an allocation error
+* 	PROTOCOL_SUCCESS - otherwise
+*/
+ProtocolResult protocolAppendMessage(ProtocolBuffer buffer, uint32_t type,
+                                     const int32_t *ints, int numOfInts);
+
+/**
+* protocolAppendAddState: Append a PROTOCOL_ADD_STATE request
+*
+* @param buffer - the buffer
+* @param stateId - the id of the state
+* @param stateName - the name of the state
+* @param songName - the name of the song
+* @return
+* 	PROTOCOL_NULL_ARGUMENT - if buffer, stateName or songName is NULL
+* 	PROTOCOL_OUT_OF_MEMORY - in case of an allocation error
+* 	PROTOCOL_SUCCESS - otherwise
+*/
+ProtocolResult protocolAppendAddState(ProtocolBuffer buffer, int stateId,
+                                      const char *stateName,
+                                      const char *songName);
+
+/**
+* protocolAppendAddJudge: Append a PROTOCOL_ADD_JUDGE request
+*
+* @param buffer - the buffer
+* @param judgeId - the id of the judge
+* @param judgeName - the name of the judge
+* @param judgeResults - the state ids of the judge results
+* @return
+* 	PROTOCOL_NULL_ARGUMENT - if buffer, judgeName or judgeResults is NULL
+* 	PROTOCOL_OUT_OF_MEMORY - in case of an allocation error
+* 	PROTOCOL_SUCCESS - otherwise
+*/
+ProtocolResult protocolAppendAddJudge(ProtocolBuffer buffer, int judgeId,
+                                      const char *judgeName,
+                                      const int *judgeResults);
+
+/**
+* protocolNextMessage: Take the next complete message from the start of a
+* buffer. The payload stays in the buffer, the caller reads it and then
+* drops the message with
+* protocolBufferConsume(buffer, sizeof(ProtocolHeader)+header->size).
+*
+* @param buffer - the buffer
+* @param header - set to the header of the message
+* @param payload - set to a reader of the payload of the message
+* @return
+* 	PROTOCOL_NULL_ARGUMENT - if an argument is NULL
+* 	PROTOCOL_INCOMPLETE - if the buffer does not hold a whole message yet
+* 	PROTOCOL_BAD_MESSAGE - if the payload is bigger than
+* 	                       PROTOCOL_MAX_PAYLOAD
+* 	PROTOCOL_SUCCESS - if header and payload were set
+*/
+ProtocolResult protocolNextMessage(ProtocolBuffer buffer,
+                                   ProtocolHeader *header,
+                                   ProtocolReader *payload);
+
+/**
+* protocolReadInt: Read the next int of a payload
+*
+* @param reader - the payload
+* @param value - set to the int
+* @return
+* 	false - if the payload has no more ints
+* 	true - if value was set
+*/
+bool protocolReadInt(ProtocolReader *reader, int *value);
+
+/**
+* protocolReadString: Read the next string of a payload
+*
+* @param reader - the payload
+* @param value - set to the string, it points into the payload
+* @return
+* 	false - if the payload has no more strings ending with '\0'
+* 	true - if value was set
+*/
+bool protocolReadString(ProtocolReader *reader, const char **value);
+
+/**
+* protocolReaderDone: Tell if every byte of a payload was read, a request
+* with bytes after its fields is not a valid message
+*
+* @param reader - the payload
+* @return
+* 	false - if reader is NULL or bytes are left after the read fields
+* 	true - if the whole payload was read
+*/
+bool protocolReaderDone(const ProtocolReader *reader);
+
+/**
+* protocolResultEncode: Translate the result of a request to the wire code of
+* its response
+*
+* @param result - the result
+* @return
+* 	PROTOCOL_RESULT_UNKNOWN - if result has no wire code
+* 	the wire code of result otherwise
+*/
+uint32_t protocolResultEncode(EurovisionResult result);
+
+/**
+* protocolResultDecode: Translate the wire code of a response to the result
+* of the request
+*
+* @param code - the type of the response
+* @param result - set to the result of the request
+* @return
+* 	false - if code is not a known result (result is not changed)
+* 	true - otherwise
+*/
+bool protocolResultDecode(uint32_t code, EurovisionResult *result);
+
+#endif
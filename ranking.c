@@ -0,0 +1,112 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "ranking.h"
+
+#define RANKING_MIN_ENTRIES 16
+#define RANKING_MIN_CHARS 256
+
+struct RankingResult_t{
+    RankingEntry* entries;
+    int numOfEntries;
+    int entriesCapacity;
+    char* names;
+    int namesLength;
+    int namesCapacity;
+};
+
+/** return the capacity to grow capacity to so it holds needed items:
+ *  needed or twice capacity, the larger, so a series of appends reallocates
+ *  O(log n) times */
+int rankingGrowCapacity(int capacity, int needed, int minimum);
+
+int rankingGrowCapacity(int capacity, int needed, int minimum){
+    int grown = capacity < minimum ? minimum :
+                capacity <= INT_MAX/2 ? capacity*2 : INT_MAX;
+    return grown > needed ? grown : needed;
+}
+
+RankingResult rankingCreate(){
+    RankingResult ranking = malloc(sizeof(*ranking));
+    if(!ranking) return NULL;
+    ranking->entries = NULL;
+    ranking->numOfEntries = 0;
+    ranking->entriesCapacity = 0;
+    ranking->names = NULL;
+    ranking->namesLength = 0;
+    ranking->namesCapacity = 0;
+    return ranking;
+}
+
+void rankingDestroy(RankingResult ranking){
+    if(!ranking) return;
+    free(ranking->entries);
+    free(ranking->names);
+    free(ranking);
+}
+
+void rankingClear(RankingResult ranking){
+    if(!ranking) return;
+    ranking->numOfEntries = 0;
+    ranking->namesLength = 0;
+}
+
+RankingStatus rankingReserve(RankingResult ranking, int numOfEntries,
+                             int numOfChars){
+    if(!ranking) return RANKING_NULL_ARGUMENT;
+    int entriesNeeded = ranking->numOfEntries+numOfEntries;
+    if(entriesNeeded > ranking->entriesCapacity){
+        int capacity = rankingGrowCapacity(ranking->entriesCapacity,
+                                           entriesNeeded,
+                                           RANKING_MIN_ENTRIES);
+        RankingEntry* entries = realloc(ranking->entries,
+                                        sizeof(RankingEntry)*capacity);
+        if(!entries) return RANKING_OUT_OF_MEMORY;
+        ranking->entries = entries;
+        ranking->entriesCapacity = capacity;
+    }
+    int charsNeeded = ranking->namesLength+numOfChars;
+    if(charsNeeded > ranking->namesCapacity){
+        int capacity = rankingGrowCapacity(ranking->namesCapacity,
+                                           charsNeeded, RANKING_MIN_CHARS);
+        char* names = realloc(ranking->names, sizeof(char)*capacity);
+        if(!names) return RANKING_OUT_OF_MEMORY;
+        ranking->names = names;
+        ranking->namesCapacity = capacity;
+    }
+    return RANKING_SUCCESS;
+}
+
+RankingStatus rankingAppend(RankingResult ranking, int id, double score,
+                            const char* name){
+    if(!ranking||!name) return RANKING_NULL_ARGUMENT;
+    int length = (int)strlen(name)+1;
+    if(ranking->numOfEntries == ranking->entriesCapacity ||
+       ranking->namesLength+length > ranking->namesCapacity){
+        RankingStatus result = rankingReserve(ranking, 1, length);
+        if(result != RANKING_SUCCESS) return result;
+    }
+    RankingEntry* entry = ranking->entries+ranking->numOfEntries;
+    entry->nameOffset = ranking->namesLength;
+    entry->id = id;
+    entry->score = score;
+    memcpy(ranking->names+ranking->namesLength, name, length);
+    ranking->namesLength += length;
+    ranking->numOfEntries++;
+    return RANKING_SUCCESS;
+}
+
+int rankingGetSize(RankingResult ranking){
+    if(!ranking) return -1;
+    return ranking->numOfEntries;
+}
+
+const RankingEntry* rankingGetEntries(RankingResult ranking){
+    if(!ranking||ranking->numOfEntries == 0) return NULL;
+    return ranking->entries;
+}
+
+const char* rankingGetName(RankingResult ranking, int index){
+    if(!ranking||index<0||index>=ranking->numOfEntries) return NULL;
+    return ranking->names+ranking->entries[index].nameOffset;
+}
@@ -0,0 +1,132 @@
+#ifndef MTM_HW1_EUROVISION_RANKING_H
+#define MTM_HW1_EUROVISION_RANKING_H
+
+/**
+ * Ranking Result Container
+ *
+ * Holds a full contest ranking in two contiguous buffers: an array of
+ * entries (one per state, in ranking order) and one buffer with all the
+ * states names, each entry points into it by offset. A RankingResult can be
+ * filled again and again, the buffers are only reallocated when they are
+ * too small.
+ *
+ * The following functions are available:
+ *
+ * rankingCreate     - Allocate a new empty ranking.
+ * rankingDestroy    - Deallocate a ranking.
+ * rankingClear      - Remove all the entries, keeps the buffers.
+ * rankingReserve    - Make room for a number of entries and name characters.
+ * rankingAppend     - Add an entry at the end of the ranking.
+ * rankingGetSize    - Return the number of entries.
+ * rankingGetEntries - Return the entries array.
+ * rankingGetName    - Return the name of an entry.
+*/
+
+/** One ranked state, nameOffset is the position of its name in the names
+ *  buffer of the ranking */
+typedef struct RankingEntry_t{
+    int nameOffset;
+    int id;
+    double score;
+}RankingEntry;
+
+/** Type for defining a Ranking Result */
+typedef struct RankingResult_t *RankingResult;
+
+/** Type used for returning error codes from ranking functions */
+typedef enum RankingStatus_t{
+    RANKING_NULL_ARGUMENT,
+    RANKING_OUT_OF_MEMORY,
+    RANKING_SUCCESS
+}RankingStatus;
+
+/**
+* rankingCreate: Allocates a new empty ranking
+*
+* @return
+* 	NULL - if allocations failed.
+* 	A new RankingResult in case of success.
+*/
+RankingResult rankingCreate();
+
+/**
+* rankingDestroy: Deallocate a ranking and its buffers
+*
+* @param ranking - the ranking to deallocate, if NULL nothing will be done
+*/
+void rankingDestroy(RankingResult ranking);
+
+/**
+* rankingClear: Remove all the entries of a ranking, the buffers are kept
+* for the next fill
+*
+* @param ranking - the ranking to clear
+*/
+void rankingClear(RankingResult ranking);
+
+/**
+* rankingReserve: Make sure the ranking can hold more entries and names
+* without reallocating. The buffers grow to at least twice their size, so
+* appending without reserving first is amortized O(1).
+*
+* @param ranking - the ranking to reserve room in
+* @param numOfEntries - the number of entries that will be appended
+* @param numOfChars - the total length of the names that will be appended,
+*                     including a '\0' for every name
+* @return
+* 	RANKING_NULL_ARGUMENT - if ranking is NULL
+* 	RANKING_OUT_OF_MEMORY - in case of an allocation error
+* 	RANKING_SUCCESS - otherwise
+*/
+RankingStatus rankingReserve(RankingResult ranking, int numOfEntries,
+                             int numOfChars);
+
+/**
+* rankingAppend: Add a state at the end of the ranking
+*
+* @param ranking - the ranking to append to
+* @param id - the state id
+* @param score - the state final score
+* @param name - the state name, copied into the names buffer
+* @return
+* 	RANKING_NULL_ARGUMENT - if ranking or name is NULL
+* 	RANKING_OUT_OF_MEMORY - in case of an allocation error
+* 	RANKING_SUCCESS - if the entry was added
+*/
+RankingStatus rankingAppend(RankingResult ranking, int id, double score,
+                            const char* name);
+
+/**
+* rankingGetSize: Return the number of entries in a ranking
+*
+* @param ranking - the ranking
+* @return
+* 	-1 - if ranking is NULL
+* 	the number of entries otherwise
+*/
+int rankingGetSize(RankingResult ranking);
+
+/**
+* rankingGetEntries: Return the entries of a ranking, the first entry is
+* the winner. The array is valid until the ranking is changed.
+*
+* @param ranking - the ranking
+* @return
+* 	NULL - if ranking is NULL or empty
+* 	the entries array otherwise
+*/
+const RankingEntry* rankingGetEntries(RankingResult ranking);
+
+/**
+* rankingGetName: Return the name of an entry of a ranking. The name is
+* valid until the ranking is changed.
+*
+* @param ranking - the ranking
+* @param index - the index of the entry
+* @return
+* 	NULL - if ranking is NULL or index is out of range
+* 	the name of the entry otherwise
+*/
+const char* rankingGetName(RankingResult ranking, int index);
+
+#endif
@@ -0,0 +1,325 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "eurovision.h"
+#include "generator.h"
+#include "votering.h"
+
+#define DEFAULT_PRODUCERS 3
+#define DEFAULT_STATES 200
+#define DEFAULT_VOTES 3000000
+#define DEFAULT_SKEW 1.0
+#define DEFAULT_SEED 1
+#define DEFAULT_CAPACITY 65536
+#define MAX_PRODUCERS 64
+#define MAX_RING_NAME 64
+#define NANO_IN_SECOND 1e9
+
+/** Options of one ring benchmark run */
+typedef struct RingBenchOptions_t{
+    GeneratorConfig config;
+    int producers;
+    int capacity;
+}RingBenchOptions;
+
+/** Result of one benchmark */
+typedef struct RingBenchCase_t{
+    const char *name;
+    long ops;
+    double seconds;
+}RingBenchCase;
+
+/** return the current monotonic time in seconds */
+double ringBenchNow();
+
+/** parse the command line into options, return false on bad arguments */
+bool ringBenchParseOptions(int argc, char **argv, RingBenchOptions *options);
+
+/** create a eurovision with the generated states and judges of config and
+ *  no votes */
+Eurovision ringBenchCreateEurovision(GeneratorConfig config);
+
+/** the number of votes producer number producer sends */
+int ringBenchShare(RingBenchOptions options, int producer);
+
+/** the producer process: push its share of the votes, drawn with its own
+ *  seed, to the ring name. Never returns */
+void ringBenchProduce(RingBenchOptions options, const char *name,
+                      int producer);
+
+/** add the votes with eurovisionAddVote in one process, the baseline */
+bool ringBenchDirect(RingBenchOptions options, RingBenchCase *result);
+
+/** push and pop every vote through a ring in one process, the cost of the
+ *  ring alone */
+bool ringBenchPushPop(RingBenchOptions options, RingBenchCase *result);
+
+/** drain the votes of options.producers producer processes into a
+ *  eurovision */
+bool ringBenchProducers(RingBenchOptions options, RingBenchCase *result);
+
+double ringBenchNow(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec+now.tv_nsec/NANO_IN_SECOND;
+}
+
+bool ringBenchParseOptions(int argc, char **argv, RingBenchOptions *options){
+    options->config.numOfStates = DEFAULT_STATES;
+    options->config.numOfJudges = 0;
+    options->config.numOfVotes = DEFAULT_VOTES;
+    options->config.voteSkew = DEFAULT_SKEW;
+    options->config.seed = DEFAULT_SEED;
+    options->producers = DEFAULT_PRODUCERS;
+    options->capacity = DEFAULT_CAPACITY;
+    for(int i=1; i<argc; i++){
+        if(i+1>=argc) return false;
+        char *option = argv[i];
+        char *value = argv[++i];
+        if(strcmp(option, "--producers")==0){
+            options->producers = atoi(value);
+        }
+        else if(strcmp(option, "--states")==0){
+            options->config.numOfStates = atoi(value);
+        }
+        else if(strcmp(option, "--votes")==0){
+            options->config.numOfVotes = atoi(value);
+        }
+        else if(strcmp(option, "--skew")==0){
+            options->config.voteSkew = atof(value);
+        }
+        else if(strcmp(option, "--seed")==0){
+            options->config.seed = strtoull(value, NULL, 10);
+        }
+        else if(strcmp(option, "--capacity")==0){
+            options->capacity = atoi(value);
+        }
+        else{
+            return false;
+        }
+    }
+    return options->producers>0 && options->producers<=MAX_PRODUCERS &&
+           options->capacity>0 && options->config.numOfVotes>=0;
+}
+
+Eurovision ringBenchCreateEurovision(GeneratorConfig config){
+    config.numOfVotes = 0;
+    Generator generator = generatorCreate(config);
+    Eurovision eurovision = eurovisionCreate();
+    if(!generator||!eurovision){
+        generatorDestroy(generator);
+        eurovisionDestroy(eurovision);
+        return NULL;
+    }
+    EurovisionResult result = generatorFillEurovision(generator, eurovision);
+    generatorDestroy(generator);
+    if(result!=EUROVISION_SUCCESS){
+        if(result!=EUROVISION_OUT_OF_MEMORY){
+            eurovisionDestroy(eurovision);
+        }
+        return NULL;
+    }
+    return eurovision;
+}
+
+int ringBenchShare(RingBenchOptions options, int producer){
+    int numOfVotes = options.config.numOfVotes;
+    return numOfVotes/options.producers+
+           (producer < numOfVotes%options.producers ? 1 : 0);
+}
+
+void ringBenchProduce(RingBenchOptions options, const char *name,
+                      int producer){
+    GeneratorConfig config = options.config;
+    config.seed += producer+1;
+    Generator generator = generatorCreate(config);
+    VoteRing ring = voteRingOpen(name);
+    if(!generator||!ring){
+        generatorDestroy(generator);
+        voteRingClose(ring);
+        _exit(1);
+    }
+    int share = ringBenchShare(options, producer);
+    for(int i=0; i<share; i++){
+        EurovisionVote vote = {0, 0, 1};
+        generatorNextVote(generator, &vote.giver, &vote.taker);
+        while(!voteRingPush(ring, &vote)){
+            sched_yield();
+        }
+    }
+    voteRingClose(ring);
+    generatorDestroy(generator);
+    _exit(0);
+}
+
+bool ringBenchDirect(RingBenchOptions options, RingBenchCase *result){
+    Eurovision eurovision = ringBenchCreateEurovision(options.config);
+    Generator generator = generatorCreate(options.config);
+    if(!eurovision||!generator){
+        eurovisionDestroy(eurovision);
+        generatorDestroy(generator);
+        return false;
+    }
+    int numOfVotes = options.config.numOfVotes;
+    double start = ringBenchNow();
+    for(int i=0; i<numOfVotes; i++){
+        int giver, taker;
+        generatorNextVote(generator, &giver, &taker);
+        EurovisionResult voteResult = eurovisionAddVote(eurovision, giver,
+                                                        taker);
+        if(voteResult!=EUROVISION_SUCCESS){
+            if(voteResult!=EUROVISION_OUT_OF_MEMORY){
+                eurovisionDestroy(eurovision);
+            }
+            generatorDestroy(generator);
+            return false;
+        }
+    }
+    result->name = "eurovision_add_vote";
+    result->ops = numOfVotes;
+    result->seconds = ringBenchNow()-start;
+    generatorDestroy(generator);
+    eurovisionDestroy(eurovision);
+    return true;
+}
+
+bool ringBenchPushPop(RingBenchOptions options, RingBenchCase *result){
+    char name[MAX_RING_NAME];
+    snprintf(name, sizeof(name), "/eurovision_ringbench_%ld_pop",
+             (long)getpid());
+    VoteRing ring = voteRingCreate(name, options.capacity);
+    if(!ring) return false;
+    EurovisionVote batch[VOTE_RING_BATCH];
+    int numOfVotes = options.config.numOfVotes;
+    long checksum = 0;
+    double start = ringBenchNow();
+    for(int pushed=0; pushed<numOfVotes; ){
+        EurovisionVote vote = {pushed, pushed+1, 1};
+        if(voteRingPush(ring, &vote)){
+            pushed++;
+            continue;
+        }
+        int popped = voteRingPop(ring, batch, VOTE_RING_BATCH);
+        for(int i=0; i<popped; i++){
+            checksum += batch[i].count;
+        }
+    }
+    int popped;
+    while((popped = voteRingPop(ring, batch, VOTE_RING_BATCH))>0){
+        for(int i=0; i<popped; i++){
+            checksum += batch[i].count;
+        }
+    }
+    result->name = "vote_ring_push_pop";
+    result->ops = numOfVotes;
+    result->seconds = ringBenchNow()-start;
+    voteRingClose(ring);
+    return checksum==numOfVotes;
+}
+
+bool ringBenchProducers(RingBenchOptions options, RingBenchCase *result){
+    char name[MAX_RING_NAME];
+    snprintf(name, sizeof(name), "/eurovision_ringbench_%ld",
+             (long)getpid());
+    Eurovision eurovision = ringBenchCreateEurovision(options.config);
+    VoteRing ring = voteRingCreate(name, options.capacity);
+    if(!eurovision||!ring){
+        eurovisionDestroy(eurovision);
+        voteRingClose(ring);
+        return false;
+    }
+    int numOfProducers = 0;
+    bool success = true;
+    fflush(stdout);
+    double start = ringBenchNow();
+    for(; numOfProducers<options.producers; numOfProducers++){
+        pid_t pid = fork();
+        if(pid==0){
+            ringBenchProduce(options, name, numOfProducers);
+        }
+        if(pid<0){
+            success = false;
+            break;
+        }
+    }
+    long expected = 0, drained = 0;
+    for(int i=0; i<numOfProducers; i++){
+        expected += ringBenchShare(options, i);
+    }
+    int running = numOfProducers;
+    while(success && drained<expected){
+        int numOfDrained;
+        EurovisionResult drainResult = voteRingDrain(ring, eurovision,
+                                                     (int)(expected-drained),
+                                                     &numOfDrained);
+        if(drainResult!=EUROVISION_SUCCESS){
+            if(drainResult==EUROVISION_OUT_OF_MEMORY){
+                eurovision = NULL;
+            }
+            success = false;
+            break;
+        }
+        drained += numOfDrained;
+        if(numOfDrained>0) continue;
+        if(running==0){
+            /* every producer exited and the ring is empty */
+            success = false;
+            break;
+        }
+        int status;
+        while(running>0 && waitpid(-1, &status, WNOHANG)>0){
+            running--;
+            if(!WIFEXITED(status)||WEXITSTATUS(status)!=0){
+                success = false;
+            }
+        }
+    }
+    double seconds = ringBenchNow()-start;
+    while(running>0 && waitpid(-1, NULL, 0)>0){
+        running--;
+    }
+    result->name = "vote_ring_drain";
+    result->ops = drained;
+    result->seconds = seconds;
+    voteRingClose(ring);
+    eurovisionDestroy(eurovision);
+    return success;
+}
+
+int main(int argc, char **argv){
+    RingBenchOptions options;
+    if(!ringBenchParseOptions(argc, argv, &options)){
+        fprintf(stderr, "usage: %s [--producers N] [--states N] [--votes N] "
+                        "[--skew X] [--seed N] [--capacity N]\n", argv[0]);
+        return 1;
+    }
+    RingBenchCase results[3];
+    int count = 0;
+    bool success = ringBenchDirect(options, results+count++) &&
+                   ringBenchPushPop(options, results+count++) &&
+                   ringBenchProducers(options, results+count++);
+    if(!success){
+        fprintf(stderr, "%s: the %s benchmark failed\n", argv[0],
+                count==1 ? "eurovision_add_vote" :
+                count==2 ? "vote_ring_push_pop" : "vote_ring_drain");
+        return 1;
+    }
+    printf("benchmark,producers,ops,ns_per_op,ops_per_sec\n");
+    for(int i=0; i<count; i++){
+        double nsPerOp = results[i].ops>0 ?
+                results[i].seconds*NANO_IN_SECOND/results[i].ops : 0;
+        double opsPerSec = results[i].seconds>0 ?
+                results[i].ops/results[i].seconds : 0;
+        printf("%s,%d,%ld,%.1f,%.1f\n", results[i].name,
+               i==count-1 ? options.producers : 0, results[i].ops, nsPerOp,
+               opsPerSec);
+    }
+    return 0;
+}
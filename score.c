@@ -0,0 +1,442 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "score.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCORE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#define SCORE_MIN_VALUE 10e-20
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define ID_PASSES 4
+#define SCORE_PASSES 8
+#define SCORE_MAX_THREADS 64
+
+/** Packed sort key of one state, index is its position in the score table */
+typedef struct ScoreKey_t{
+    uint64_t score;
+    uint32_t id;
+    int32_t index;
+}ScoreKey;
+
+/** The block of keys one task of scoreRankParallel sorts, tmp is a buffer
+ *  of the same size */
+typedef struct ScoreSortTask_t{
+    ScoreKey* keys;
+    ScoreKey* tmp;
+    int size;
+    bool byId;
+}ScoreSortTask;
+
+/** The part [from, to) of the merge of two sorted runs one task of
+ *  scoreRankParallel writes to out */
+typedef struct ScoreMergeTask_t{
+    const ScoreKey* first;
+    int firstSize;
+    const ScoreKey* second;
+    int secondSize;
+    int from;
+    int to;
+    ScoreKey* out;
+}ScoreMergeTask;
+
+/** scalar kernel of scoreCombine for the elements [from, size) */
+void scoreCombineScalar(const double* audience, const double* judges,
+                        double* total, int from, int size,
+                        double audienceDivider, double judgesDivider,
+                        double audienceP);
+
+/** transform a score to an unsigned key that sorts the highest score first */
+uint64_t scoreToKey(double score);
+
+/** one stable counting sort pass of the packed keys on the byte at shift,
+ *  return false if all the keys had the same byte and nothing was moved */
+bool scoreRadixPass(ScoreKey* src, ScoreKey* dest, int size,
+                    int shift, bool byId);
+
+/** sort size keys by (score, id) with radix passes, the ids passes are
+ *  skipped if byId is false (the keys are already in id order). The sorted
+ *  keys end in keys, tmp is a buffer of the same size */
+void scoreSortKeys(ScoreKey* keys, ScoreKey* tmp, int size, bool byId);
+
+/** fill the size keys of the states, return true if the ids are not in
+ *  ascending order (so the keys must be sorted by id too) */
+bool scoreFillKeys(const double* total, const int* ids, ScoreKey* keys,
+                   int size);
+
+/** is key1 before key2 in the ranking */
+bool scoreKeyLess(const ScoreKey* key1, const ScoreKey* key2);
+
+/** return how many keys of first are among the first position keys of the
+ *  merge of first and second */
+int scoreMergeSplit(const ScoreKey* first, int firstSize,
+                    const ScoreKey* second, int secondSize, int position);
+
+/** the pool function of a ScoreSortTask */
+void scoreSortTask(void* task);
+
+/** the pool function of a ScoreMergeTask */
+void scoreMergeTask(void* task);
+
+/** run the numOfTasks tasks of size taskSize in tasks on pool and wait for
+ *  them, a task that could not be submitted (or every task, if pool is
+ *  NULL) runs on the calling thread */
+void scoreRunTasks(ThreadPool pool, ThreadPoolTask run, void* tasks,
+                   size_t taskSize, int numOfTasks);
+
+#ifdef SCORE_X86_KERNELS
+/** AVX2 kernel of scoreCombine, return the number of elements handled */
+int scoreCombineAvx2(const double* audience, const double* judges,
+                     double* total, int size, double audienceDivider,
+                     double judgesDivider, double audienceP);
+
+/** SSE2 kernel of scoreCombine, return the number of elements handled */
+int scoreCombineSse2(const double* audience, const double* judges,
+                     double* total, int size, double audienceDivider,
+                     double judgesDivider, double audienceP);
+#endif
+
+void scoreCombineScalar(const double* audience, const double* judges,
+                        double* total, int from, int size,
+                        double audienceDivider, double judgesDivider,
+                        double audienceP){
+    for(int i=from; i<size; i++){
+        double audienceScore = audience[i]/audienceDivider;
+        double judgesScore = judges ? judges[i]/judgesDivider : 0;
+        double totalScore = (audienceScore*audienceP)+
+                            (judgesScore*(1-audienceP));
+        if(totalScore<SCORE_MIN_VALUE) {
+            totalScore = 0;
+        }
+        total[i] = totalScore;
+    }
+}
+
+#ifdef SCORE_X86_KERNELS
+__attribute__((target("avx2")))
+int scoreCombineAvx2(const double* audience, const double* judges,
+                     double* total, int size, double audienceDivider,
+                     double judgesDivider, double audienceP){
+    __m256d audienceDiv = _mm256_set1_pd(audienceDivider);
+    __m256d judgesDiv = _mm256_set1_pd(judgesDivider);
+    __m256d audienceWeight = _mm256_set1_pd(audienceP);
+    __m256d judgesWeight = _mm256_set1_pd(1-audienceP);
+    __m256d minValue = _mm256_set1_pd(SCORE_MIN_VALUE);
+    int i=0;
+    for(; i+4<=size; i+=4){
+        __m256d audienceScore = _mm256_div_pd(_mm256_loadu_pd(audience+i),
+                                              audienceDiv);
+        __m256d judgesScore = judges ?
+                _mm256_div_pd(_mm256_loadu_pd(judges+i), judgesDiv) :
+                _mm256_setzero_pd();
+        __m256d totalScore = _mm256_add_pd(
+                _mm256_mul_pd(audienceScore, audienceWeight),
+                _mm256_mul_pd(judgesScore, judgesWeight));
+        __m256d tooSmall = _mm256_cmp_pd(totalScore, minValue, _CMP_LT_OQ);
+        _mm256_storeu_pd(total+i, _mm256_andnot_pd(tooSmall, totalScore));
+    }
+    return i;
+}
+
+int scoreCombineSse2(const double* audience, const double* judges,
+                     double* total, int size, double audienceDivider,
+                     double judgesDivider, double audienceP){
+    __m128d audienceDiv = _mm_set1_pd(audienceDivider);
+    __m128d judgesDiv = _mm_set1_pd(judgesDivider);
+    __m128d audienceWeight = _mm_set1_pd(audienceP);
+    __m128d judgesWeight = _mm_set1_pd(1-audienceP);
+    __m128d minValue = _mm_set1_pd(SCORE_MIN_VALUE);
+    int i=0;
+    for(; i+2<=size; i+=2){
+        __m128d audienceScore = _mm_div_pd(_mm_loadu_pd(audience+i),
+                                           audienceDiv);
+        __m128d judgesScore = judges ?
+                _mm_div_pd(_mm_loadu_pd(judges+i), judgesDiv) :
+                _mm_setzero_pd();
+        __m128d totalScore = _mm_add_pd(
+                _mm_mul_pd(audienceScore, audienceWeight),
+                _mm_mul_pd(judgesScore, judgesWeight));
+        __m128d tooSmall = _mm_cmplt_pd(totalScore, minValue);
+        _mm_storeu_pd(total+i, _mm_andnot_pd(tooSmall, totalScore));
+    }
+    return i;
+}
+#endif
+
+ScoreResult scoreCombine(const double* audience, const double* judges,
+                         double* total, int size, int numOfStates,
+                         int numOfJudges, int audiencePercent){
+    if(!audience||!total) return SCORE_NULL_ARGUMENT;
+    double audienceDivider = (numOfStates>0) ? numOfStates : 1;
+    double judgesDivider = (numOfJudges>0) ? numOfJudges : 1;
+    double audienceP = (double)audiencePercent/100;
+    int done = 0;
+#ifdef SCORE_X86_KERNELS
+    if(__builtin_cpu_supports("avx2")){
+        done = scoreCombineAvx2(audience, judges, total, size,
+                                audienceDivider, judgesDivider, audienceP);
+    }
+    else if(__builtin_cpu_supports("sse2")){
+        done = scoreCombineSse2(audience, judges, total, size,
+                                audienceDivider, judgesDivider, audienceP);
+    }
+#endif
+    scoreCombineScalar(audience, judges, total, done, size,
+                       audienceDivider, judgesDivider, audienceP);
+    return SCORE_SUCCESS;
+}
+
+uint64_t scoreToKey(double score){
+    if(score == 0) score = 0;
+    uint64_t bits;
+    memcpy(&bits, &score, sizeof(bits));
+    if(bits & ((uint64_t)1 << 63)){
+        bits = ~bits;
+    }
+    else{
+        bits |= (uint64_t)1 << 63;
+    }
+    return ~bits;
+}
+
+bool scoreRadixPass(ScoreKey* src, ScoreKey* dest, int size,
+                    int shift, bool byId){
+    int count[RADIX_SIZE] = {0};
+    for(int i=0; i<size; i++){
+        uint64_t key = byId ? src[i].id : src[i].score;
+        count[(key >> shift) & (RADIX_SIZE-1)]++;
+    }
+    for(int i=0; i<RADIX_SIZE; i++){
+        if(count[i] == size) return false;
+    }
+    int position = 0;
+    for(int i=0; i<RADIX_SIZE; i++){
+        int tmp = count[i];
+        count[i] = position;
+        position += tmp;
+    }
+    for(int i=0; i<size; i++){
+        uint64_t key = byId ? src[i].id : src[i].score;
+        dest[count[(key >> shift) & (RADIX_SIZE-1)]++] = src[i];
+    }
+    return true;
+}
+
+void scoreSortKeys(ScoreKey* keys, ScoreKey* tmp, int size, bool byId){
+    ScoreKey* src = keys;
+    ScoreKey* dest = tmp;
+    for(int pass=byId ? 0 : ID_PASSES; pass<ID_PASSES+SCORE_PASSES; pass++){
+        bool idPass = pass<ID_PASSES;
+        int shift = (idPass ? pass : pass-ID_PASSES)*RADIX_BITS;
+        if(scoreRadixPass(src, dest, size, shift, idPass)){
+            ScoreKey* swap = src;
+            src = dest;
+            dest = swap;
+        }
+    }
+    if(src!=keys){
+        memcpy(keys, src, sizeof(*keys)*size);
+    }
+}
+
+bool scoreFillKeys(const double* total, const int* ids, ScoreKey* keys,
+                   int size){
+    bool byId = false;
+    for(int i=0; i<size; i++){
+        keys[i].score = scoreToKey(total[i]);
+        keys[i].id = (uint32_t)ids[i] ^ ((uint32_t)1 << 31);
+        keys[i].index = i;
+        byId = byId || (i>0 && keys[i-1].id > keys[i].id);
+    }
+    return byId;
+}
+
+bool scoreKeyLess(const ScoreKey* key1, const ScoreKey* key2){
+    return key1->score < key2->score ||
+           (key1->score == key2->score && key1->id < key2->id);
+}
+
+int scoreMergeSplit(const ScoreKey* first, int firstSize,
+                    const ScoreKey* second, int secondSize, int position){
+    int low = position>secondSize ? position-secondSize : 0;
+    int high = position<firstSize ? position : firstSize;
+    while(low<high){
+        int taken = low+(high-low)/2;
+        if(scoreKeyLess(second+position-taken-1, first+taken)){
+            high = taken;
+        }
+        else{
+            low = taken+1;
+        }
+    }
+    return low;
+}
+
+void scoreSortTask(void* task){
+    ScoreSortTask* sort = task;
+    scoreSortKeys(sort->keys, sort->tmp, sort->size, sort->byId);
+}
+
+void scoreMergeTask(void* task){
+    ScoreMergeTask* merge = task;
+    int i = scoreMergeSplit(merge->first, merge->firstSize, merge->second,
+                            merge->secondSize, merge->from);
+    int j = merge->from-i;
+    int iEnd = scoreMergeSplit(merge->first, merge->firstSize, merge->second,
+                               merge->secondSize, merge->to);
+    int jEnd = merge->to-iEnd;
+    ScoreKey* out = merge->out+merge->from;
+    while(i<iEnd && j<jEnd){
+        if(scoreKeyLess(merge->second+j, merge->first+i)){
+            *out++ = merge->second[j++];
+        }
+        else{
+            *out++ = merge->first[i++];
+        }
+    }
+    while(i<iEnd){
+        *out++ = merge->first[i++];
+    }
+    while(j<jEnd){
+        *out++ = merge->second[j++];
+    }
+}
+
+void scoreRunTasks(ThreadPool pool, ThreadPoolTask run, void* tasks,
+                   size_t taskSize, int numOfTasks){
+    for(int i=0; i<numOfTasks; i++){
+        void* task = (char*)tasks+i*taskSize;
+        if(!pool||threadPoolSubmit(pool, run, task)!=THREAD_POOL_SUCCESS){
+            run(task);
+        }
+    }
+    threadPoolWait(pool);
+}
+
+ScoreResult scoreRank(const double* total, const int* ids, int* order,
+                      int size){
+    return scoreRankParallel(total, ids, order, size, NULL);
+}
+
+size_t scoreRankBufferSize(int size){
+    return size>0 ? sizeof(ScoreKey)*size*2 : 0;
+}
+
+ScoreResult scoreRankInBuffer(const double* total, const int* ids,
+                              int* order, int size, void* buffer){
+    if(!total||!ids||!order) return SCORE_NULL_ARGUMENT;
+    if(size<=0) return SCORE_SUCCESS;
+    if(!buffer) return SCORE_NULL_ARGUMENT;
+    ScoreKey* keys = buffer;
+    bool byId = scoreFillKeys(total, ids, keys, size);
+    scoreSortKeys(keys, keys+size, size, byId);
+    for(int i=0; i<size; i++){
+        order[i] = keys[i].index;
+    }
+    return SCORE_SUCCESS;
+}
+
+ScoreResult scoreRankParallel(const double* total, const int* ids,
+                              int* order, int size, ThreadPool pool){
+    if(!total||!ids||!order) return SCORE_NULL_ARGUMENT;
+    if(size<=0) return SCORE_SUCCESS;
+    /* one block per worker of the pool */
+    int numOfThreads = threadPoolGetSize(pool);
+    if(numOfThreads>SCORE_MAX_THREADS) numOfThreads = SCORE_MAX_THREADS;
+    if(numOfThreads>size) numOfThreads = size;
+    if(numOfThreads<1) numOfThreads = 1;
+    ScoreKey* keys = malloc(sizeof(*keys)*size*2);
+    if(!keys) return SCORE_OUT_OF_MEMORY;
+    ScoreKey* tmp = keys+size;
+    /* the id passes are only needed if the ids are not ascending already,
+     * as in the states table */
+    bool byId = scoreFillKeys(total, ids, keys, size);
+    /* every worker sorts a block, then the sorted runs are merged in pairs,
+     * every merge split between the workers, until one run is left */
+    int bounds[SCORE_MAX_THREADS+1];
+    ScoreSortTask sorts[SCORE_MAX_THREADS];
+    for(int i=0; i<=numOfThreads; i++){
+        bounds[i] = (int)((long long)size*i/numOfThreads);
+    }
+    for(int i=0; i<numOfThreads; i++){
+        sorts[i] = (ScoreSortTask){keys+bounds[i], tmp+bounds[i],
+                                   bounds[i+1]-bounds[i], byId};
+    }
+    scoreRunTasks(pool, scoreSortTask, sorts, sizeof(*sorts), numOfThreads);
+    ScoreKey* src = keys;
+    ScoreKey* dest = tmp;
+    for(int width=1; width<numOfThreads; width*=2){
+        ScoreMergeTask merges[SCORE_MAX_THREADS];
+        int numOfMerges = 0;
+        int numOfPairs = (numOfThreads+2*width-1)/(2*width);
+        int parts = numOfThreads/numOfPairs;
+        for(int block=0; block<numOfThreads; block+=2*width){
+            int start = bounds[block];
+            int middle = bounds[block+width<numOfThreads ?
+                                block+width : numOfThreads];
+            int end = bounds[block+2*width<numOfThreads ?
+                             block+2*width : numOfThreads];
+            for(int part=0; part<parts; part++){
+                merges[numOfMerges++] = (ScoreMergeTask){
+                        src+start, middle-start, src+middle, end-middle,
+                        (int)((long long)(end-start)*part/parts),
+                        (int)((long long)(end-start)*(part+1)/parts),
+                        dest+start};
+            }
+        }
+        scoreRunTasks(pool, scoreMergeTask, merges, sizeof(*merges),
+                      numOfMerges);
+        ScoreKey* swap = src;
+        src = dest;
+        dest = swap;
+    }
+    for(int i=0; i<size; i++){
+        order[i] = src[i].index;
+    }
+    free(keys);
+    return SCORE_SUCCESS;
+}
+
+bool scoreTopVotesBefore(int votes1, int state1, int votes2, int state2){
+    if(votes1 != votes2) return votes1 > votes2;
+    return state1 < state2;
+}
+
+void scoreTopVotesInsert(int topStates[SCORE_TOP_VOTES],
+                         int topVotes[SCORE_TOP_VOTES], int *numOfTop,
+                         int state, int votes){
+    int low = 0, high = *numOfTop;
+    while(low < high){
+        int middle = low+(high-low)/2;
+        if(scoreTopVotesBefore(topVotes[middle], topStates[middle], votes,
+                               state)){
+            low = middle+1;
+        }
+        else{
+            high = middle;
+        }
+    }
+    if(low >= SCORE_TOP_VOTES) return;
+    int toMove = *numOfTop-low;
+    if(*numOfTop == SCORE_TOP_VOTES){
+        toMove--;
+    }
+    else{
+        (*numOfTop)++;
+    }
+    memmove(topStates+low+1, topStates+low, sizeof(int)*toMove);
+    memmove(topVotes+low+1, topVotes+low, sizeof(int)*toMove);
+    topStates[low] = state;
+    topVotes[low] = votes;
+}
+
+int scoreTopVotesPoints(int place){
+    static const int points[SCORE_TOP_VOTES] = {12, 10, 8, 7, 6, 5, 4, 3, 2,
+                                                1};
+    return place>=0 && place<SCORE_TOP_VOTES ? points[place] : 0;
+}
@@ -0,0 +1,184 @@
+#ifndef MTM_HW1_EUROVISION_SCORE_H
+#define MTM_HW1_EUROVISION_SCORE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "threadpool.h"
+
+/**
+ * Eurovision Score Kernels
+ *
+ * Works on a structure-of-arrays score table: every column (ids, audience
+ * scores, judges scores, final scores) is a separate contiguous array and
+ * index i of every column describes the same state.
+ *
+ * The following functions are available:
+ *
+ * scoreCombine      - Blend the audience and judges columns into final
+ *                     scores. Uses an AVX2 or SSE2 kernel when the cpu
+ *                     supports it and a scalar loop otherwise, all of them
+ *                     give the same result.
+ * scoreRank         - Order the states by final score (highest first) and
+ *                     by id (lowest first) on equal scores.
+ * scoreRankParallel - Like scoreRank on the workers of a thread pool.
+ * scoreRankInBuffer - Like scoreRank on the calling thread, in a buffer of
+ *                     the caller instead of a new allocation.
+ * scoreRankBufferSize - Return the size of the buffer of scoreRankInBuffer.
+ * scoreTopVotesBefore - Is a vote before another in the top votes of a
+ *                       voter.
+ * scoreTopVotesInsert - Insert a vote to its place in the top votes of a
+ *                       voter.
+ * scoreTopVotesPoints - Return the points of a place in the top votes.
+*/
+
+/** The number of states every voter gives points to */
+#define SCORE_TOP_VOTES 10
+
+/** Type used for returning error codes from score functions */
+typedef enum ScoreResult_t{
+    SCORE_NULL_ARGUMENT,
+    SCORE_OUT_OF_MEMORY,
+    SCORE_SUCCESS
+}ScoreResult;
+
+/**
+* scoreCombine: Calculate the final score of every state
+*
+* final[i] = (audience[i]/numOfStates)*(audiencePercent/100) +
+*            (judges[i]/numOfJudges)*(1-audiencePercent/100)
+* A divider that is not positive is treated as 1, and a final score smaller
+* than 10e-20 is set to 0.
+*
+* @param audience - the audience score of each state.
+* @param judges - the judges score of each state, NULL if there are no judges
+*                 scores (treated as all 0).
+* @param total - array to fill with the final score of each state.
+* @param size - the length of the arrays.
+* @param numOfStates - divider of the audience scores.
+* @param numOfJudges - divider of the judges scores.
+* @param audiencePercent - the weight of the audience in percents.
+* @return
+* 	SCORE_NULL_ARGUMENT - if audience or total is NULL
+* 	SCORE_SUCCESS - if total was filled
+*/
+ScoreResult scoreCombine(const double* audience, const double* judges,
+                         double* total, int size, int numOfStates,
+                         int numOfJudges, int audiencePercent);
+
+/**
+* scoreRank: Sort the states by their final score
+*
+* Sorts packed (final score, id) keys with a radix sort on the calling
+* thread, the highest score is first and equal scores are ordered by
+* ascending id.
+*
+* @param total - the final score of each state.
+* @param ids - the id of each state.
+* @param order - array to fill with the indexes of the states in ranking
+*                order, order[0] is the index of the winner.
+* @param size - the length of the arrays.
+* @return
+* 	SCORE_NULL_ARGUMENT - if one of the arrays is NULL
+* 	SCORE_OUT_OF_MEMORY - in case of an allocation error
+* 	SCORE_SUCCESS - if order was filled
+*/
+ScoreResult scoreRank(const double* total, const int* ids, int* order,
+                      int size);
+
+/**
+* scoreRankParallel: Sort the states by their final score on the workers of
+* a thread pool
+*
+* The keys are split into one block per worker. Every block is radix
+* sorted, then the sorted blocks are merged in pairs, each merge split
+* between the workers, until one block is left. The order is the same as
+* the order of scoreRank. No speedup over scoreRank was measured on the
+* benchmark, so nothing ranks in parallel unless its caller asks for it.
+*
+* @param total - the final score of each state.
+* @param ids - the id of each state.
+* @param order - array to fill with the indexes of the states in ranking
+*                order, order[0] is the index of the winner.
+* @param size - the length of the arrays.
+* @param pool - the pool to sort on, at most 64 of its workers are used.
+*               NULL sorts on the calling thread only. The function waits
+*               for the tasks of the pool, so it must not run on a worker of
+*               the same pool.
+* @return
+* 	SCORE_NULL_ARGUMENT - if one of the arrays is NULL
+* 	SCORE_OUT_OF_MEMORY - in case of an allocation error
+* 	SCORE_SUCCESS - if order was filled
+*/
+ScoreResult scoreRankParallel(const double* total, const int* ids,
+                              int* order, int size, ThreadPool pool);
+
+/**
+* scoreRankInBuffer: Sort the states by their final score like scoreRank, on
+* the calling thread and without allocating, for callers that rank many
+* times
+*
+* @param total - the final score of each state.
+* @param ids - the id of each state.
+* @param order - array to fill with the indexes of the states in ranking
+*                order, order[0] is the index of the winner.
+* @param size - the length of the arrays.
+* @param buffer - scoreRankBufferSize(size) bytes to sort in.
+* @return
+* 	SCORE_NULL_ARGUMENT - if one of the arrays (or buffer, when size is
+* 	                      positive) is NULL
+* 	SCORE_SUCCESS - if order was filled
+*/
+ScoreResult scoreRankInBuffer(const double* total, const int* ids,
+                              int* order, int size, void* buffer);
+
+/**
+* scoreRankBufferSize: Return the size of the buffer scoreRankInBuffer needs
+*
+* @param size - the number of states
+* @return
+* 	the number of bytes, 0 if size is not positive
+*/
+size_t scoreRankBufferSize(int size);
+
+/**
+* scoreTopVotesBefore: Is a vote before another in the top votes of a voter:
+* more votes first, and the lower state (id or index) first on equal votes
+*
+* @param votes1 - the number of votes of the first vote
+* @param state1 - the state of the first vote
+* @param votes2 - the number of votes of the second vote
+* @param state2 - the state of the second vote
+* @return
+* 	true - if the first vote is before the second
+* 	false - otherwise
+*/
+bool scoreTopVotesBefore(int votes1, int state1, int votes2, int state2);
+
+/**
+* scoreTopVotesInsert: Insert a vote to its place in the numOfTop sorted
+* votes of a voter. When the top votes are full the last vote is dropped,
+* and a vote that would be after all of them is not inserted.
+*
+* @param topStates - the states of the top votes, in scoreTopVotesBefore
+*                    order.
+* @param topVotes - the number of votes of each state of topStates.
+* @param numOfTop - the number of top votes, updated.
+* @param state - the state voted for, not already in topStates.
+* @param votes - the number of votes to state.
+*/
+void scoreTopVotesInsert(int topStates[SCORE_TOP_VOTES],
+                         int topVotes[SCORE_TOP_VOTES], int *numOfTop,
+                         int state, int votes);
+
+/**
+* scoreTopVotesPoints: Return the points a voter gives to the state at a
+* place of its top votes
+*
+* @param place - the place, 0 for the most voted state
+* @return
+* 	12, 10, 8, 7, 6, 5, 4, 3, 2 and 1 for the places 0 to 9
+* 	0 for any other place
+*/
+int scoreTopVotesPoints(int place);
+
+#endif
@@ -0,0 +1,221 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include "score.h"
+#include "threadpool.h"
+#include "eurovision.h"
+#include "generator.h"
+#include "ranking.h"
+
+#define CHECK_MAX_THREADS 9
+#define CHECK_DISTINCT_SCORES 50
+#define CHECK_SEED 3
+#define CHECK_CONTEST_THREADS 4
+#define CHECK_CONTEST_JUDGES 20
+#define CHECK_CONTEST_PERCENT 40
+
+/** The score and id patterns of the checked tables */
+typedef enum CheckPattern_t{
+    CHECK_EQUAL_SCORES_SHUFFLED_IDS,
+    CHECK_DISTINCT_SCORES_NEGATIVE_IDS,
+    CHECK_ZERO_SCORES_DESCENDING_IDS,
+    CHECK_NUM_OF_PATTERNS
+}CheckPattern;
+
+/** fill the scores and ids of a table of size states with pattern */
+void checkFill(double *total, int *ids, int size, CheckPattern pattern);
+
+/** is order sorted by score (highest first) and by id on equal scores */
+bool checkSorted(const double *total, const int *ids, const int *order,
+                 int size);
+
+/** rank a table of size states with scoreRank and with scoreRankParallel on
+ *  pools of 1 to CHECK_MAX_THREADS threads, return the number of rankings
+ *  that were not sorted or differ from the ranking of scoreRank */
+int checkRank(int size, CheckPattern pattern);
+
+/** create a eurovision of a generated contest of numOfStates states */
+Eurovision checkCreateEurovision(int numOfStates);
+
+/** do the two rankings have the same states in the same order, an empty
+ *  ranking is never the same */
+bool checkSameRanking(RankingResult first, RankingResult second);
+
+/** run a generated contest of numOfStates states and its audience favorite
+ *  with a rank pool of CHECK_CONTEST_THREADS threads and without one,
+ *  return the number of results that differ */
+int checkContest(int numOfStates);
+
+void checkFill(double *total, int *ids, int size, CheckPattern pattern){
+    for(int i=0; i<size; i++){
+        switch(pattern){
+            case CHECK_EQUAL_SCORES_SHUFFLED_IDS:
+                total[i] = (rand()%CHECK_DISTINCT_SCORES)/7.0;
+                ids[i] = i*2;
+                break;
+            case CHECK_DISTINCT_SCORES_NEGATIVE_IDS:
+                total[i] = rand()/(double)RAND_MAX;
+                ids[i] = i*2-size;
+                break;
+            default:
+                total[i] = 0;
+                ids[i] = (size-i)*3;
+        }
+    }
+    if(pattern==CHECK_EQUAL_SCORES_SHUFFLED_IDS){
+        for(int i=0; i<size; i++){
+            int j = rand()%size;
+            int id = ids[i];
+            ids[i] = ids[j];
+            ids[j] = id;
+        }
+    }
+}
+
+bool checkSorted(const double *total, const int *ids, const int *order,
+                 int size){
+    for(int i=1; i<size; i++){
+        double previous = total[order[i-1]], current = total[order[i]];
+        if(previous<current ||
+           (previous==current && ids[order[i-1]]>ids[order[i]])){
+            return false;
+        }
+    }
+    return true;
+}
+
+int checkRank(int size, CheckPattern pattern){
+    double *total = malloc(sizeof(double)*size);
+    int *ids = malloc(sizeof(int)*size);
+    int *expected = malloc(sizeof(int)*size);
+    int *order = malloc(sizeof(int)*size);
+    if(!total||!ids||!expected||!order){
+        free(total);
+        free(ids);
+        free(expected);
+        free(order);
+        return 1;
+    }
+    checkFill(total, ids, size, pattern);
+    int failures = 0;
+    if(scoreRank(total, ids, expected, size)!=SCORE_SUCCESS ||
+       !checkSorted(total, ids, expected, size)){
+        printf("scoreRank: size %d pattern %d is not sorted\n", size,
+               pattern);
+        failures++;
+    }
+    for(int threads=1; threads<=CHECK_MAX_THREADS; threads++){
+        ThreadPool pool = threadPoolCreate(threads);
+        ScoreResult result = scoreRankParallel(total, ids, order, size,
+                                               pool);
+        threadPoolDestroy(pool);
+        int i = 0;
+        while(result==SCORE_SUCCESS && i<size && order[i]==expected[i]){
+            i++;
+        }
+        if(i<size){
+            printf("scoreRankParallel: size %d pattern %d threads %d differs "
+                   "at %d\n", size, pattern, threads, i);
+            failures++;
+        }
+    }
+    free(total);
+    free(ids);
+    free(expected);
+    free(order);
+    return failures;
+}
+
+Eurovision checkCreateEurovision(int numOfStates){
+    GeneratorConfig config = {numOfStates, CHECK_CONTEST_JUDGES,
+                              numOfStates*3, 1.0, CHECK_SEED};
+    Generator generator = generatorCreate(config);
+    Eurovision eurovision = eurovisionCreate();
+    if(!generator||!eurovision){
+        generatorDestroy(generator);
+        eurovisionDestroy(eurovision);
+        return NULL;
+    }
+    EurovisionResult result = generatorFillEurovision(generator, eurovision);
+    generatorDestroy(generator);
+    if(result!=EUROVISION_SUCCESS){
+        /* already destroyed on EUROVISION_OUT_OF_MEMORY */
+        if(result!=EUROVISION_OUT_OF_MEMORY){
+            eurovisionDestroy(eurovision);
+        }
+        return NULL;
+    }
+    return eurovision;
+}
+
+bool checkSameRanking(RankingResult first, RankingResult second){
+    int size = rankingGetSize(first);
+    if(size==0||size!=rankingGetSize(second)){
+        return false;
+    }
+    const RankingEntry *entries = rankingGetEntries(first);
+    const RankingEntry *others = rankingGetEntries(second);
+    for(int i=0; i<size; i++){
+        if(entries[i].id!=others[i].id||entries[i].score!=others[i].score){
+            return false;
+        }
+    }
+    return true;
+}
+
+int checkContest(int numOfStates){
+    Eurovision parallel = checkCreateEurovision(numOfStates);
+    Eurovision serial = checkCreateEurovision(numOfStates);
+    ThreadPool pool = threadPoolCreate(CHECK_CONTEST_THREADS);
+    RankingResult expected = rankingCreate();
+    RankingResult ranking = rankingCreate();
+    int failures = 0;
+    if(!parallel||!serial||!pool||!expected||!ranking||
+       eurovisionSetRankPool(parallel, pool)!=EUROVISION_SUCCESS||
+       eurovisionSetRankPool(serial, NULL)!=EUROVISION_SUCCESS){
+        failures++;
+    } else {
+        if(eurovisionRunContestInto(serial, CHECK_CONTEST_PERCENT,
+                                    expected)!=EUROVISION_SUCCESS||
+           eurovisionRunContestInto(parallel, CHECK_CONTEST_PERCENT,
+                                    ranking)!=EUROVISION_SUCCESS||
+           !checkSameRanking(expected, ranking)){
+            printf("eurovisionRunContest: %d states differs\n", numOfStates);
+            failures++;
+        }
+        if(eurovisionRunAudienceFavoriteInto(serial,
+                                             expected)!=EUROVISION_SUCCESS||
+           eurovisionRunAudienceFavoriteInto(parallel,
+                                             ranking)!=EUROVISION_SUCCESS||
+           !checkSameRanking(expected, ranking)){
+            printf("eurovisionRunAudienceFavorite: %d states differs\n",
+                   numOfStates);
+            failures++;
+        }
+    }
+    rankingDestroy(expected);
+    rankingDestroy(ranking);
+    eurovisionDestroy(parallel);
+    eurovisionDestroy(serial);
+    threadPoolDestroy(pool);
+    return failures;
+}
+
+int main(){
+    const int sizes[] = {1, 2, 3, 7, 100, 1000, 65535, 65536, 200001};
+    srand(CHECK_SEED);
+    int failures = 0;
+    for(int i=0; i<(int)(sizeof(sizes)/sizeof(sizes[0])); i++){
+        for(int pattern=0; pattern<CHECK_NUM_OF_PATTERNS; pattern++){
+            failures += checkRank(sizes[i], pattern);
+        }
+    }
+    /* below and above the size the contests are ranked in parallel from */
+    const int contests[] = {1000, 70000};
+    for(int i=0; i<(int)(sizeof(contests)/sizeof(contests[0])); i++){
+        failures += checkContest(contests[i]);
+    }
+    printf("%s\n", failures==0 ? "score check passed" :
+                                 "score check failed");
+    return failures==0 ? 0 : 1;
+}
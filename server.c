@@ -0,0 +1,480 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "eurovision.h"
+#include "list.h"
+#include "protocol.h"
+
+#define DEFAULT_SOCKET "/tmp/eurovision.sock"
+#define MAX_EVENTS 64
+#define LISTEN_BACKLOG 128
+#define READ_CHUNK 65536
+
+/** Options of the server */
+typedef struct ServerOptions_t{
+    const char *socketPath;
+}ServerOptions;
+
+/** A client connection, in holds the bytes read and not handled yet and
+ *  out the responses not written yet */
+typedef struct Connection_t{
+    int fd;
+    ProtocolBuffer in;
+    ProtocolBuffer out;
+}*Connection;
+
+/** The vote server, connections[fd] is the connection of a socket */
+typedef struct Server_t{
+    Eurovision eurovision;
+    int listenFd;
+    int epollFd;
+    Connection *connections;
+    int connectionsCapacity;
+    long requests;
+    long batches;
+}Server;
+
+/** set by SIGINT and SIGTERM to stop the event loop */
+volatile sig_atomic_t serverStopRequested = 0;
+
+/** signal handler of SIGINT and SIGTERM */
+void serverRequestStop(int signalNumber);
+
+/** parse the command line into options, return false on bad arguments */
+bool serverParseOptions(int argc, char **argv, ServerOptions *options);
+
+/** create the eurovision, the listening socket and the epoll instance,
+ *  return false with errno set on an error */
+bool serverStart(Server *server, ServerOptions options);
+
+/** close every connection and the sockets, destroy the eurovision and
+ *  remove the socket file */
+void serverStop(Server *server, ServerOptions options);
+
+/** return a new non blocking Unix socket listening on path, -1 on error */
+int serverListen(const char *path);
+
+/** set O_NONBLOCK on fd, return false on error */
+bool serverSetNonBlocking(int fd);
+
+/** accept all the pending connections */
+void serverAccept(Server *server);
+
+/** set the epoll events of a connection, EPOLLOUT instead of EPOLLIN while
+ *  it has responses that were not written */
+void serverWatch(Server *server, Connection connection);
+
+/** close a connection and deallocate it */
+void serverClose(Server *server, Connection connection);
+
+/** read everything available on a connection, handle the whole batch of
+ *  requests it holds and write the responses, return false if the
+ *  connection must be closed */
+bool serverRead(Server *server, Connection connection);
+
+/** write as much of the responses of a connection as possible, return
+ *  false if the connection must be closed */
+bool serverFlush(Server *server, Connection connection);
+
+/** handle the complete requests in the input of a connection, return false
+ *  on a bad request or if the responses could not be buffered */
+bool serverHandleBatch(Server *server, Connection connection);
+
+/** handle one request and append its response to out, return false on a
+ *  bad request (a missing field or bytes after the fields) or if the
+ *  response could not be buffered */
+bool serverHandle(Server *server, ProtocolHeader header,
+                  ProtocolReader *payload, ProtocolBuffer out);
+
+/** append the response of a query, the names of list */
+bool serverAppendList(ProtocolBuffer out, List list);
+
+void serverRequestStop(int signalNumber){
+    serverStopRequested = 1;
+}
+
+bool serverParseOptions(int argc, char **argv, ServerOptions *options){
+    options->socketPath = DEFAULT_SOCKET;
+    for(int i=1; i<argc; i++){
+        if(i+1>=argc) return false;
+        char *option = argv[i];
+        char *value = argv[++i];
+        if(strcmp(option, "--socket")==0){
+            options->socketPath = value;
+        }
+        else{
+            return false;
+        }
+    }
+    return true;
+}
+
+bool serverSetNonBlocking(int fd){
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags>=0 && fcntl(fd, F_SETFL, flags|O_NONBLOCK)==0;
+}
+
+int serverListen(const char *path){
+    struct sockaddr_un address;
+    if(strlen(path) >= sizeof(address.sun_path)){
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd<0) return -1;
+    unlink(path);
+    if(bind(fd, (struct sockaddr*)&address, sizeof(address))!=0 ||
+       listen(fd, LISTEN_BACKLOG)!=0 || !serverSetNonBlocking(fd)){
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+bool serverStart(Server *server, ServerOptions options){
+    server->connections = NULL;
+    server->connectionsCapacity = 0;
+    server->requests = 0;
+    server->batches = 0;
+    server->listenFd = -1;
+    server->epollFd = -1;
+    server->eurovision = eurovisionCreate();
+    if(!server->eurovision){
+        errno = ENOMEM;
+        return false;
+    }
+    server->listenFd = serverListen(options.socketPath);
+    if(server->listenFd<0) return false;
+    server->epollFd = epoll_create1(0);
+    if(server->epollFd<0) return false;
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    return epoll_ctl(server->epollFd, EPOLL_CTL_ADD, server->listenFd,
+                     &event)==0;
+}
+
+void serverStop(Server *server, ServerOptions options){
+    for(int fd=0; fd<server->connectionsCapacity; fd++){
+        if(server->connections[fd]){
+            serverClose(server, server->connections[fd]);
+        }
+    }
+    free(server->connections);
+    if(server->epollFd>=0) close(server->epollFd);
+    if(server->listenFd>=0){
+        close(server->listenFd);
+        unlink(options.socketPath);
+    }
+    eurovisionDestroy(server->eurovision);
+}
+
+void serverAccept(Server *server){
+    while(true){
+        int fd = accept(server->listenFd, NULL, NULL);
+        if(fd<0) return;
+        if(fd>=server->connectionsCapacity){
+            int capacity = fd*2+1;
+            Connection *connections = realloc(server->connections,
+                                              sizeof(Connection)*capacity);
+            if(!connections){
+                close(fd);
+                continue;
+            }
+            for(int i=server->connectionsCapacity; i<capacity; i++){
+                connections[i] = NULL;
+            }
+            server->connections = connections;
+            server->connectionsCapacity = capacity;
+        }
+        Connection connection = malloc(sizeof(*connection));
+        if(!connection){
+            close(fd);
+            continue;
+        }
+        connection->fd = fd;
+        connection->in = protocolBufferCreate();
+        connection->out = protocolBufferCreate();
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        if(!connection->in||!connection->out||!serverSetNonBlocking(fd)||
+           epoll_ctl(server->epollFd, EPOLL_CTL_ADD, fd, &event)!=0){
+            protocolBufferDestroy(connection->in);
+            protocolBufferDestroy(connection->out);
+            free(connection);
+            close(fd);
+            continue;
+        }
+        server->connections[fd] = connection;
+    }
+}
+
+void serverWatch(Server *server, Connection connection){
+    struct epoll_event event;
+    event.events = protocolBufferGetSize(connection->out)>0 ? EPOLLOUT :
+                                                              EPOLLIN;
+    event.data.ptr = connection;
+    epoll_ctl(server->epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+}
+
+void serverClose(Server *server, Connection connection){
+    epoll_ctl(server->epollFd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    server->connections[connection->fd] = NULL;
+    protocolBufferDestroy(connection->in);
+    protocolBufferDestroy(connection->out);
+    free(connection);
+}
+
+bool serverRead(Server *server, Connection connection){
+    bool open = true;
+    while(open){
+        if(protocolBufferReserve(connection->in,
+                                 READ_CHUNK)!=PROTOCOL_SUCCESS){
+            return false;
+        }
+        uint32_t space;
+        char *data = protocolBufferGetSpace(connection->in, &space);
+        ssize_t size = read(connection->fd, data, space);
+        if(size>0){
+            protocolBufferCommit(connection->in, (uint32_t)size);
+        }
+        else if(size==0){
+            open = false;
+        }
+        else if(errno==EAGAIN||errno==EWOULDBLOCK){
+            break;
+        }
+        else if(errno!=EINTR){
+            return false;
+        }
+    }
+    bool valid = serverHandleBatch(server, connection);
+    return serverFlush(server, connection) && open && valid;
+}
+
+bool serverFlush(Server *server, Connection connection){
+    while(protocolBufferGetSize(connection->out)>0){
+        ssize_t size = send(connection->fd,
+                            protocolBufferGetData(connection->out),
+                            protocolBufferGetSize(connection->out),
+                            MSG_NOSIGNAL);
+        if(size>0){
+            protocolBufferConsume(connection->out, (uint32_t)size);
+        }
+        else if(errno==EAGAIN||errno==EWOULDBLOCK){
+            break;
+        }
+        else if(errno!=EINTR){
+            return false;
+        }
+    }
+    serverWatch(server, connection);
+    return true;
+}
+
+bool serverHandleBatch(Server *server, Connection connection){
+    ProtocolHeader header;
+    ProtocolReader payload;
+    bool handled = false;
+    while(server->eurovision){
+        ProtocolResult result = protocolNextMessage(connection->in, &header,
+                                                    &payload);
+        if(result==PROTOCOL_INCOMPLETE) break;
+        if(result!=PROTOCOL_SUCCESS ||
+           !serverHandle(server, header, &payload, connection->out)){
+            return false;
+        }
+        protocolBufferConsume(connection->in,
+                              sizeof(ProtocolHeader)+header.size);
+        server->requests++;
+        handled = true;
+    }
+    if(handled){
+        server->batches++;
+    }
+    return true;
+}
+
+bool serverAppendList(ProtocolBuffer out, List list){
+    uint32_t size = sizeof(int32_t);
+    LIST_FOREACH(char*, name, list){
+        size += strlen(name)+1;
+    }
+    int32_t numOfNames = listGetSize(list);
+    if(protocolBufferReserve(out, sizeof(ProtocolHeader)+size)!=
+       PROTOCOL_SUCCESS){
+        return false;
+    }
+    protocolAppendHeader(out, PROTOCOL_RESULT_SUCCESS, size);
+    protocolAppend(out, &numOfNames, sizeof(numOfNames));
+    LIST_FOREACH(char*, name, list){
+        protocolAppend(out, name, strlen(name)+1);
+    }
+    return true;
+}
+
+bool serverHandle(Server *server, ProtocolHeader header,
+                  ProtocolReader *payload, ProtocolBuffer out){
+    Eurovision eurovision = server->eurovision;
+    EurovisionResult result = EUROVISION_SUCCESS;
+    List list = NULL;
+    int id, other, results[NUM_OF_JUDGE_RESULTS];
+    const char *name, *song;
+    switch(header.type){
+        case PROTOCOL_ADD_STATE:
+            if(!protocolReadInt(payload, &id) ||
+               !protocolReadString(payload, &name) ||
+               !protocolReadString(payload, &song) ||
+               !protocolReaderDone(payload)){
+                return false;
+            }
+            result = eurovisionAddState(eurovision, id, name, song);
+            break;
+        case PROTOCOL_REMOVE_STATE:
+            if(!protocolReadInt(payload, &id) ||
+               !protocolReaderDone(payload)){
+                return false;
+            }
+            result = eurovisionRemoveState(eurovision, id);
+            break;
+        case PROTOCOL_ADD_JUDGE:
+            if(!protocolReadInt(payload, &id)) return false;
+            for(int i=0; i<NUM_OF_JUDGE_RESULTS; i++){
+                if(!protocolReadInt(payload, results+i)) return false;
+            }
+            if(!protocolReadString(payload, &name) ||
+               !protocolReaderDone(payload)){
+                return false;
+            }
+            result = eurovisionAddJudge(eurovision, id, name, results);
+            break;
+        case PROTOCOL_REMOVE_JUDGE:
+            if(!protocolReadInt(payload, &id) ||
+               !protocolReaderDone(payload)){
+                return false;
+            }
+            result = eurovisionRemoveJudge(eurovision, id);
+            break;
+        case PROTOCOL_ADD_VOTE:
+        case PROTOCOL_REMOVE_VOTE:
+            if(!protocolReadInt(payload, &id) ||
+               !protocolReadInt(payload, &other) ||
+               !protocolReaderDone(payload)){
+                return false;
+            }
+            result = header.type==PROTOCOL_ADD_VOTE ?
+                     eurovisionAddVote(eurovision, id, other) :
+                     eurovisionRemoveVote(eurovision, id, other);
+            break;
+        case PROTOCOL_RUN_CONTEST:
+            if(!protocolReadInt(payload, &id) ||
+               !protocolReaderDone(payload)){
+                return false;
+            }
+            if(id<1||id>100){
+                result = EUROVISION_INVALID_PERCENT;
+                break;
+            }
+            list = eurovisionRunContest(eurovision, id);
+            result = list ? EUROVISION_SUCCESS : EUROVISION_OUT_OF_MEMORY;
+            break;
+        case PROTOCOL_RUN_AUDIENCE_FAVORITE:
+            if(!protocolReaderDone(payload)) return false;
+            list = eurovisionRunAudienceFavorite(eurovision);
+            result = list ? EUROVISION_SUCCESS : EUROVISION_OUT_OF_MEMORY;
+            break;
+        case PROTOCOL_RUN_FRIENDLY_STATES:
+            if(!protocolReaderDone(payload)) return false;
+            list = eurovisionRunGetFriendlyStates(eurovision);
+            result = list ? EUROVISION_SUCCESS : EUROVISION_OUT_OF_MEMORY;
+            break;
+        default:
+            return false;
+    }
+    if(result==EUROVISION_OUT_OF_MEMORY){
+        /* the eurovision functions destroy the eurovision on this error */
+        server->eurovision = NULL;
+    }
+    bool buffered;
+    if(list){
+        buffered = serverAppendList(out, list);
+        listDestroy(list);
+    }
+    else{
+        buffered = protocolAppendMessage(out, protocolResultEncode(result),
+                                         NULL, 0)==PROTOCOL_SUCCESS;
+    }
+    return buffered;
+}
+
+int main(int argc, char **argv){
+    ServerOptions options;
+    if(!serverParseOptions(argc, argv, &options)){
+        fprintf(stderr, "usage: %s [--socket PATH]\n", argv[0]);
+        return 1;
+    }
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = serverRequestStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    action.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &action, NULL);
+    Server server;
+    if(!serverStart(&server, options)){
+        perror("eurovision_server");
+        serverStop(&server, options);
+        return 1;
+    }
+    struct epoll_event events[MAX_EVENTS];
+    while(!serverStopRequested && server.eurovision){
+        int numOfEvents = epoll_wait(server.epollFd, events, MAX_EVENTS, -1);
+        if(numOfEvents<0){
+            if(errno==EINTR) continue;
+            perror("eurovision_server");
+            break;
+        }
+        for(int i=0; i<numOfEvents; i++){
+            Connection connection = events[i].data.ptr;
+            if(!connection){
+                serverAccept(&server);
+                continue;
+            }
+            bool keep = true;
+            if(events[i].events & EPOLLOUT){
+                keep = serverFlush(&server, connection);
+            }
+            else if(events[i].events & (EPOLLIN|EPOLLHUP|EPOLLERR)){
+                keep = serverRead(&server, connection);
+            }
+            if(!keep){
+                serverClose(&server, connection);
+            }
+        }
+    }
+    int status = server.eurovision ? 0 : 1;
+    if(!server.eurovision){
+        fprintf(stderr, "eurovision_server: out of memory\n");
+    }
+    fprintf(stderr, "eurovision_server: %ld requests in %ld batches\n",
+            server.requests, server.batches);
+    serverStop(&server, options);
+    return status;
+}
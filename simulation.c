@@ -0,0 +1,266 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <unistd.h>
+#include "simulation.h"
+#include "score.h"
+#include "threadpool.h"
+
+#define SIMULATION_MAX_THREADS 64
+#define POISSON_NORMAL_MEAN 30
+#define TWO_PI 6.283185307179586
+
+/** The random sequence of one trial (splitmix64, like the generator) with
+ *  the spare standard normal of the last Box-Muller draw */
+typedef struct SimulationRandom_t{
+    unsigned long long state;
+    bool hasSpare;
+    double spare;
+}SimulationRandom;
+
+/** The trials of one thread: trials first, first+step, first+2*step... and
+ *  the buffers it reuses for all of them. places are the places of the
+ *  outcome, shared by all the threads */
+typedef struct SimulationWorker_t{
+    const SimulationContest *contest;
+    int audiencePercent;
+    int trials;
+    int first;
+    int step;
+    SimulationNoise noise;
+    unsigned long long seed;
+    double *audience;
+    double *total;
+    int *order;
+    void *rankBuffer;
+    long *places;
+    bool failed;
+}SimulationWorker;
+
+/** return the next random 64 bits of random */
+unsigned long long simulationRandomNext(SimulationRandom *random);
+
+/** return a uniform double in (0, 1] */
+double simulationUniform(SimulationRandom *random);
+
+/** return a standard normal double */
+double simulationNormal(SimulationRandom *random);
+
+/** return count with the noise of a trial */
+int simulationPerturb(SimulationRandom *random, SimulationNoise noise,
+                      int count);
+
+/** run one trial of worker and count its places */
+void simulationTrial(SimulationWorker *worker, unsigned long long trial);
+
+/** allocate the buffers of a worker and run its trials, a ThreadPoolTask */
+void simulationWork(void *argument);
+
+/** deallocate the buffers of a worker */
+void simulationWorkerClear(SimulationWorker *worker);
+
+/** return the number of threads to run trials on */
+int simulationNumOfThreads(int trials);
+
+unsigned long long simulationRandomNext(SimulationRandom *random){
+    unsigned long long z = (random->state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+double simulationUniform(SimulationRandom *random){
+    /* the top 53 bits, shifted by one so log never sees 0 */
+    return ((simulationRandomNext(random) >> 11)+1)*(1.0/(1ULL << 53));
+}
+
+double simulationNormal(SimulationRandom *random){
+    if(random->hasSpare){
+        random->hasSpare = false;
+        return random->spare;
+    }
+    double radius = sqrt(-2*log(simulationUniform(random)));
+    double angle = TWO_PI*simulationUniform(random);
+    random->spare = radius*sin(angle);
+    random->hasSpare = true;
+    return radius*cos(angle);
+}
+
+int simulationPerturb(SimulationRandom *random, SimulationNoise noise,
+                      int count){
+    double value;
+    if(noise.type==SIMULATION_NOISE_GAUSSIAN){
+        value = count*(1+noise.scale*simulationNormal(random));
+    }
+    else{
+        double mean = count*noise.scale;
+        if(mean<POISSON_NORMAL_MEAN){
+            /* Knuth: multiply uniforms until the product drops below
+             * e^-mean, O(mean) draws */
+            double limit = exp(-mean), product = simulationUniform(random);
+            int draw = 0;
+            while(product>limit){
+                product *= simulationUniform(random);
+                draw++;
+            }
+            return draw;
+        }
+        value = mean+sqrt(mean)*simulationNormal(random);
+    }
+    value = floor(value+0.5);
+    if(value<=0) return 0;
+    return value<(double)INT_MAX ? (int)value : INT_MAX;
+}
+
+void simulationTrial(SimulationWorker *worker, unsigned long long trial){
+    const SimulationContest *contest = worker->contest;
+    int numOfStates = contest->numOfStates;
+    SimulationRandom random = {worker->seed, false, 0};
+    /* a different splitmix64 sequence for every trial */
+    random.state = simulationRandomNext(&random)+trial*0xD1B54A32D192ED03ULL;
+    for(int i=0; i<numOfStates; i++){
+        worker->audience[i] = 0;
+    }
+    for(int giver=0; giver<numOfStates; giver++){
+        int topStates[SCORE_TOP_VOTES];
+        int topVotes[SCORE_TOP_VOTES];
+        int numOfTop = 0;
+        for(int j=contest->voteStarts[giver]; j<contest->voteStarts[giver+1];
+            j++){
+            int votes = simulationPerturb(&random, worker->noise,
+                                          contest->counts[j]);
+            /* the takers are indexes in id order, so the order of the top
+             * votes is the order of stateGetTopVotes */
+            if(votes>0){
+                scoreTopVotesInsert(topStates, topVotes, &numOfTop,
+                                    contest->takers[j], votes);
+            }
+        }
+        for(int k=0; k<numOfTop; k++){
+            worker->audience[topStates[k]] += scoreTopVotesPoints(k);
+        }
+    }
+    scoreCombine(worker->audience, contest->judges, worker->total,
+                 numOfStates, numOfStates, contest->numOfJudges,
+                 worker->audiencePercent);
+    scoreRankInBuffer(worker->total, contest->ids, worker->order,
+                      numOfStates, worker->rankBuffer);
+    /* the other threads count into the same places, the pool is destroyed
+     * before the outcome is read */
+    for(int place=0; place<numOfStates; place++){
+        __atomic_fetch_add(worker->places+
+                           (long)worker->order[place]*numOfStates+place, 1,
+                           __ATOMIC_RELAXED);
+    }
+}
+
+void simulationWork(void *argument){
+    SimulationWorker *worker = argument;
+    int numOfStates = worker->contest->numOfStates;
+    worker->audience = malloc(sizeof(double)*numOfStates);
+    worker->total = malloc(sizeof(double)*numOfStates);
+    worker->order = malloc(sizeof(int)*numOfStates);
+    worker->rankBuffer = malloc(scoreRankBufferSize(numOfStates));
+    if(!worker->audience||!worker->total||!worker->order||
+       !worker->rankBuffer){
+        worker->failed = true;
+        return;
+    }
+    for(int trial=worker->first; trial<worker->trials; trial+=worker->step){
+        simulationTrial(worker, (unsigned long long)trial);
+    }
+}
+
+void simulationWorkerClear(SimulationWorker *worker){
+    free(worker->audience);
+    free(worker->total);
+    free(worker->order);
+    free(worker->rankBuffer);
+}
+
+int simulationNumOfThreads(int trials){
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    int numOfThreads = processors>1 ? (int)processors : 1;
+    if(numOfThreads>SIMULATION_MAX_THREADS){
+        numOfThreads = SIMULATION_MAX_THREADS;
+    }
+    return numOfThreads<trials ? numOfThreads : trials;
+}
+
+SimulationResult simulationRun(const SimulationContest *contest,
+                               int audiencePercent, int trials,
+                               SimulationNoise noise, unsigned long long seed,
+                               SimulationOutcome *outcome){
+    if(!contest||!outcome) return SIMULATION_NULL_ARGUMENT;
+    if(audiencePercent<1||audiencePercent>100||trials<=0||
+       !(noise.scale>=0)){
+        return SIMULATION_INVALID_ARGUMENT;
+    }
+    int numOfStates = contest->numOfStates;
+    outcome->numOfStates = numOfStates;
+    outcome->trials = trials;
+    outcome->ids = malloc(sizeof(int)*(numOfStates>0 ? numOfStates : 1));
+    outcome->places = calloc((size_t)numOfStates*numOfStates+1,
+                             sizeof(long));
+    if(!outcome->ids||!outcome->places){
+        simulationOutcomeClear(outcome);
+        return SIMULATION_OUT_OF_MEMORY;
+    }
+    if(numOfStates<=0) return SIMULATION_SUCCESS;
+    memcpy(outcome->ids, contest->ids, sizeof(int)*numOfStates);
+    int numOfThreads = simulationNumOfThreads(trials);
+    SimulationWorker workers[SIMULATION_MAX_THREADS];
+    for(int i=0; i<numOfThreads; i++){
+        SimulationWorker worker = {contest, audiencePercent, trials, i,
+                                   numOfThreads, noise, seed, NULL, NULL,
+                                   NULL, NULL, outcome->places, false};
+        workers[i] = worker;
+    }
+    ThreadPool pool = numOfThreads>1 ? threadPoolCreate(numOfThreads) : NULL;
+    for(int i=0; i<numOfThreads; i++){
+        /* without a pool the trials run on the calling thread */
+        if(!pool||threadPoolSubmit(pool, simulationWork,
+                                   workers+i)!=THREAD_POOL_SUCCESS){
+            simulationWork(workers+i);
+        }
+    }
+    threadPoolDestroy(pool);
+    bool failed = false;
+    for(int i=0; i<numOfThreads; i++){
+        failed = failed || workers[i].failed;
+        simulationWorkerClear(workers+i);
+    }
+    if(failed){
+        simulationOutcomeClear(outcome);
+        return SIMULATION_OUT_OF_MEMORY;
+    }
+    return SIMULATION_SUCCESS;
+}
+
+double simulationGetProbability(const SimulationOutcome *outcome,
+                                int stateId, int place){
+    if(!outcome||!outcome->ids||place<0||place>=outcome->numOfStates||
+       outcome->trials<=0){
+        return -1;
+    }
+    for(int i=0; i<outcome->numOfStates; i++){
+        if(outcome->ids[i]==stateId){
+            return (double)outcome->places[(long)i*outcome->numOfStates+
+                                           place]/outcome->trials;
+        }
+    }
+    return -1;
+}
+
+void simulationOutcomeClear(SimulationOutcome *outcome){
+    if(!outcome) return;
+    free(outcome->ids);
+    free(outcome->places);
+    outcome->ids = NULL;
+    outcome->places = NULL;
+    outcome->numOfStates = 0;
+    outcome->trials = 0;
+}
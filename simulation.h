@@ -0,0 +1,121 @@
+#ifndef MTM_HW1_EUROVISION_SIMULATION_H
+#define MTM_HW1_EUROVISION_SIMULATION_H
+
+/**
+ * Contest Outcome Simulation
+ *
+ * Runs a contest many times (trials) with random noise on the citizen votes
+ * counts, and counts the place every state finished at in each trial. A
+ * trial ranks the audience like eurovisionRunContest (the top ten states of
+ * every voter get 12, 10, 8, 7, 6, 5, 4, 3, 2 and 1 points) and blends it
+ * with the judges scores, which do not change between the trials.
+ *
+ * The trials are split between one thread per processor. Every trial draws
+ * its noise from its own random sequence, made from the seed and the number
+ * of the trial, so an outcome depends on the seed only and not on the
+ * number of threads. Every thread allocates its buffers once and reuses
+ * them for all of its trials (O(numOfStates) each), and counts the places
+ * straight into the outcome.
+ *
+ * The following functions are available:
+ *
+ * simulationRun            - Run the trials of a contest.
+ * simulationGetProbability - Return the share of the trials a state finished
+ *                            at a place.
+ * simulationOutcomeClear   - Deallocate the arrays of an outcome.
+*/
+
+/** The noise types of a simulation */
+typedef enum SimulationNoiseType_t{
+    SIMULATION_NOISE_POISSON,
+    SIMULATION_NOISE_GAUSSIAN
+}SimulationNoiseType;
+
+/** The noise of the citizen votes counts of every trial. A count c becomes:
+ *
+ * SIMULATION_NOISE_POISSON  - a Poisson draw with mean c*scale, the sampling
+ *                             noise of a televote (scale is usually 1).
+ * SIMULATION_NOISE_GAUSSIAN - c*(1+scale*z) for a standard normal z, rounded
+ *                             and at least 0, scale is the relative error.
+ */
+typedef struct SimulationNoise_t{
+    SimulationNoiseType type;
+    double scale;
+}SimulationNoise;
+
+/** The contest of a simulation: numOfStates states, ids ascending. State i
+ *  gave counts[j] citizen votes to the state of index takers[j] for every j
+ *  from voteStarts[i] up to voteStarts[i+1] (not included), and judges[i] is
+ *  the judges score of state i out of numOfJudges judges */
+typedef struct SimulationContest_t{
+    int numOfStates;
+    const int *ids;
+    const int *voteStarts;
+    const int *takers;
+    const int *counts;
+    const double *judges;
+    int numOfJudges;
+}SimulationContest;
+
+/** The outcome of a simulation: places[i*numOfStates+p] is the number of
+ *  trials the state ids[i] finished at place p (0 is the winner) */
+typedef struct SimulationOutcome_t{
+    int numOfStates;
+    int trials;
+    int *ids;
+    long *places;
+}SimulationOutcome;
+
+/** Type used for returning error codes from simulation functions */
+typedef enum SimulationResult_t{
+    SIMULATION_NULL_ARGUMENT,
+    SIMULATION_INVALID_ARGUMENT,
+    SIMULATION_OUT_OF_MEMORY,
+    SIMULATION_SUCCESS
+}SimulationResult;
+
+/**
+* simulationRun: Run trials noisy contests and count the places of the
+* states
+*
+* @param contest - the contest, it is not changed
+* @param audiencePercent - the weight of the audience in the final score
+* @param trials - the number of contests to run
+* @param noise - the noise of the citizen votes counts
+* @param seed - the seed of the random sequences
+* @param outcome - set to the new counts, cleared with simulationOutcomeClear
+* @return
+* 	SIMULATION_NULL_ARGUMENT - if contest or outcome is NULL
+* 	SIMULATION_INVALID_ARGUMENT - if audiencePercent is not between 1 and
+* 	                              100, trials is not positive or the scale
+* 	                              of the noise is negative
+* 	SIMULATION_OUT_OF_MEMORY - in case of an allocation error
+* 	SIMULATION_SUCCESS - if outcome was set
+*/
+SimulationResult simulationRun(const SimulationContest *contest,
+                               int audiencePercent, int trials,
+                               SimulationNoise noise, unsigned long long seed,
+                               SimulationOutcome *outcome);
+
+/**
+* simulationGetProbability: Return the share of the trials in which a state
+* finished at a place
+*
+* @param outcome - the outcome of simulationRun
+* @param stateId - the id of the state
+* @param place - the place, 0 for the winner
+* @return
+* 	-1 - if outcome is NULL, there is no state stateId or no place place
+* 	the share of the trials otherwise
+*/
+double simulationGetProbability(const SimulationOutcome *outcome,
+                                int stateId, int place);
+
+/**
+* simulationOutcomeClear: Deallocate the arrays of an outcome
+*
+* @param outcome - the outcome, if NULL nothing will be done
+*/
+void simulationOutcomeClear(SimulationOutcome *outcome);
+
+#endif
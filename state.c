@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <limits.h>
 #include "set.h"
 #include "state.h"
 
@@ -10,18 +11,60 @@ MapDataElement stateCopyInt(MapDataElement n);
 /** Function to deallocate int for map container */
 void stateFreeInt(MapKeyElement n);
 
+/** Function to add the second int to the first one for map container,
+ *  the sum is kept at INT_MAX instead of overflowing */
+void stateAddInt(MapDataElement sum, MapDataElement n);
+
 /** Function to compare two ints for map container,
  *  return a positive number if the first int is greater,
  *  0 if they equal, and a negative number if the second one is greater
  */
 int stateCompareInts(MapKeyElement n1, MapKeyElement n2);
 
+/** allocate a state with no names and no citizen votes map container */
+State stateAllocate(int stateId, StringPool pool, Allocator allocator);
+
+/** return a copy of str for a state, interned in pool if pool is not NULL
+ *  and allocated from allocator otherwise */
+char* stateCopyString(StringPool pool, Allocator allocator, const char* str);
+
+/** create an empty citizen votes map container allocating from allocator */
+Map stateCreateCitizenVotes(Allocator allocator);
+
+/** return the index of stateId in the top votes, -1 if it is not cached */
+int stateTopVotesFind(State state, int stateId);
+
+/** insert stateId to its sorted place in the top votes, the last
+ *  cached state is dropped if the top votes are full */
+void stateTopVotesInsert(State state, int stateId, int numOfVotes);
+
+/** return true if stateId is in the numOfIds ascending ids of sortedIds */
+bool stateIdsContain(const int *sortedIds, int numOfIds, int stateId);
+
+/** remove the cached state at index from the top votes */
+void stateTopVotesRemoveAt(State state, int index);
+
+/** update the top votes after the votes to stateId changed from
+ *  oldVotes to newVotes (0 if stateId was removed from the citizen votes) */
+void stateTopVotesUpdate(State state, int stateId, int oldVotes,
+                         int newVotes);
+
+/** rebuild the top votes from the citizen votes map container */
+void stateTopVotesRebuild(State state);
+
+/** The fields the rankings read are first, the names are last */
 struct State_t{
     int id;
+    int numOfTopVotes;
+    bool topVotesDirty;
+    int topStates[NUM_OF_TOP_VOTES];
+    int topVotes[NUM_OF_TOP_VOTES];
+    Map citizenVotes;
+    double finalScore;
     char* name;
     char* song;
-    double finalScore;
-    Map citizenVotes;
+    StringPool pool;
+    Allocator allocator;
 };
 
 MapDataElement stateCopyInt(MapDataElement n) {
@@ -40,34 +83,76 @@ void stateFreeInt(MapKeyElement n){
     free(n);
 }
 
+void stateAddInt(MapDataElement sum, MapDataElement n){
+    int *total = sum, votes = *(int *) n;
+    *total = votes > INT_MAX-*total ? INT_MAX : *total+votes;
+}
+
 int stateCompareInts(MapKeyElement n1, MapKeyElement n2) {
     return (*(int *) n1 - *(int *) n2);
 }
 
-State stateCreate(int stateId, const char* stateName, const char* stateSong){
-    if(stateId<0||!stateName||!stateSong){
-        return NULL;
-    }
-    State newState = malloc(sizeof(*newState));
+State stateAllocate(int stateId, StringPool pool, Allocator allocator){
+    State newState = allocatorAllocate(allocator, ALLOCATOR_STATES,
+                                       sizeof(*newState));
     if(!newState) {
         return NULL;
     }
     newState->id = stateId;
-    newState->name = malloc((strlen(stateName)*sizeof(char))+1);
-    if(!newState->name) {
-        stateDestroy(newState);
+    newState->allocator = allocator;
+    newState->pool = pool;
+    newState->name = NULL;
+    newState->song = NULL;
+    newState->citizenVotes = NULL;
+    newState->finalScore = 0;
+    newState->numOfTopVotes = 0;
+    newState->topVotesDirty = false;
+    return newState;
+}
+
+char* stateCopyString(StringPool pool, Allocator allocator, const char* str){
+    if(pool) {
+        return stringPoolIntern(pool, str);
+    }
+    char* copy = allocatorAllocate(allocator, ALLOCATOR_STRINGS,
+                                   (strlen(str)*sizeof(char))+1);
+    if(!copy) {
         return NULL;
     }
-    strcpy(newState->name,stateName);
-    newState->song = malloc((strlen(stateSong)*sizeof(char))+1);
-    if(!newState->song) {
-        stateDestroy(newState);
+    strcpy(copy,str);
+    return copy;
+}
+
+Map stateCreateCitizenVotes(Allocator allocator){
+    return mapCreateWithAllocator(stateCopyInt, stateCopyInt, stateFreeInt,
+                                  stateFreeInt, stateCompareInts, allocator,
+                                  sizeof(int), sizeof(int),
+                                  ALLOCATOR_VOTE_COUNTERS);
+}
+
+State stateCreate(int stateId, const char* stateName, const char* stateSong){
+    return stateCreateInPool(stateId, stateName, stateSong, NULL);
+}
+
+State stateCreateInPool(int stateId, const char* stateName,
+                        const char* stateSong, StringPool pool){
+    return stateCreateWithAllocator(stateId, stateName, stateSong, pool, NULL);
+}
+
+State stateCreateWithAllocator(int stateId, const char* stateName,
+                               const char* stateSong, StringPool pool,
+                               Allocator allocator){
+    if(stateId<0||!stateName||!stateSong){
         return NULL;
     }
-    strcpy(newState->song,stateSong);
-    newState->finalScore = 0;
-    newState->citizenVotes = mapCreate(stateCopyInt, stateCopyInt, stateFreeInt, stateFreeInt, stateCompareInts);
-    if(!newState->citizenVotes)  {
+    State newState = stateAllocate(stateId, pool, allocator);
+    if(!newState) {
+        return NULL;
+    }
+    newState->name = stateCopyString(pool, allocator, stateName);
+    newState->song = stateCopyString(pool, allocator, stateSong);
+    newState->citizenVotes = stateCreateCitizenVotes(allocator);
+    if(!newState->name||!newState->song||!newState->citizenVotes)  {
         stateDestroy(newState);
         return NULL;
     }
@@ -76,24 +161,62 @@ State stateCreate(int stateId, const char* stateName, const char* stateSong){
 
 void stateDestroy(State state){
     if(!state) return;
-    free(state->name);
-    free(state->song);
+    if(!state->pool){
+        allocatorFree(state->allocator, state->name);
+        allocatorFree(state->allocator, state->song);
+    }
     mapDestroy(state->citizenVotes);
-    free(state);
+    allocatorFree(state->allocator, state);
 }
 
 State stateCopy(State state){
     if(!state) return NULL;
-    State newState = stateCreate(state->id, state->name, state->song);
+    State newState = stateAllocate(state->id, state->pool, state->allocator);
     if(!newState) return NULL;
+    if(state->pool){
+        newState->name = state->name;
+        newState->song = state->song;
+    }
+    else{
+        newState->name = stateCopyString(NULL, state->allocator, state->name);
+        newState->song = stateCopyString(NULL, state->allocator, state->song);
+    }
     newState->finalScore = state->finalScore;
-    mapDestroy(newState->citizenVotes);
-    newState->citizenVotes = mapCopy(state->citizenVotes);
+    if(state->citizenVotes){
+        newState->citizenVotes = mapCopy(state->citizenVotes);
+    }
+    if(!newState->name||!newState->song||
+       (state->citizenVotes && !newState->citizenVotes)){
+        stateDestroy(newState);
+        return NULL;
+    }
+    memcpy(newState->topStates, state->topStates, sizeof(state->topStates));
+    memcpy(newState->topVotes, state->topVotes, sizeof(state->topVotes));
+    newState->numOfTopVotes = state->numOfTopVotes;
+    newState->topVotesDirty = state->topVotesDirty;
     return newState;
 }
 
 
 
+State stateFreeze(State state, const int *sortedIds, int numOfIds,
+                  StringPool pool, Allocator allocator){
+    if(!state||(!sortedIds && numOfIds>0)) return NULL;
+    State frozen = stateAllocate(state->id, pool, allocator);
+    if(!frozen) return NULL;
+    frozen->name = stateCopyString(pool, allocator, state->name);
+    frozen->song = stateCopyString(pool, allocator, state->song);
+    if(!frozen->name||!frozen->song){
+        stateDestroy(frozen);
+        return NULL;
+    }
+    frozen->finalScore = state->finalScore;
+    frozen->numOfTopVotes = stateGetTopVotesExcept(state, sortedIds, numOfIds,
+                                                   frozen->topStates,
+                                                   frozen->topVotes);
+    return frozen;
+}
+
 int stateGetId(State state){
     if(!state) return -1;
     return state->id;
@@ -137,13 +260,22 @@ StateResult stateSetScore(State state, double newScore){
 }
 
 StateResult stateAddVote(State state, int stateToVoteId){
+    return stateAddVotes(state, stateToVoteId, 1);
+}
+
+StateResult stateAddVotes(State state, int stateToVoteId, int numOfVotes){
     if(!state) return STATE_NULL_ARGUMENT;
     if(stateToVoteId<0) return STATE_INVALID_ID;
+    if(numOfVotes<=0) return STATE_SUCCESS;
     int tmp;
     MapResult result;
     tmp = stateGetNumOfVotes(state, stateToVoteId);
-    tmp++;
+    if(numOfVotes > INT_MAX-tmp) return STATE_VOTES_OVERFLOW;
+    tmp += numOfVotes;
     result = mapPut(state->citizenVotes,&stateToVoteId,&tmp);
+    if(result == MAP_SUCCESS){
+        stateTopVotesUpdate(state, stateToVoteId, tmp-numOfVotes, tmp);
+    }
     return stateErrorTranslate(result);
 }
 
@@ -161,6 +293,9 @@ StateResult stateDeleteVote(State state, int stateToDeleteVote){
     }
     tmp--;
     result = mapPut(state->citizenVotes,&stateToDeleteVote,&tmp);
+    if(result == MAP_SUCCESS){
+        stateTopVotesUpdate(state, stateToDeleteVote, tmp+1, tmp);
+    }
     return stateErrorTranslate(result);
 }
 
@@ -168,9 +303,179 @@ StateResult stateDeleteAllVotesOfSpecificState(State state, int stateToDeleteVot
     if(!state) return STATE_NULL_ARGUMENT;
     if(stateToDeleteVotes<0) return STATE_INVALID_ID;
     MapResult result = mapRemove(state->citizenVotes,&stateToDeleteVotes);
+    if(result == MAP_SUCCESS){
+        stateTopVotesUpdate(state, stateToDeleteVotes, 1, 0);
+    }
     return stateErrorTranslate(result);
 }
 
+StateResult stateDeleteVotesOfStates(State state, const int *sortedIds,
+                                     int numOfIds){
+    if(!state||!sortedIds) return STATE_NULL_ARGUMENT;
+    for(int i=0; i<numOfIds; i++){
+        if(mapRemove(state->citizenVotes,
+                     (int*)&sortedIds[i]) == MAP_SUCCESS){
+            stateTopVotesUpdate(state, sortedIds[i], 1, 0);
+        }
+    }
+    return STATE_SUCCESS;
+}
+
+StateResult stateMergeVotes(State state, State votes){
+    if(!state||!votes) return STATE_NULL_ARGUMENT;
+    if(mapGetSize(votes->citizenVotes) == 0) return STATE_SUCCESS;
+    MapResult result = mapMerge(state->citizenVotes, votes->citizenVotes,
+                                stateAddInt);
+    state->topVotesDirty = true;
+    return stateErrorTranslate(result);
+}
+
+int stateTopVotesFind(State state, int stateId){
+    for(int i=0; i<state->numOfTopVotes; i++){
+        if(state->topStates[i] == stateId) return i;
+    }
+    return -1;
+}
+
+void stateTopVotesInsert(State state, int stateId, int numOfVotes){
+    scoreTopVotesInsert(state->topStates, state->topVotes,
+                        &state->numOfTopVotes, stateId, numOfVotes);
+}
+
+void stateTopVotesRemoveAt(State state, int index){
+    int toMove = state->numOfTopVotes-index-1;
+    memmove(state->topStates+index, state->topStates+index+1,
+            sizeof(int)*toMove);
+    memmove(state->topVotes+index, state->topVotes+index+1,
+            sizeof(int)*toMove);
+    state->numOfTopVotes--;
+}
+
+void stateTopVotesUpdate(State state, int stateId, int oldVotes,
+                         int newVotes){
+    if(state->topVotesDirty) return;
+    int index = stateTopVotesFind(state, stateId);
+    int numOfUncached = mapGetSize(state->citizenVotes)-
+                        state->numOfTopVotes;
+    if(index == -1){
+        if(newVotes <= oldVotes) return;
+        int last = state->numOfTopVotes-1;
+        if(state->numOfTopVotes < NUM_OF_TOP_VOTES ||
+           scoreTopVotesBefore(newVotes, stateId, state->topVotes[last],
+                               state->topStates[last])){
+            stateTopVotesInsert(state, stateId, newVotes);
+        }
+        return;
+    }
+    stateTopVotesRemoveAt(state, index);
+    if(newVotes == 0){
+        numOfUncached++;
+    }
+    else{
+        stateTopVotesInsert(state, stateId, newVotes);
+        if(newVotes > oldVotes ||
+           state->topStates[state->numOfTopVotes-1] != stateId){
+            return;
+        }
+    }
+    if(numOfUncached > 0){
+        state->topVotesDirty = true;
+    }
+}
+
+void stateTopVotesRebuild(State state){
+    state->numOfTopVotes = 0;
+    MAP_FOREACH(int*, stateIdIter, state->citizenVotes){
+        int numOfVotes = *(int*)mapGet(state->citizenVotes, stateIdIter);
+        int last = state->numOfTopVotes-1;
+        if(state->numOfTopVotes < NUM_OF_TOP_VOTES ||
+           scoreTopVotesBefore(numOfVotes, *stateIdIter,
+                               state->topVotes[last],
+                               state->topStates[last])){
+            stateTopVotesInsert(state, *stateIdIter, numOfVotes);
+        }
+    }
+    state->topVotesDirty = false;
+}
+
+int stateGetTopVotes(State state, int topStates[NUM_OF_TOP_VOTES],
+                     int topVotes[NUM_OF_TOP_VOTES]){
+    if(!state||!topStates) return -1;
+    if(state->topVotesDirty){
+        stateTopVotesRebuild(state);
+    }
+    memcpy(topStates, state->topStates, sizeof(int)*state->numOfTopVotes);
+    if(topVotes){
+        memcpy(topVotes, state->topVotes, sizeof(int)*state->numOfTopVotes);
+    }
+    return state->numOfTopVotes;
+}
+
+bool stateIdsContain(const int *sortedIds, int numOfIds, int stateId){
+    int low = 0, high = numOfIds-1;
+    while(low<=high){
+        int middle = low+(high-low)/2;
+        if(sortedIds[middle]==stateId) return true;
+        if(sortedIds[middle]<stateId){
+            low = middle+1;
+        }
+        else{
+            high = middle-1;
+        }
+    }
+    return false;
+}
+
+int stateGetTopVotesExcept(State state, const int *sortedIds, int numOfIds,
+                           int topStates[NUM_OF_TOP_VOTES],
+                           int topVotes[NUM_OF_TOP_VOTES]){
+    if(!state||!topStates||(!sortedIds && numOfIds>0)) return -1;
+    if(state->topVotesDirty){
+        stateTopVotesRebuild(state);
+    }
+    int votes[NUM_OF_TOP_VOTES];
+    int numOfTopVotes = 0;
+    for(int i=0; i<state->numOfTopVotes; i++){
+        if(!stateIdsContain(sortedIds, numOfIds, state->topStates[i])){
+            topStates[numOfTopVotes] = state->topStates[i];
+            votes[numOfTopVotes] = state->topVotes[i];
+            numOfTopVotes++;
+        }
+    }
+    if(numOfTopVotes < state->numOfTopVotes &&
+       mapGetSize(state->citizenVotes) > state->numOfTopVotes){
+        numOfTopVotes = 0;
+        MAP_FOREACH(int*, stateIdIter, state->citizenVotes){
+            if(stateIdsContain(sortedIds, numOfIds, *stateIdIter)) continue;
+            int numOfVotes = *(int*)mapGet(state->citizenVotes, stateIdIter);
+            scoreTopVotesInsert(topStates, votes, &numOfTopVotes,
+                                *stateIdIter, numOfVotes);
+        }
+    }
+    if(topVotes){
+        memcpy(topVotes, votes, sizeof(int)*numOfTopVotes);
+    }
+    return numOfTopVotes;
+}
+
+int stateCompareName(State state1, State state2){
+    if(!state1||!state2) return 0;
+    if(state1->pool && state1->pool == state2->pool){
+        int rank1 = stringPoolGetRank(state1->pool, state1->name);
+        int rank2 = stringPoolGetRank(state2->pool, state2->name);
+        if(rank1 >= 0 && rank2 >= 0){
+            return rank1-rank2;
+        }
+    }
+    return strcmp(state1->name, state2->name);
+}
+
+int stateGetFavoriteStateId(State state){
+    int topStates[NUM_OF_TOP_VOTES];
+    if(stateGetTopVotes(state, topStates, NULL) <= 0) return -1;
+    return topStates[0];
+}
+
 int stateMapKeyCompare(MapKeyElement stateId1, MapKeyElement stateId2){
     return stateCompareInts(stateId1, stateId2);
 }
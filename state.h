@@ -3,6 +3,8 @@
 
 #include <stdbool.h>
 #include "map.h"
+#include "stringpool.h"
+#include "score.h"
 
 /**
  * Eurovision State ADT
@@ -10,8 +12,13 @@
  * The following functions are available:
  *
  * stateCreate                        - Allocate a new State according to the arguments.
+ * stateCreateInPool                  - Allocate a new State with names interned in a
+ *                                      StringPool.
+ * stateCreateWithAllocator           - Allocate a new State through an Allocator.
  * stateDestroy                       - Deallocate the State send as an argument.
  * stateCopy                          - Return a copy of the State send as an argument.
+ * stateFreeze                        - Return a copy of the State with its top votes
+ *                                      but without its citizen votes.
  * stateGetName                       - Return the State name.
  * stateGetSong                       - Return the State song name.
  * stateGetId                         - Return the State Id.
@@ -20,9 +27,19 @@
  * stateSetScore                      - Change the state final score.
  * stateGetNumOfVotes                 - Return the number of votes to a specific state.
  * stateAddVote                       - Add one vote to a specific state.
+ * stateAddVotes                      - Add several votes to a specific state.
  * stateDeleteVote                    - Delete one vote from a specific state.
  * stateDeleteAllVotesOfSpecificState - Delete all votes for specific state.
+ * stateMergeVotes                    - Add all the citizen votes of another
+ *                                      state to the State.
+ * stateDeleteVotesOfStates           - Delete all votes for several states.
  * stateDeleteAllVotes                - Deallocate all the citizenVotes map container.
+ * stateGetTopVotes                   - Return the states this state voted the most
+ *                                      to, from the cached top votes.
+ * stateGetTopVotesExcept             - Return the states this state voted the most
+ *                                      to, skipping some states.
+ * stateGetFavoriteStateId            - Return the id of the most voted state.
+ * stateCompareName                   - compare two States according to their names.
  * stateVotesContain                  - Check if citizen votes contain a vote to a
  *                                      specific state.
  * stateMapKeyCompare                 - compare two States according to their ids as a
@@ -36,6 +53,9 @@
  * stateErrorTranslate                - Changing a MapResult type to StateResult type.
 */
 
+/** Number of most voted states each State keeps cached */
+#define NUM_OF_TOP_VOTES SCORE_TOP_VOTES
+
 /** Type for defining a State */
 typedef struct State_t *State;
 
@@ -44,6 +64,7 @@ typedef enum StateResult_t{
     STATE_NULL_ARGUMENT,
     STATE_OUT_OF_MEMORY,
     STATE_INVALID_ID,
+    STATE_VOTES_OVERFLOW,
    /* STATE_INVALID_NAME,
     STATE_VOTE_STATE_DOESNT_EXIST,*/
     STATE_SUCCESS
@@ -62,6 +83,49 @@ typedef enum StateResult_t{
 */
 State stateCreate(int stateId, const char* stateName, const char* stateSong);
 
+/**
+* stateCreateInPool: Allocates a new State that keeps its names in a pool
+*
+* The name and song are interned in pool instead of being allocated for the
+* state, copies of the state share the same pooled names and the names are
+* not freed with the state. The pool must outlive the state and its copies.
+*
+* @param stateId - the state id value, most be positive number or 0.
+* @param stateName - the new state name as a char*.
+* @param stateSong - the new state song name as a char*.
+* @param pool - the pool to intern the names in, NULL to allocate them like
+*               stateCreate does.
+* @return
+* 	NULL - if one of the parameters is NULL or allocations failed.
+* 	NULL - if stateId<0
+* 	A new State in case of success with no votes.
+*/
+State stateCreateInPool(int stateId, const char* stateName,
+                        const char* stateSong, StringPool pool);
+
+/**
+* stateCreateWithAllocator: Allocates a new State like stateCreateInPool,
+* the state, its citizen votes and its names (when pool is NULL) are
+* allocated through allocator
+*
+* The state struct is counted as ALLOCATOR_STATES, the citizen votes as map
+* nodes, keys and ALLOCATOR_VOTE_COUNTERS and the names as ALLOCATOR_STRINGS.
+* Copies of the state use the same allocator, it must outlive them.
+*
+* @param stateId - the state id value, most be positive number or 0.
+* @param stateName - the new state name as a char*.
+* @param stateSong - the new state song name as a char*.
+* @param pool - the pool to intern the names in, NULL to allocate them.
+* @param allocator - the allocator to use, NULL to use malloc and free.
+* @return
+* 	NULL - if one of the parameters is NULL or allocations failed.
+* 	NULL - if stateId<0
+* 	A new State in case of success with no votes.
+*/
+State stateCreateWithAllocator(int stateId, const char* stateName,
+                               const char* stateSong, StringPool pool,
+                               Allocator allocator);
+
 /**
 * stateDestroy: Deallocate a state
 *
@@ -79,6 +143,29 @@ void stateDestroy(State state);
 */
 State stateCopy(State state);
 
+/**
+* stateFreeze: Allocates a frozen copy of a state, that keeps the id, names,
+* final score and top votes of the state but not its citizen votes
+*
+* A frozen state can be ranked (stateGetTopVotes, stateGetFavoriteStateId)
+* and copied, its votes must not be changed and stateGetCitizenVotes returns
+* NULL for it. It is created in O(NUM_OF_TOP_VOTES) and does not share any
+* memory with state.
+*
+* @param state - the state to freeze
+* @param sortedIds - ids of states to leave out of the top votes, like in
+*                    stateGetTopVotesExcept
+* @param numOfIds - the number of ids in sortedIds
+* @param pool - the pool to intern the names in, NULL to allocate them.
+* @param allocator - the allocator to use, NULL to use malloc and free.
+* @return
+* 	NULL - if state is NULL, sortedIds is NULL and numOfIds>0 or an
+* 	       allocation failed.
+* 	A frozen copy of the state in case of success.
+*/
+State stateFreeze(State state, const int *sortedIds, int numOfIds,
+                  StringPool pool, Allocator allocator);
+
 /**
 * stateGetId - Function to get the state id
 *
@@ -165,6 +252,23 @@ int stateGetNumOfVotes(State state, int stateToSearch);
 */
 StateResult stateAddVote(State state, int stateToVoteId);
 
+/**
+* stateAddVotes - add numOfVotes votes to a specific state with one update
+* of the citizen votes
+*
+* @param state - the state that votes
+* @param stateToVoteId - state id to add the votes to
+* @param numOfVotes - the number of votes to add
+* @return
+* 	STATE_NULL_ARGUMENT - if one of the parameters send is NULL
+* 	STATE_INVALID_ID - if stateToVoteId is a negative number
+* 	STATE_OUT_OF_MEMORY - in case of a allocation error
+* 	STATE_VOTES_OVERFLOW - if the votes to stateToVoteId would pass INT_MAX,
+* 	                       nothing is added
+* 	STATE_SUCCESS - if the votes were added, or numOfVotes is not positive
+*/
+StateResult stateAddVotes(State state, int stateToVoteId, int numOfVotes);
+
 /**
 * stateDeleteVote - Delete one vote from a specific state
 *
@@ -189,6 +293,109 @@ StateResult stateDeleteVote(State state, int stateToDeleteVote);
 */
 StateResult stateDeleteAllVotesOfSpecificState(State state, int stateToDeleteVotes);
 
+/**
+* stateDeleteVotesOfStates - Delete all votes to several states, like
+* calling stateDeleteAllVotesOfSpecificState for each of them
+*
+* @param state - the state that votes
+* @param sortedIds - the ids of the states to delete all votes from, in
+*                    ascending order
+* @param numOfIds - the number of ids in sortedIds
+* @return
+* 	STATE_NULL_ARGUMENT - if one of the parameters send is NULL
+* 	STATE_SUCCESS - otherwise
+*/
+StateResult stateDeleteVotesOfStates(State state, const int *sortedIds,
+                                     int numOfIds);
+
+/**
+* stateMergeVotes - Add the citizen votes of votes to the citizen votes of
+* state, in one pass over both votes map containers. A sum of votes that
+* would pass INT_MAX is kept at INT_MAX.
+*
+* @param state - the state to add the votes to
+* @param votes - the state to take the votes from (like the same state in
+*                another shard of the votes), it is not changed
+* @return
+* 	STATE_NULL_ARGUMENT - if one of the parameters send is NULL
+* 	STATE_OUT_OF_MEMORY - in case of an allocation error, the votes before
+* 	                      the failure are already added
+* 	STATE_SUCCESS - if all the votes were added
+*/
+StateResult stateMergeVotes(State state, State votes);
+
+/**
+* stateGetTopVotes - Function to get the states this state voted the most to
+*
+* The top votes are cached inside the state and kept up to date by
+* stateAddVote, stateDeleteVote and stateDeleteAllVotesOfSpecificState and
+* rebuilt after stateMergeVotes.
+* When a removal may have pushed an uncached state into the top votes the
+* cache is rebuilt from the citizen votes on the next call.
+*
+* @param state - the state that voted
+* @param topStates - array to fill with the voted states ids, the most voted
+*                    state is at index 0. States with the same num of votes
+*                    are ordered by ascending id.
+* @param topVotes - array to fill with the num of votes of each state in
+*                   topStates, may be NULL.
+* @return
+* 	-1 - if state or topStates is NULL
+* 	the number of states written to topStates (at most NUM_OF_TOP_VOTES)
+*/
+int stateGetTopVotes(State state, int topStates[NUM_OF_TOP_VOTES],
+                     int topVotes[NUM_OF_TOP_VOTES]);
+
+/**
+* stateGetTopVotesExcept - Function to get the states this state voted the
+* most to, as if its votes to some states were deleted
+*
+* Uses the cached top votes, the citizen votes are scanned only when one of
+* the skipped states is in the cached top votes and there are more voted
+* states than cached ones.
+*
+* @param state - the state that voted
+* @param sortedIds - the ids of the states to skip, in ascending order
+* @param numOfIds - the number of ids in sortedIds
+* @param topStates - array to fill with the voted states ids, ordered like
+*                    in stateGetTopVotes.
+* @param topVotes - array to fill with the num of votes of each state in
+*                   topStates, may be NULL.
+* @return
+* 	-1 - if state or topStates is NULL, or sortedIds is NULL and numOfIds>0
+* 	the number of states written to topStates (at most NUM_OF_TOP_VOTES)
+*/
+int stateGetTopVotesExcept(State state, const int *sortedIds, int numOfIds,
+                           int topStates[NUM_OF_TOP_VOTES],
+                           int topVotes[NUM_OF_TOP_VOTES]);
+
+/**
+* stateGetFavoriteStateId - Function to get the id of the most voted state
+*
+* @param state - the state that voted
+* @return
+* 	-1 - if the parameter send is NULL or the state didn't vote
+* 	the id of the state that got the most votes from this state, the lowest
+* 	id if there is more than one
+*/
+int stateGetFavoriteStateId(State state);
+
+/**
+* stateCompareName - compare two states names
+*
+* States that keep their names in the same pool are compared by the pooled
+* names collation ranks, other states are compared with strcmp. Both give
+* the same order.
+*
+* @param state1 - the first state to compare
+* @param state2 - the second state to compare
+* @return
+* 		A positive integer if the first name is greater;
+* 		0 if they're equal or one of the parameters is NULL;
+*		A negative integer if the second name is greater.
+*/
+int stateCompareName(State state1, State state2);
+
 /**
 * stateMapKeyCompare: compare two judges ids
 *
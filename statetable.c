@@ -0,0 +1,233 @@
+#include <stdlib.h>
+#include <string.h>
+#include "statetable.h"
+
+#ifdef MAP_STATS
+#define STATE_TABLE_STATS_ADD(table, counter, amount) \
+    ((table)->stats.counter += (amount))
+#else
+#define STATE_TABLE_STATS_ADD(table, counter, amount) ((void)0)
+#endif
+
+/** return the first row whose id is not smaller than stateId */
+int stateTableSearch(StateTable table, int stateId);
+
+/** make room for size rows in all the columns */
+bool stateTableReserve(StateTable table, int size);
+
+/** move the numOfRows rows from row from to row to in all the columns */
+void stateTableMoveRows(StateTable table, int to, int from, int numOfRows);
+
+/** write state in row, with a zero score */
+void stateTableSetRow(StateTable table, int row, State state);
+
+struct StateTable_t{
+    int* ids;
+    double* scores;
+    State* states;
+    int size;
+    int capacity;
+    Allocator allocator;
+    MapStats stats;
+};
+
+StateTable stateTableCreate(Allocator allocator){
+    StateTable table = allocatorAllocate(allocator, ALLOCATOR_STATES,
+                                         sizeof(*table));
+    if(!table) return NULL;
+    table->ids = NULL;
+    table->scores = NULL;
+    table->states = NULL;
+    table->size = 0;
+    table->capacity = 0;
+    table->allocator = allocator;
+    memset(&table->stats, 0, sizeof(table->stats));
+    return table;
+}
+
+void stateTableDestroy(StateTable table){
+    if(!table) return;
+    for(int i=0; i<table->size; i++){
+        stateDestroy(table->states[i]);
+    }
+    allocatorFree(table->allocator, table->ids);
+    allocatorFree(table->allocator, table->scores);
+    allocatorFree(table->allocator, table->states);
+    allocatorFree(table->allocator, table);
+}
+
+int stateTableGetSize(StateTable table){
+    return table ? table->size : -1;
+}
+
+int stateTableSearch(StateTable table, int stateId){
+    int low = 0, high = table->size;
+    while(low < high){
+        int middle = low+(high-low)/2;
+        STATE_TABLE_STATS_ADD(table, compares, 1);
+        if(table->ids[middle] < stateId){
+            low = middle+1;
+        }
+        else{
+            high = middle;
+        }
+    }
+    return low;
+}
+
+int stateTableFind(StateTable table, int stateId){
+    if(!table) return -1;
+    int row = stateTableSearch(table, stateId);
+    return row < table->size && table->ids[row] == stateId ? row : -1;
+}
+
+int stateTableLowerBound(StateTable table, int stateId){
+    if(!table) return -1;
+    return stateTableSearch(table, stateId);
+}
+
+int stateTableUpperBound(StateTable table, int stateId){
+    if(!table) return -1;
+    int row = stateTableSearch(table, stateId);
+    return row < table->size && table->ids[row] == stateId ? row+1 : row;
+}
+
+State stateTableGet(StateTable table, int stateId){
+    int row = stateTableFind(table, stateId);
+    return row >= 0 ? table->states[row] : NULL;
+}
+
+bool stateTableReserve(StateTable table, int size){
+    if(size <= table->capacity) return true;
+    int capacity = table->capacity > 0 ? table->capacity*2 : 4;
+    if(capacity < size){
+        capacity = size;
+    }
+    int* ids = allocatorAllocate(table->allocator, ALLOCATOR_STATES,
+                                 sizeof(int)*capacity);
+    double* scores = allocatorAllocate(table->allocator, ALLOCATOR_STATES,
+                                       sizeof(double)*capacity);
+    State* states = allocatorAllocate(table->allocator, ALLOCATOR_STATES,
+                                      sizeof(State)*capacity);
+    if(!ids||!scores||!states){
+        allocatorFree(table->allocator, ids);
+        allocatorFree(table->allocator, scores);
+        allocatorFree(table->allocator, states);
+        return false;
+    }
+    STATE_TABLE_STATS_ADD(table, allocations, 1);
+    if(table->size > 0){
+        memcpy(ids, table->ids, sizeof(int)*table->size);
+        memcpy(scores, table->scores, sizeof(double)*table->size);
+        memcpy(states, table->states, sizeof(State)*table->size);
+    }
+    allocatorFree(table->allocator, table->ids);
+    allocatorFree(table->allocator, table->scores);
+    allocatorFree(table->allocator, table->states);
+    table->ids = ids;
+    table->scores = scores;
+    table->states = states;
+    table->capacity = capacity;
+    return true;
+}
+
+void stateTableMoveRows(StateTable table, int to, int from, int numOfRows){
+    memmove(table->ids+to, table->ids+from, sizeof(int)*numOfRows);
+    memmove(table->scores+to, table->scores+from, sizeof(double)*numOfRows);
+    memmove(table->states+to, table->states+from, sizeof(State)*numOfRows);
+}
+
+void stateTableSetRow(StateTable table, int row, State state){
+    table->ids[row] = stateGetId(state);
+    table->scores[row] = 0;
+    table->states[row] = state;
+}
+
+StateTableResult stateTableAdd(StateTable table, State state){
+    if(!table||!state) return STATE_TABLE_NULL_ARGUMENT;
+    int stateId = stateGetId(state);
+    int row = table->size;
+    if(row > 0 && table->ids[row-1] >= stateId){
+        row = stateTableSearch(table, stateId);
+        if(table->ids[row] == stateId) return STATE_TABLE_STATE_ALREADY_EXIST;
+    }
+    if(!stateTableReserve(table, table->size+1)){
+        return STATE_TABLE_OUT_OF_MEMORY;
+    }
+    stateTableMoveRows(table, row+1, row, table->size-row);
+    stateTableSetRow(table, row, state);
+    table->size++;
+    return STATE_TABLE_SUCCESS;
+}
+
+StateTableResult stateTableAddBulk(StateTable table, State *states,
+                                   int numOfStates){
+    if(!table||!states) return STATE_TABLE_NULL_ARGUMENT;
+    for(int i=0; i<numOfStates; i++){
+        if(!states[i]) return STATE_TABLE_NULL_ARGUMENT;
+        int stateId = stateGetId(states[i]);
+        if((i>0 && stateGetId(states[i-1]) >= stateId) ||
+           stateTableFind(table, stateId) >= 0){
+            return STATE_TABLE_STATE_ALREADY_EXIST;
+        }
+    }
+    if(!stateTableReserve(table, table->size+numOfStates)){
+        return STATE_TABLE_OUT_OF_MEMORY;
+    }
+    int old = table->size-1, added = numOfStates-1;
+    for(int row = table->size+numOfStates-1; added>=0; row--){
+        if(old>=0 && table->ids[old] > stateGetId(states[added])){
+            stateTableMoveRows(table, row, old--, 1);
+        }
+        else{
+            stateTableSetRow(table, row, states[added--]);
+        }
+    }
+    table->size += numOfStates;
+    return STATE_TABLE_SUCCESS;
+}
+
+StateTableResult stateTableRemoveBulk(StateTable table, const int *sortedIds,
+                                      int numOfIds){
+    if(!table||!sortedIds) return STATE_TABLE_NULL_ARGUMENT;
+    int kept = 0, next = 0;
+    for(int row=0; row<table->size; row++){
+        while(next<numOfIds && sortedIds[next] < table->ids[row]){
+            next++;
+        }
+        if(next<numOfIds && sortedIds[next] == table->ids[row]){
+            stateDestroy(table->states[row]);
+        }
+        else{
+            stateTableMoveRows(table, kept++, row, 1);
+        }
+    }
+    table->size = kept;
+    return STATE_TABLE_SUCCESS;
+}
+
+const int* stateTableGetIds(StateTable table){
+    return table && table->size > 0 ? table->ids : NULL;
+}
+
+double* stateTableGetScores(StateTable table){
+    return table && table->size > 0 ? table->scores : NULL;
+}
+
+State* stateTableGetStates(StateTable table){
+    return table && table->size > 0 ? table->states : NULL;
+}
+
+void stateTableGetStats(StateTable table, MapStats *stats){
+    if(!stats) return;
+    if(!table){
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = table->stats;
+}
+
+void stateTableResetStats(StateTable table){
+    if(!table) return;
+    memset(&table->stats, 0, sizeof(table->stats));
+}
@@ -0,0 +1,227 @@
+#ifndef MTM_HW1_EUROVISION_STATETABLE_H
+#define MTM_HW1_EUROVISION_STATETABLE_H
+
+#include "state.h"
+#include "map.h"
+#include "allocator.h"
+
+/**
+ * State Table Container
+ *
+ * Holds the states of a contest by rows sorted by state id, in columns: the
+ * hot columns of ids and scores are plain contiguous arrays the rankings
+ * scan directly, and the states column holds the State of every row, with
+ * its votes table and its cold name and song. A row number is valid until
+ * the table is changed.
+ *
+ * The table owns its states, they are not copied when they are added.
+ *
+ * The following functions are available:
+ *
+ * stateTableCreate     - Allocate a new empty table through an Allocator.
+ * stateTableDestroy    - Deallocate a table and all its states.
+ * stateTableGetSize    - Return the number of rows.
+ * stateTableFind       - Return the row of a state id.
+ * stateTableLowerBound - Return the first row whose id is not smaller than
+ *                        a state id.
+ * stateTableUpperBound - Return the row after the last row whose id is not
+ *                        greater than a state id.
+ * stateTableGet        - Return the State of a state id.
+ * stateTableAdd        - Add a state.
+ * stateTableAddBulk    - Add many states in one pass over the table.
+ * stateTableRemoveBulk - Remove many states in one pass over the table.
+ * stateTableGetIds     - Return the ids column.
+ * stateTableGetScores  - Return the scores column.
+ * stateTableGetStates  - Return the states column.
+ * stateTableGetStats   - Return the operation counters of the table.
+ * stateTableResetStats - Set the operation counters of the table to zero.
+*/
+
+/** Type for defining a State Table */
+typedef struct StateTable_t *StateTable;
+
+/** Type used for returning error codes from state table functions */
+typedef enum StateTableResult_t{
+    STATE_TABLE_NULL_ARGUMENT,
+    STATE_TABLE_OUT_OF_MEMORY,
+    STATE_TABLE_STATE_ALREADY_EXIST,
+    STATE_TABLE_STATE_NOT_EXIST,
+    STATE_TABLE_SUCCESS
+}StateTableResult;
+
+/**
+* stateTableCreate: Allocates a new empty state table
+*
+* @param allocator - the allocator of the columns, NULL to use malloc and
+*                    free.
+* @return
+* 	NULL - if allocations failed.
+* 	A new StateTable in case of success.
+*/
+StateTable stateTableCreate(Allocator allocator);
+
+/**
+* stateTableDestroy: Deallocate a state table and all its states
+*
+* @param table - the table to deallocate, if NULL nothing will be done
+*/
+void stateTableDestroy(StateTable table);
+
+/**
+* stateTableGetSize: Return the number of rows of a state table
+*
+* @param table - the table
+* @return
+* 	-1 - if table is NULL
+* 	the number of states in the table otherwise
+*/
+int stateTableGetSize(StateTable table);
+
+/**
+* stateTableFind: Return the row of a state, in O(log size)
+*
+* @param table - the table to search in
+* @param stateId - the id of the state to search
+* @return
+* 	-1 - if table is NULL or stateId is not in the table
+* 	the row of the state otherwise
+*/
+int stateTableFind(StateTable table, int stateId);
+
+/**
+* stateTableLowerBound: Return the first row whose id is not smaller than
+* stateId
+*
+* @param table - the table to search in
+* @param stateId - the id to search
+* @return
+* 	-1 - if table is NULL
+* 	the row, the size of the table if all the ids are smaller than stateId
+*/
+int stateTableLowerBound(StateTable table, int stateId);
+
+/**
+* stateTableUpperBound: Return the row after the last row whose id is not
+* greater than stateId, so the rows from stateTableLowerBound(from) to
+* stateTableUpperBound(to) (not included) are the states with ids from from
+* to to.
+*
+* @param table - the table to search in
+* @param stateId - the id to search
+* @return
+* 	-1 - if table is NULL
+* 	the row, 0 if all the ids are greater than stateId
+*/
+int stateTableUpperBound(StateTable table, int stateId);
+
+/**
+* stateTableGet: Return the State of a state id
+*
+* @param table - the table to search in
+* @param stateId - the id of the state to search
+* @return
+* 	NULL - if table is NULL or stateId is not in the table
+* 	the State, owned by the table, otherwise
+*/
+State stateTableGet(StateTable table, int stateId);
+
+/**
+* stateTableAdd: Add a state to its row by its id, the table takes the
+* state, on an error it stays the caller's. Adding states by ascending ids
+* appends them without moving rows.
+*
+* @param table - the table to add to
+* @param state - the state to add
+* @return
+* 	STATE_TABLE_NULL_ARGUMENT - if table or state is NULL
+* 	STATE_TABLE_STATE_ALREADY_EXIST - if the id of state is in the table
+* 	STATE_TABLE_OUT_OF_MEMORY - in case of an allocation error
+* 	STATE_TABLE_SUCCESS - if the state was added
+*/
+StateTableResult stateTableAdd(StateTable table, State state);
+
+/**
+* stateTableAddBulk: Add numOfStates states with ascending ids in one pass
+* over the table, the table takes the states. On an error none of them is
+* added and they stay the caller's.
+*
+* @param table - the table to add to
+* @param states - the states to add, sorted by ascending ids
+* @param numOfStates - the number of states
+* @return
+* 	STATE_TABLE_NULL_ARGUMENT - if table or states is NULL
+* 	STATE_TABLE_STATE_ALREADY_EXIST - if an id is in the table or the ids
+* 	                                  are not ascending
+* 	STATE_TABLE_OUT_OF_MEMORY - in case of an allocation error
+* 	STATE_TABLE_SUCCESS - if the states were added
+*/
+StateTableResult stateTableAddBulk(StateTable table, State *states,
+                                   int numOfStates);
+
+/**
+* stateTableRemoveBulk: Remove and deallocate the states with numOfIds
+* ascending ids in one pass over the table, ids that are not in the table
+* are ignored.
+*
+* @param table - the table to remove from
+* @param sortedIds - the ids of the states to remove, in ascending order
+* @param numOfIds - the number of ids
+* @return
+* 	STATE_TABLE_NULL_ARGUMENT - if table or sortedIds is NULL
+* 	STATE_TABLE_SUCCESS - otherwise
+*/
+StateTableResult stateTableRemoveBulk(StateTable table, const int *sortedIds,
+                                      int numOfIds);
+
+/**
+* stateTableGetIds: Return the ids column, ids[row] is the id of a row.
+* The column is valid until the table is changed.
+*
+* @param table - the table
+* @return
+* 	NULL - if table is NULL or empty
+* 	the ids column otherwise
+*/
+const int* stateTableGetIds(StateTable table);
+
+/**
+* stateTableGetScores: Return the scores column, scores[row] is the final
+* score of a row in the last ranking it took part in (0 before that). The
+* rankings write the column directly. It is valid until the table is
+* changed.
+*
+* @param table - the table
+* @return
+* 	NULL - if table is NULL or empty
+* 	the scores column otherwise
+*/
+double* stateTableGetScores(StateTable table);
+
+/**
+* stateTableGetStates: Return the states column, states[row] is the State
+* of a row. The column is valid until the table is changed.
+*
+* @param table - the table
+* @return
+* 	NULL - if table is NULL or empty
+* 	the states column otherwise
+*/
+State* stateTableGetStates(StateTable table);
+
+/**
+* stateTableGetStats: Copies the operation counters of a table, the compares
+* of its id searches are counted when compiled with MAP_STATS
+*
+* @param table - the table
+* @param stats - the counters to fill, all zero if table is NULL
+*/
+void stateTableGetStats(StateTable table, MapStats *stats);
+
+/**
+* stateTableResetStats: Sets all the operation counters of a table to zero
+*
+* @param table - the table, if NULL nothing will be done
+*/
+void stateTableResetStats(StateTable table);
+
+#endif
@@ -0,0 +1,204 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "stringpool.h"
+
+#define ARENA_BLOCK_SIZE 4096
+#define INITIAL_CAPACITY 64
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+/** Type for defining an interned string, the string is stored inline */
+typedef struct PoolEntry_t{
+    int rank;
+    unsigned hash;
+    char str[];
+}*PoolEntry;
+
+/** Type for defining one arena block of the pool */
+typedef struct ArenaBlock_t{
+    struct ArenaBlock_t* next;
+    size_t used;
+    size_t size;
+    char data[];
+}*ArenaBlock;
+
+struct StringPool_t{
+    Allocator allocator;
+    ArenaBlock blocks;
+    PoolEntry* table;
+    int capacity;
+    PoolEntry* entries;
+    int numOfEntries;
+    bool ranksDirty;
+};
+
+/** return the FNV-1a hash of str */
+unsigned stringPoolHash(const char* str);
+
+/** allocate size bytes from the pool arena */
+void* stringPoolArenaAllocate(StringPool pool, size_t size);
+
+/** double the size of the hash table and the entries array */
+bool stringPoolGrow(StringPool pool);
+
+/** compare function for pool entries for qsort */
+int stringPoolEntryCompare(const void* entry1, const void* entry2);
+
+/** recalculate the rank of every interned string */
+bool stringPoolUpdateRanks(StringPool pool);
+
+unsigned stringPoolHash(const char* str){
+    unsigned hash = FNV_OFFSET;
+    while(*str){
+        hash ^= (unsigned char)*str;
+        hash *= FNV_PRIME;
+        str++;
+    }
+    return hash;
+}
+
+void* stringPoolArenaAllocate(StringPool pool, size_t size){
+    size = (size + sizeof(void*)-1) & ~(sizeof(void*)-1);
+    ArenaBlock block = pool->blocks;
+    if(!block || block->size-block->used < size){
+        size_t blockSize = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        block = allocatorAllocate(pool->allocator, ALLOCATOR_STRINGS,
+                                  sizeof(*block)+blockSize);
+        if(!block) return NULL;
+        block->used = 0;
+        block->size = blockSize;
+        block->next = pool->blocks;
+        pool->blocks = block;
+    }
+    void* result = block->data+block->used;
+    block->used += size;
+    return result;
+}
+
+bool stringPoolGrow(StringPool pool){
+    int newCapacity = pool->capacity*2;
+    PoolEntry* newTable = allocatorAllocate(pool->allocator, ALLOCATOR_STRINGS,
+                                            sizeof(PoolEntry)*newCapacity);
+    PoolEntry* newEntries = allocatorAllocate(pool->allocator,
+                                              ALLOCATOR_STRINGS,
+                                              sizeof(PoolEntry)*newCapacity);
+    if(!newTable||!newEntries){
+        allocatorFree(pool->allocator, newTable);
+        allocatorFree(pool->allocator, newEntries);
+        return false;
+    }
+    memset(newTable, 0, sizeof(PoolEntry)*newCapacity);
+    memcpy(newEntries, pool->entries, sizeof(PoolEntry)*pool->numOfEntries);
+    allocatorFree(pool->allocator, pool->entries);
+    pool->entries = newEntries;
+    for(int i=0; i<pool->numOfEntries; i++){
+        unsigned index = pool->entries[i]->hash & (newCapacity-1);
+        while(newTable[index]){
+            index = (index+1) & (newCapacity-1);
+        }
+        newTable[index] = pool->entries[i];
+    }
+    allocatorFree(pool->allocator, pool->table);
+    pool->table = newTable;
+    pool->capacity = newCapacity;
+    return true;
+}
+
+StringPool stringPoolCreate(){
+    return stringPoolCreateWithAllocator(NULL);
+}
+
+StringPool stringPoolCreateWithAllocator(Allocator allocator){
+    StringPool pool = allocatorAllocate(allocator, ALLOCATOR_STRINGS,
+                                        sizeof(*pool));
+    if(!pool) return NULL;
+    pool->allocator = allocator;
+    pool->blocks = NULL;
+    pool->capacity = INITIAL_CAPACITY;
+    pool->numOfEntries = 0;
+    pool->ranksDirty = false;
+    pool->table = allocatorAllocate(allocator, ALLOCATOR_STRINGS,
+                                    sizeof(PoolEntry)*pool->capacity);
+    pool->entries = allocatorAllocate(allocator, ALLOCATOR_STRINGS,
+                                      sizeof(PoolEntry)*pool->capacity);
+    if(!pool->table || !pool->entries){
+        stringPoolDestroy(pool);
+        return NULL;
+    }
+    memset(pool->table, 0, sizeof(PoolEntry)*pool->capacity);
+    return pool;
+}
+
+void stringPoolDestroy(StringPool pool){
+    if(!pool) return;
+    while(pool->blocks){
+        ArenaBlock next = pool->blocks->next;
+        allocatorFree(pool->allocator, pool->blocks);
+        pool->blocks = next;
+    }
+    allocatorFree(pool->allocator, pool->table);
+    allocatorFree(pool->allocator, pool->entries);
+    allocatorFree(pool->allocator, pool);
+}
+
+char* stringPoolIntern(StringPool pool, const char* str){
+    if(!pool||!str) return NULL;
+    unsigned hash = stringPoolHash(str);
+    unsigned index = hash & (pool->capacity-1);
+    while(pool->table[index]){
+        PoolEntry entry = pool->table[index];
+        if(entry->hash == hash && strcmp(entry->str, str) == 0){
+            return entry->str;
+        }
+        index = (index+1) & (pool->capacity-1);
+    }
+    if((pool->numOfEntries+1)*10 > pool->capacity*7){
+        if(!stringPoolGrow(pool)) return NULL;
+        index = hash & (pool->capacity-1);
+        while(pool->table[index]){
+            index = (index+1) & (pool->capacity-1);
+        }
+    }
+    size_t length = strlen(str);
+    PoolEntry entry = stringPoolArenaAllocate(pool,
+                                              sizeof(*entry)+length+1);
+    if(!entry) return NULL;
+    entry->hash = hash;
+    entry->rank = -1;
+    memcpy(entry->str, str, length+1);
+    pool->table[index] = entry;
+    pool->entries[pool->numOfEntries] = entry;
+    pool->numOfEntries++;
+    pool->ranksDirty = true;
+    return entry->str;
+}
+
+int stringPoolEntryCompare(const void* entry1, const void* entry2){
+    return strcmp((*(PoolEntry const*)entry1)->str,
+                  (*(PoolEntry const*)entry2)->str);
+}
+
+bool stringPoolUpdateRanks(StringPool pool){
+    PoolEntry* sorted = allocatorAllocate(pool->allocator, ALLOCATOR_STRINGS,
+                                          sizeof(PoolEntry)*
+                                          pool->numOfEntries);
+    if(!sorted) return false;
+    memcpy(sorted, pool->entries, sizeof(PoolEntry)*pool->numOfEntries);
+    qsort(sorted, pool->numOfEntries, sizeof(PoolEntry),
+          stringPoolEntryCompare);
+    for(int i=0; i<pool->numOfEntries; i++){
+        sorted[i]->rank = i;
+    }
+    allocatorFree(pool->allocator, sorted);
+    pool->ranksDirty = false;
+    return true;
+}
+
+int stringPoolGetRank(StringPool pool, const char* interned){
+    if(!pool||!interned) return -1;
+    if(pool->ranksDirty && !stringPoolUpdateRanks(pool)) return -1;
+    PoolEntry entry = (PoolEntry)(interned-offsetof(struct PoolEntry_t, str));
+    return entry->rank;
+}
@@ -0,0 +1,82 @@
+#ifndef MTM_HW1_EUROVISION_STRINGPOOL_H
+#define MTM_HW1_EUROVISION_STRINGPOOL_H
+
+#include "allocator.h"
+
+/**
+ * String Pool
+ *
+ * Interns strings: every distinct string is stored once, in arena blocks
+ * owned by the pool, and interning an equal string again returns the same
+ * pointer. Interned strings are never moved or freed before the pool is
+ * destroyed, so they can be handed out as stable borrowed pointers.
+ * The contents of an interned string must not be changed.
+ *
+ * The following functions are available:
+ *
+ * stringPoolCreate  - Allocate a new empty pool.
+ * stringPoolCreateWithAllocator - Allocate a new empty pool that allocates
+ *                     through an Allocator.
+ * stringPoolDestroy - Deallocate a pool and all of its strings.
+ * stringPoolIntern  - Return the pooled copy of a string, adding it if needed.
+ * stringPoolGetRank - Return the collation rank of an interned string.
+*/
+
+/** Type for defining a String Pool */
+typedef struct StringPool_t *StringPool;
+
+/**
+* stringPoolCreate: Allocates a new empty string pool
+*
+* @return
+* 	NULL - if allocations failed.
+* 	A new StringPool in case of success.
+*/
+StringPool stringPoolCreate();
+
+/**
+* stringPoolCreateWithAllocator: Allocates a new empty string pool, the pool
+* and its strings are allocated through allocator as ALLOCATOR_STRINGS
+*
+* @param allocator - the allocator to use, NULL to use malloc and free
+* @return
+* 	NULL - if allocations failed.
+* 	A new StringPool in case of success.
+*/
+StringPool stringPoolCreateWithAllocator(Allocator allocator);
+
+/**
+* stringPoolDestroy: Deallocate a string pool and all the interned strings
+*
+* @param pool - the pool to deallocate, if NULL nothing will be done
+*/
+void stringPoolDestroy(StringPool pool);
+
+/**
+* stringPoolIntern: Find or add a string in the pool
+*
+* @param pool - the pool to intern the string in
+* @param str - the string to intern
+* @return
+* 	NULL - if one of the parameters is NULL or allocations failed.
+* 	the pooled string equal to str, the same pointer for every equal str
+*/
+char* stringPoolIntern(StringPool pool, const char* str);
+
+/**
+* stringPoolGetRank: Get the position of an interned string when all the
+* interned strings are sorted with strcmp
+*
+* The ranks are recalculated only on the first call after new strings were
+* interned, so comparing two interned strings by rank gives the same order
+* as strcmp without reading them.
+*
+* @param pool - the pool that interned the string
+* @param interned - a string returned by stringPoolIntern of this pool
+* @return
+* 	-1 - if one of the parameters is NULL or allocations failed.
+* 	the rank of the string, equal strings have equal ranks
+*/
+int stringPoolGetRank(StringPool pool, const char* interned);
+
+#endif
@@ -0,0 +1,140 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "threadpool.h"
+
+/** Type for defining a queued task */
+typedef struct QueuedTask_t{
+    ThreadPoolTask task;
+    void* argument;
+    struct QueuedTask_t* next;
+}*QueuedTask;
+
+struct ThreadPool_t{
+    pthread_t* threads;
+    int numOfThreads;
+    pthread_mutex_t lock;
+    pthread_cond_t taskQueued;
+    pthread_cond_t tasksDone;
+    QueuedTask first;
+    QueuedTask last;
+    int numOfUnfinished;
+    bool stopping;
+};
+
+/** the function each worker thread runs, takes queued tasks until the
+ *  pool is stopping and the queue is empty */
+void* threadPoolWorker(void* argument);
+
+/** stop the first numOfThreads worker threads and deallocate the pool */
+void threadPoolStop(ThreadPool pool, int numOfThreads);
+
+void* threadPoolWorker(void* argument){
+    ThreadPool pool = argument;
+    pthread_mutex_lock(&pool->lock);
+    while(true){
+        while(!pool->first && !pool->stopping){
+            pthread_cond_wait(&pool->taskQueued, &pool->lock);
+        }
+        if(!pool->first) break;
+        QueuedTask queued = pool->first;
+        pool->first = queued->next;
+        if(!pool->first){
+            pool->last = NULL;
+        }
+        pthread_mutex_unlock(&pool->lock);
+        queued->task(queued->argument);
+        free(queued);
+        pthread_mutex_lock(&pool->lock);
+        pool->numOfUnfinished--;
+        if(pool->numOfUnfinished == 0){
+            pthread_cond_broadcast(&pool->tasksDone);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+void threadPoolStop(ThreadPool pool, int numOfThreads){
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->taskQueued);
+    pthread_mutex_unlock(&pool->lock);
+    for(int i=0; i<numOfThreads; i++){
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->tasksDone);
+    pthread_cond_destroy(&pool->taskQueued);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
+
+ThreadPool threadPoolCreate(int numOfThreads){
+    if(numOfThreads<1) return NULL;
+    ThreadPool pool = malloc(sizeof(*pool));
+    if(!pool) return NULL;
+    pool->threads = malloc(sizeof(pthread_t)*numOfThreads);
+    if(!pool->threads){
+        free(pool);
+        return NULL;
+    }
+    pool->numOfThreads = numOfThreads;
+    pool->first = NULL;
+    pool->last = NULL;
+    pool->numOfUnfinished = 0;
+    pool->stopping = false;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->taskQueued, NULL);
+    pthread_cond_init(&pool->tasksDone, NULL);
+    for(int i=0; i<numOfThreads; i++){
+        if(pthread_create(&pool->threads[i], NULL, threadPoolWorker,
+                          pool) != 0){
+            threadPoolStop(pool, i);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+void threadPoolDestroy(ThreadPool pool){
+    if(!pool) return;
+    threadPoolStop(pool, pool->numOfThreads);
+}
+
+ThreadPoolResult threadPoolSubmit(ThreadPool pool, ThreadPoolTask task,
+                                  void* argument){
+    if(!pool||!task) return THREAD_POOL_NULL_ARGUMENT;
+    QueuedTask queued = malloc(sizeof(*queued));
+    if(!queued) return THREAD_POOL_OUT_OF_MEMORY;
+    queued->task = task;
+    queued->argument = argument;
+    queued->next = NULL;
+    pthread_mutex_lock(&pool->lock);
+    if(pool->last){
+        pool->last->next = queued;
+    }
+    else{
+        pool->first = queued;
+    }
+    pool->last = queued;
+    pool->numOfUnfinished++;
+    pthread_cond_signal(&pool->taskQueued);
+    pthread_mutex_unlock(&pool->lock);
+    return THREAD_POOL_SUCCESS;
+}
+
+ThreadPoolResult threadPoolWait(ThreadPool pool){
+    if(!pool) return THREAD_POOL_NULL_ARGUMENT;
+    pthread_mutex_lock(&pool->lock);
+    while(pool->numOfUnfinished > 0){
+        pthread_cond_wait(&pool->tasksDone, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return THREAD_POOL_SUCCESS;
+}
+
+int threadPoolGetSize(ThreadPool pool){
+    if(!pool) return -1;
+    return pool->numOfThreads;
+}
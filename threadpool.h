@@ -0,0 +1,86 @@
+#ifndef MTM_HW1_EUROVISION_THREADPOOL_H
+#define MTM_HW1_EUROVISION_THREADPOOL_H
+
+/**
+ * Thread Pool
+ *
+ * A fixed number of worker threads that run submitted tasks in the order
+ * they were submitted. A task is a function and an argument, the pool does
+ * not own the argument.
+ *
+ * The following functions are available:
+ *
+ * threadPoolCreate  - Start a new pool of worker threads.
+ * threadPoolDestroy - Run the remaining tasks and stop the pool.
+ * threadPoolSubmit  - Queue a task.
+ * threadPoolWait    - Wait until all the queued tasks are done.
+ * threadPoolGetSize - Return the number of worker threads.
+*/
+
+/** Type for defining a Thread Pool */
+typedef struct ThreadPool_t *ThreadPool;
+
+/** Type of function run by the pool */
+typedef void(*ThreadPoolTask)(void* argument);
+
+/** Type used for returning error codes from thread pool functions */
+typedef enum ThreadPoolResult_t{
+    THREAD_POOL_NULL_ARGUMENT,
+    THREAD_POOL_OUT_OF_MEMORY,
+    THREAD_POOL_SUCCESS
+}ThreadPoolResult;
+
+/**
+* threadPoolCreate: Start a new pool
+*
+* @param numOfThreads - the number of worker threads, at least 1
+* @return
+* 	NULL - if numOfThreads<1, allocations failed or a thread could not be
+* 	       started.
+* 	A new ThreadPool in case of success.
+*/
+ThreadPool threadPoolCreate(int numOfThreads);
+
+/**
+* threadPoolDestroy: Wait for all the queued tasks, stop the worker threads
+* and deallocate the pool
+*
+* @param pool - the pool to destroy, if NULL nothing will be done
+*/
+void threadPoolDestroy(ThreadPool pool);
+
+/**
+* threadPoolSubmit: Queue a task to run on one of the worker threads
+*
+* @param pool - the pool to run the task
+* @param task - the function to run
+* @param argument - the argument to pass to task
+* @return
+* 	THREAD_POOL_NULL_ARGUMENT - if pool or task is NULL
+* 	THREAD_POOL_OUT_OF_MEMORY - in case of an allocation error
+* 	THREAD_POOL_SUCCESS - if the task was queued
+*/
+ThreadPoolResult threadPoolSubmit(ThreadPool pool, ThreadPoolTask task,
+                                  void* argument);
+
+/**
+* threadPoolWait: Block until every task submitted so far is done
+*
+* @param pool - the pool to wait for
+* @return
+* 	THREAD_POOL_NULL_ARGUMENT - if pool is NULL
+* 	THREAD_POOL_SUCCESS - otherwise
+*/
+ThreadPoolResult threadPoolWait(ThreadPool pool);
+
+/**
+* threadPoolGetSize: Return the number of worker threads of a pool
+*
+* @param pool - the pool
+* @return
+* 	-1 - if pool is NULL
+* 	the number of worker threads otherwise
+*/
+int threadPoolGetSize(ThreadPool pool);
+
+#endif
@@ -0,0 +1,287 @@
+#ifndef TYPEDMAP_H_
+#define TYPEDMAP_H_
+
+#include <stdbool.h>
+#include <string.h>
+#include "allocator.h"
+#include "map.h"
+
+/**
+* Typed Map Generator
+*
+* DEFINE_TYPED_MAP(type, prefix, keyType, dataType, compareKeys, freeData)
+* defines a map type specialized for its keys and data, for a map whose
+* key and data types are known at compile time. Unlike the generic Map
+* there are no void* elements and no copy callbacks: the keys and the data
+* are stored by value in one array sorted by key, the map owns the data put
+* in it, and compareKeys and freeData are called directly so the compiler
+* can inline them. The generic Map stays the container for everything else.
+*
+* The arguments of DEFINE_TYPED_MAP are:
+*   type        - the name of the map type, a pointer to the map like Map.
+*                 The entries are of type type##Entry, with fields key and
+*                 data.
+*   prefix      - the prefix of the names of the map functions.
+*   keyType     - the type of the keys, stored by value.
+*   dataType    - the type of the data, stored by value.
+*   compareKeys - int compareKeys(keyType, keyType), returns a positive
+*                 number if the first key is greater, 0 if they are equal and
+*                 a negative number otherwise.
+*   freeData    - void freeData(dataType), called for the data the map
+*                 drops.
+*
+* The following functions are defined (static, for the file that uses
+* DEFINE_TYPED_MAP):
+*   prefix##Create     - Allocates a new empty map through an Allocator.
+*   prefix##Destroy    - Deallocates the map and frees all its data.
+*   prefix##GetSize    - Returns the number of keys in the map.
+*   prefix##Contains   - Returns whether a key is in the map.
+*   prefix##Get        - Returns a pointer to the data of a key, NULL if the
+*                        key is not in the map.
+*   prefix##Put        - Puts a key with its data, the data of an existing
+*                        key is freed and replaced.
+*   prefix##PutBulk    - Puts many new keys sorted in ascending order in one
+*                        pass over the map.
+*   prefix##Remove     - Removes a key and frees its data.
+*   prefix##RemoveBulk - Removes many keys sorted in ascending order in one
+*                        pass over the map.
+*   prefix##LowerBound - Returns the first entry whose key is not smaller
+*                        than a key.
+*   prefix##UpperBound - Returns the entry after the last entry whose key is
+*                        not greater than a key.
+*   prefix##GetStats   - Copies the operation counters of the map.
+*   prefix##ResetStats - Sets all the operation counters of the map to zero.
+*
+* Lookups are binary searches, so they cost O(log size). Put and Remove move
+* the entries after the key, so entry pointers (and the pointers returned by
+* prefix##Get) are valid only until the map is changed.
+*
+* With MAP_STATS defined the maps count compares (binary search probes) and
+* allocations in the MapStats counters like the generic Map does.
+*
+* TYPED_MAP_FOREACH and TYPED_MAP_FOREACH_RANGE iterate over the entries in
+* ascending key order. The map must not be changed inside them.
+*/
+
+#ifdef MAP_STATS
+#define TYPED_MAP_STATS_ADD(map, counter, amount) \
+    ((map)->stats.counter += (amount))
+#else
+#define TYPED_MAP_STATS_ADD(map, counter, amount) ((void)0)
+#endif
+
+/** Compare function for int keys of a typed map */
+static inline int typedMapCompareInts(int n1, int n2){
+    return (n1 > n2) - (n1 < n2);
+}
+
+#define DEFINE_TYPED_MAP(type, prefix, keyType, dataType, compareKeys, \
+                         freeData) \
+typedef struct type##Entry_t{ \
+    keyType key; \
+    dataType data; \
+}type##Entry; \
+\
+typedef struct type##_t{ \
+    type##Entry *entries; \
+    int size; \
+    int capacity; \
+    Allocator allocator; \
+    MapStats stats; \
+} *type; \
+\
+static inline type prefix##Create(Allocator allocator){ \
+    type map = allocatorAllocate(allocator, ALLOCATOR_MAP_NODES, \
+                                 sizeof(*map)); \
+    if(!map) return NULL; \
+    map->entries = NULL; \
+    map->size = 0; \
+    map->capacity = 0; \
+    map->allocator = allocator; \
+    memset(&map->stats, 0, sizeof(map->stats)); \
+    return map; \
+} \
+\
+static inline void prefix##Destroy(type map){ \
+    if(!map) return; \
+    for(int i=0; i<map->size; i++){ \
+        freeData(map->entries[i].data); \
+    } \
+    allocatorFree(map->allocator, map->entries); \
+    allocatorFree(map->allocator, map); \
+} \
+\
+static inline int prefix##GetSize(type map){ \
+    return map ? map->size : -1; \
+} \
+\
+static inline int prefix##Search(type map, keyType key){ \
+    int low = 0, high = map->size; \
+    while(low < high){ \
+        int middle = low+(high-low)/2; \
+        TYPED_MAP_STATS_ADD(map, compares, 1); \
+        if(compareKeys(map->entries[middle].key, key) < 0){ \
+            low = middle+1; \
+        } \
+        else{ \
+            high = middle; \
+        } \
+    } \
+    return low; \
+} \
+\
+static inline bool prefix##FoundAt(type map, int index, keyType key){ \
+    return index < map->size && \
+           compareKeys(map->entries[index].key, key) == 0; \
+} \
+\
+static inline bool prefix##Contains(type map, keyType key){ \
+    if(!map) return false; \
+    return prefix##FoundAt(map, prefix##Search(map, key), key); \
+} \
+\
+static inline dataType* prefix##Get(type map, keyType key){ \
+    if(!map) return NULL; \
+    int index = prefix##Search(map, key); \
+    return prefix##FoundAt(map, index, key) ? &map->entries[index].data \
+                                            : NULL; \
+} \
+\
+static inline bool prefix##Reserve(type map, int size){ \
+    if(size <= map->capacity) return true; \
+    int capacity = map->capacity > 0 ? map->capacity*2 : 4; \
+    if(capacity < size){ \
+        capacity = size; \
+    } \
+    type##Entry *entries = allocatorAllocate(map->allocator, \
+                                             ALLOCATOR_MAP_NODES, \
+                                             sizeof(type##Entry)*capacity); \
+    if(!entries) return false; \
+    TYPED_MAP_STATS_ADD(map, allocations, 1); \
+    if(map->size > 0){ \
+        memcpy(entries, map->entries, sizeof(type##Entry)*map->size); \
+    } \
+    allocatorFree(map->allocator, map->entries); \
+    map->entries = entries; \
+    map->capacity = capacity; \
+    return true; \
+} \
+\
+static inline MapResult prefix##Put(type map, keyType key, dataType data){ \
+    if(!map) return MAP_NULL_ARGUMENT; \
+    int index = prefix##Search(map, key); \
+    if(prefix##FoundAt(map, index, key)){ \
+        freeData(map->entries[index].data); \
+        map->entries[index].data = data; \
+        return MAP_SUCCESS; \
+    } \
+    if(!prefix##Reserve(map, map->size+1)) return MAP_OUT_OF_MEMORY; \
+    memmove(map->entries+index+1, map->entries+index, \
+            sizeof(type##Entry)*(map->size-index)); \
+    map->entries[index].key = key; \
+    map->entries[index].data = data; \
+    map->size++; \
+    return MAP_SUCCESS; \
+} \
+\
+static inline MapResult prefix##PutBulk(type map, const keyType *keys, \
+                                        const dataType *data, \
+                                        int numOfEntries){ \
+    if(!map||!keys||!data) return MAP_NULL_ARGUMENT; \
+    for(int i=0; i<numOfEntries; i++){ \
+        if((i>0 && compareKeys(keys[i-1], keys[i]) >= 0) || \
+           prefix##Contains(map, keys[i])){ \
+            return MAP_ITEM_ALREADY_EXISTS; \
+        } \
+    } \
+    if(!prefix##Reserve(map, map->size+numOfEntries)){ \
+        return MAP_OUT_OF_MEMORY; \
+    } \
+    int old = map->size-1, added = numOfEntries-1; \
+    for(int i = map->size+numOfEntries-1; added>=0; i--){ \
+        if(old>=0 && compareKeys(map->entries[old].key, keys[added]) > 0){ \
+            map->entries[i] = map->entries[old--]; \
+        } \
+        else{ \
+            map->entries[i].key = keys[added]; \
+            map->entries[i].data = data[added--]; \
+        } \
+    } \
+    map->size += numOfEntries; \
+    return MAP_SUCCESS; \
+} \
+\
+static inline MapResult prefix##Remove(type map, keyType key){ \
+    if(!map) return MAP_NULL_ARGUMENT; \
+    int index = prefix##Search(map, key); \
+    if(!prefix##FoundAt(map, index, key)) return MAP_ITEM_DOES_NOT_EXIST; \
+    freeData(map->entries[index].data); \
+    memmove(map->entries+index, map->entries+index+1, \
+            sizeof(type##Entry)*(map->size-index-1)); \
+    map->size--; \
+    return MAP_SUCCESS; \
+} \
+\
+static inline MapResult prefix##RemoveBulk(type map, const keyType *keys, \
+                                           int numOfKeys){ \
+    if(!map||!keys) return MAP_NULL_ARGUMENT; \
+    int kept = 0, next = 0; \
+    for(int i=0; i<map->size; i++){ \
+        while(next<numOfKeys && \
+              compareKeys(keys[next], map->entries[i].key) < 0){ \
+            next++; \
+        } \
+        if(next<numOfKeys && \
+           compareKeys(keys[next], map->entries[i].key) == 0){ \
+            freeData(map->entries[i].data); \
+        } \
+        else{ \
+            map->entries[kept++] = map->entries[i]; \
+        } \
+    } \
+    map->size = kept; \
+    return MAP_SUCCESS; \
+} \
+\
+static inline type##Entry* prefix##LowerBound(type map, keyType key){ \
+    return map->entries+prefix##Search(map, key); \
+} \
+\
+static inline type##Entry* prefix##UpperBound(type map, keyType key){ \
+    int index = prefix##Search(map, key); \
+    return map->entries+index+(prefix##FoundAt(map, index, key) ? 1 : 0); \
+} \
+\
+static inline void prefix##GetStats(type map, MapStats *stats){ \
+    if(!map){ \
+        memset(stats, 0, sizeof(*stats)); \
+        return; \
+    } \
+    *stats = map->stats; \
+} \
+\
+static inline void prefix##ResetStats(type map){ \
+    if(!map) return; \
+    memset(&map->stats, 0, sizeof(map->stats)); \
+}
+
+/*!
+* Macro for iterating over the entries of a typed map in ascending key
+* order, entry is a type##Entry* with the fields key and data.
+*/
+#define TYPED_MAP_FOREACH(type, entry, map) \
+    for(type##Entry *entry = (map)->entries; \
+        entry < (map)->entries+(map)->size; \
+        entry++)
+
+/*!
+* Macro for iterating over the entries of a typed map whose keys are between
+* fromKey and toKey (both included), in ascending key order.
+*/
+#define TYPED_MAP_FOREACH_RANGE(type, prefix, entry, map, fromKey, toKey) \
+    for(type##Entry *entry = prefix##LowerBound(map, fromKey), \
+        *entry##End = prefix##UpperBound(map, toKey); \
+        entry < entry##End; \
+        entry++)
+
+#endif /* TYPEDMAP_H_ */
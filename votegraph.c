@@ -0,0 +1,273 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "votegraph.h"
+#include "threadpool.h"
+#include "score.h"
+
+#define VOTE_GRAPH_TOP_VOTES SCORE_TOP_VOTES
+#define VOTE_GRAPH_PARALLEL_THRESHOLD 4096
+#define VOTE_GRAPH_MAX_THREADS 64
+#define VOTE_GRAPH_MAX_ROUNDS 100
+#define VOTE_GRAPH_NO_STATE (-1)
+#define VOTE_GRAPH_ALLOCATE(allocator, size) \
+    allocatorAllocate(allocator, ALLOCATOR_RESULTS, size)
+
+/** The work of a bloc search, shared by its threads. top holds the states
+ *  every state gave the most votes to (VOTE_GRAPH_TOP_VOTES per state,
+ *  VOTE_GRAPH_NO_STATE after the last one), neighbors and weights the
+ *  numOfNeighbors[i] states joined to state i and their points, from
+ *  i*VOTE_GRAPH_TOP_VOTES. labels are the groups of the states in the
+ *  previous round and nextLabels in the current one */
+typedef struct VoteGraphBlocs_t{
+    const VoteGraph *graph;
+    int *top;
+    int *neighbors;
+    int *weights;
+    int *numOfNeighbors;
+    int *labels;
+    int *nextLabels;
+}VoteGraphBlocs;
+
+/** The states first to last (not included) of one thread, changed tells if
+ *  one of them moved to another group in the round */
+typedef struct VoteGraphTask_t{
+    VoteGraphBlocs *blocs;
+    int first;
+    int last;
+    bool changed;
+}VoteGraphTask;
+
+/** fill the top votes of the states of a VoteGraphTask */
+void voteGraphTopTask(void *argument);
+
+/** fill the neighbors of the states of a VoteGraphTask, the top votes of
+ *  every state must be filled */
+void voteGraphJoinTask(void *argument);
+
+/** run one propagation round on the states of a VoteGraphTask */
+void voteGraphPropagateTask(void *argument);
+
+/** run function on every task, on pool or on the calling thread if pool is
+ *  NULL, and return true if a task changed */
+bool voteGraphRunTasks(ThreadPool pool, ThreadPoolTask function,
+                       VoteGraphTask *tasks, int numOfTasks);
+
+/** number the groups of labels with two states or more into blocs */
+int voteGraphNumberBlocs(const int *labels, int *sizes, int numOfStates,
+                         int *blocs);
+
+/** deallocate the arrays of a bloc search to allocator */
+void voteGraphBlocsClear(VoteGraphBlocs *blocs, Allocator allocator);
+
+void voteGraphTopTask(void *argument){
+    VoteGraphTask *task = argument;
+    const VoteGraph *graph = task->blocs->graph;
+    for(int giver=task->first; giver<task->last; giver++){
+        int *topStates = task->blocs->top+giver*VOTE_GRAPH_TOP_VOTES;
+        int topVotes[VOTE_GRAPH_TOP_VOTES];
+        int numOfTop = 0;
+        for(int j=graph->voteStarts[giver]; j<graph->voteStarts[giver+1];
+            j++){
+            if(graph->counts[j]>0){
+                scoreTopVotesInsert(topStates, topVotes, &numOfTop,
+                                    graph->takers[j], graph->counts[j]);
+            }
+        }
+        for(int k=numOfTop; k<VOTE_GRAPH_TOP_VOTES; k++){
+            topStates[k] = VOTE_GRAPH_NO_STATE;
+        }
+    }
+}
+
+void voteGraphJoinTask(void *argument){
+    VoteGraphTask *task = argument;
+    VoteGraphBlocs *blocs = task->blocs;
+    for(int state=task->first; state<task->last; state++){
+        const int *topStates = blocs->top+state*VOTE_GRAPH_TOP_VOTES;
+        int *neighbors = blocs->neighbors+state*VOTE_GRAPH_TOP_VOTES;
+        int *weights = blocs->weights+state*VOTE_GRAPH_TOP_VOTES;
+        int numOfNeighbors = 0;
+        for(int k=0; k<VOTE_GRAPH_TOP_VOTES; k++){
+            int other = topStates[k];
+            if(other==VOTE_GRAPH_NO_STATE) break;
+            const int *otherTop = blocs->top+other*VOTE_GRAPH_TOP_VOTES;
+            for(int m=0; m<VOTE_GRAPH_TOP_VOTES; m++){
+                if(otherTop[m]==state){
+                    neighbors[numOfNeighbors] = other;
+                    weights[numOfNeighbors++] = scoreTopVotesPoints(k)+
+                                                scoreTopVotesPoints(m);
+                    break;
+                }
+            }
+        }
+        blocs->numOfNeighbors[state] = numOfNeighbors;
+    }
+}
+
+void voteGraphPropagateTask(void *argument){
+    VoteGraphTask *task = argument;
+    VoteGraphBlocs *blocs = task->blocs;
+    task->changed = false;
+    for(int state=task->first; state<task->last; state++){
+        const int *neighbors = blocs->neighbors+state*VOTE_GRAPH_TOP_VOTES;
+        const int *weights = blocs->weights+state*VOTE_GRAPH_TOP_VOTES;
+        int numOfNeighbors = blocs->numOfNeighbors[state];
+        /* the group of the state counts as much as its strongest neighbor,
+         * so a state does not leave its group for a single neighbor */
+        int groups[VOTE_GRAPH_TOP_VOTES+1] = {blocs->labels[state]};
+        int scores[VOTE_GRAPH_TOP_VOTES+1] = {0};
+        int numOfGroups = 1;
+        for(int k=0; k<numOfNeighbors; k++){
+            if(weights[k]>scores[0]) scores[0] = weights[k];
+        }
+        for(int k=0; k<numOfNeighbors; k++){
+            int group = blocs->labels[neighbors[k]];
+            int g = 0;
+            while(g<numOfGroups && groups[g]!=group){
+                g++;
+            }
+            if(g==numOfGroups){
+                groups[numOfGroups] = group;
+                scores[numOfGroups++] = 0;
+            }
+            scores[g] += weights[k];
+        }
+        int best = 0;
+        for(int g=1; g<numOfGroups; g++){
+            if(scores[g]>scores[best] ||
+               (scores[g]==scores[best] && groups[g]<groups[best])){
+                best = g;
+            }
+        }
+        blocs->nextLabels[state] = groups[best];
+        task->changed = task->changed || best!=0;
+    }
+}
+
+bool voteGraphRunTasks(ThreadPool pool, ThreadPoolTask function,
+                       VoteGraphTask *tasks, int numOfTasks){
+    for(int i=0; i<numOfTasks; i++){
+        if(!pool||threadPoolSubmit(pool, function,
+                                   tasks+i)!=THREAD_POOL_SUCCESS){
+            function(tasks+i);
+        }
+    }
+    threadPoolWait(pool);
+    bool changed = false;
+    for(int i=0; i<numOfTasks; i++){
+        changed = changed || tasks[i].changed;
+    }
+    return changed;
+}
+
+int voteGraphNumberBlocs(const int *labels, int *sizes, int numOfStates,
+                         int *blocs){
+    for(int i=0; i<numOfStates; i++){
+        sizes[i] = 0;
+    }
+    for(int i=0; i<numOfStates; i++){
+        sizes[labels[i]]++;
+    }
+    /* sizes[label] becomes the bloc of the label (or -1) once it is met */
+    int numOfBlocs = 0;
+    for(int i=0; i<numOfStates; i++){
+        int label = labels[i];
+        if(sizes[label]>1){
+            sizes[label] = -(numOfBlocs++)-2;
+        }
+        blocs[i] = sizes[label]<0 ? -sizes[label]-2 : VOTE_GRAPH_NO_STATE;
+    }
+    return numOfBlocs;
+}
+
+void voteGraphBlocsClear(VoteGraphBlocs *blocs, Allocator allocator){
+    allocatorFree(allocator, blocs->top);
+    allocatorFree(allocator, blocs->neighbors);
+    allocatorFree(allocator, blocs->weights);
+    allocatorFree(allocator, blocs->numOfNeighbors);
+    allocatorFree(allocator, blocs->labels);
+    allocatorFree(allocator, blocs->nextLabels);
+}
+
+VoteGraphResult voteGraphFindBlocs(const VoteGraph *graph, int *blocs,
+                                   int *numOfBlocs, Allocator allocator){
+    int numOfThreads = 1;
+    if(graph && graph->numOfStates>=VOTE_GRAPH_PARALLEL_THRESHOLD){
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        numOfThreads = processors>1 ? (int)processors : 1;
+    }
+    return voteGraphFindBlocsParallel(graph, blocs, numOfBlocs,
+                                      numOfThreads, allocator);
+}
+
+VoteGraphResult voteGraphFindBlocsParallel(const VoteGraph *graph,
+                                           int *blocs, int *numOfBlocs,
+                                           int numOfThreads,
+                                           Allocator allocator){
+    if(!graph||!blocs||!numOfBlocs) return VOTE_GRAPH_NULL_ARGUMENT;
+    int numOfStates = graph->numOfStates;
+    *numOfBlocs = 0;
+    if(numOfStates<=0) return VOTE_GRAPH_SUCCESS;
+    if(numOfThreads>VOTE_GRAPH_MAX_THREADS){
+        numOfThreads = VOTE_GRAPH_MAX_THREADS;
+    }
+    if(numOfThreads>numOfStates) numOfThreads = numOfStates;
+    if(numOfThreads<1) numOfThreads = 1;
+    size_t slots = sizeof(int)*numOfStates*VOTE_GRAPH_TOP_VOTES;
+    size_t states = sizeof(int)*numOfStates;
+    VoteGraphBlocs work = {graph, VOTE_GRAPH_ALLOCATE(allocator, slots),
+                           VOTE_GRAPH_ALLOCATE(allocator, slots),
+                           VOTE_GRAPH_ALLOCATE(allocator, slots),
+                           VOTE_GRAPH_ALLOCATE(allocator, states),
+                           VOTE_GRAPH_ALLOCATE(allocator, states),
+                           VOTE_GRAPH_ALLOCATE(allocator, states)};
+    ThreadPool pool = numOfThreads>1 ? threadPoolCreate(numOfThreads) : NULL;
+    if(!work.top||!work.neighbors||!work.weights||!work.numOfNeighbors||
+       !work.labels||!work.nextLabels){
+        threadPoolDestroy(pool);
+        voteGraphBlocsClear(&work, allocator);
+        return VOTE_GRAPH_OUT_OF_MEMORY;
+    }
+    VoteGraphTask tasks[VOTE_GRAPH_MAX_THREADS];
+    for(int i=0; i<numOfThreads; i++){
+        VoteGraphTask task = {&work,
+                              (int)((long)numOfStates*i/numOfThreads),
+                              (int)((long)numOfStates*(i+1)/numOfThreads),
+                              false};
+        tasks[i] = task;
+    }
+    for(int i=0; i<numOfStates; i++){
+        work.labels[i] = i;
+    }
+    voteGraphRunTasks(pool, voteGraphTopTask, tasks, numOfThreads);
+    voteGraphRunTasks(pool, voteGraphJoinTask, tasks, numOfThreads);
+    for(int round=0; round<VOTE_GRAPH_MAX_ROUNDS; round++){
+        bool changed = voteGraphRunTasks(pool, voteGraphPropagateTask,
+                                         tasks, numOfThreads);
+        int *labels = work.labels;
+        work.labels = work.nextLabels;
+        work.nextLabels = labels;
+        if(!changed) break;
+    }
+    threadPoolDestroy(pool);
+    *numOfBlocs = voteGraphNumberBlocs(work.labels, work.nextLabels,
+                                       numOfStates, blocs);
+    voteGraphBlocsClear(&work, allocator);
+    return VOTE_GRAPH_SUCCESS;
+}
+
+void voteGraphClear(VoteGraph *graph){
+    if(!graph) return;
+    free(graph->ids);
+    free(graph->voteStarts);
+    free(graph->takers);
+    free(graph->counts);
+    graph->ids = NULL;
+    graph->voteStarts = NULL;
+    graph->takers = NULL;
+    graph->counts = NULL;
+    graph->numOfStates = 0;
+    graph->numOfVotes = 0;
+}
@@ -0,0 +1,97 @@
+#ifndef MTM_HW1_EUROVISION_VOTEGRAPH_H
+#define MTM_HW1_EUROVISION_VOTEGRAPH_H
+
+#include "allocator.h"
+
+/**
+ * Vote Graph
+ *
+ * The citizen votes of a contest as a directed graph in compressed sparse
+ * row (CSR) form. The vertices are the states, by ascending id, and every
+ * giver and taker pair with votes is an edge weighted by its votes: state i
+ * gave counts[j] votes to the state of index takers[j] for every j from
+ * voteStarts[i] up to voteStarts[i+1] (not included).
+ *
+ * Voting blocs are groups of states that exchange points: two states are
+ * joined when each of them is in the top ten votes of the other, weighted
+ * by the points they give each other (12, 10, 8, 7... like the audience
+ * score). The blocs are found by label propagation on this graph: every
+ * state starts in a group of its own, then in every round each state moves
+ * to the group it is joined to the most (the lowest group on a tie), until
+ * no state moves. A round reads only the groups of the previous round, so
+ * the states of a round are split between the threads and the blocs do not
+ * depend on their number. A search of n states takes about 33*n ints of
+ * work arrays from the allocator it is given.
+ *
+ * The following functions are available:
+ *
+ * voteGraphFindBlocs         - Split the states of a graph into voting blocs.
+ *                              Large graphs use all the processors.
+ * voteGraphFindBlocsParallel - Like voteGraphFindBlocs on a given number of
+ *                              threads.
+ * voteGraphClear             - Deallocate the arrays of a graph.
+*/
+
+/** A vote graph, the arrays are allocated with malloc */
+typedef struct VoteGraph_t{
+    int numOfStates;
+    int numOfVotes;
+    int *ids;
+    int *voteStarts;
+    int *takers;
+    int *counts;
+}VoteGraph;
+
+/** Type used for returning error codes from vote graph functions */
+typedef enum VoteGraphResult_t{
+    VOTE_GRAPH_NULL_ARGUMENT,
+    VOTE_GRAPH_OUT_OF_MEMORY,
+    VOTE_GRAPH_SUCCESS
+}VoteGraphResult;
+
+/**
+* voteGraphFindBlocs: Split the states of a graph into voting blocs, on all
+* the processors when the graph is large
+*
+* @param graph - the graph
+* @param blocs - array of graph->numOfStates to fill with the bloc of every
+*                state, -1 for a state that is in no bloc (a bloc has at
+*                least two states). The blocs are numbered from 0 in the
+*                order of their first state.
+* @param numOfBlocs - set to the number of blocs
+* @param allocator - the allocator of the work arrays, NULL for malloc
+* @return
+* 	VOTE_GRAPH_NULL_ARGUMENT - if an argument is NULL
+* 	VOTE_GRAPH_OUT_OF_MEMORY - in case of an allocation error (or if the
+* 	                           work arrays pass the limit of allocator)
+* 	VOTE_GRAPH_SUCCESS - if blocs was filled
+*/
+VoteGraphResult voteGraphFindBlocs(const VoteGraph *graph, int *blocs,
+                                   int *numOfBlocs, Allocator allocator);
+
+/**
+* voteGraphFindBlocsParallel: Split the states of a graph into voting blocs
+* like voteGraphFindBlocs, on numOfThreads threads
+*
+* @param graph - the graph
+* @param blocs - array to fill with the bloc of every state
+* @param numOfBlocs - set to the number of blocs
+* @param numOfThreads - the number of threads (at most 64 are used), 1 runs
+*                       on the calling thread
+* @param allocator - the allocator of the work arrays, NULL for malloc
+* @return
+* 	the results of voteGraphFindBlocs
+*/
+VoteGraphResult voteGraphFindBlocsParallel(const VoteGraph *graph,
+                                           int *blocs, int *numOfBlocs,
+                                           int numOfThreads,
+                                           Allocator allocator);
+
+/**
+* voteGraphClear: Deallocate the arrays of a graph
+*
+* @param graph - the graph, if NULL nothing will be done
+*/
+void voteGraphClear(VoteGraph *graph);
+
+#endif
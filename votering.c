@@ -0,0 +1,204 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "votering.h"
+
+#define VOTE_RING_MAGIC 0x45564f5445524e47ULL
+#define VOTE_RING_MAX_CAPACITY (1<<28)
+#define CACHE_LINE 64
+
+/** A record of the ring, sequence tells who owns the slot: it is the
+ *  position a producer may claim it for, or the position plus 1 once the
+ *  record is published for the consumer */
+typedef struct VoteRingSlot_t{
+    uint64_t sequence;
+    EurovisionVote vote;
+}VoteRingSlot;
+
+/** The shared memory of a ring, head (the next position for the producers)
+ *  and tail (the next position for the consumer) are on their own cache
+ *  lines so producers and the consumer do not slow each other down */
+typedef struct VoteRingShared_t{
+    uint64_t magic;
+    uint64_t capacity;
+    char headPadding[CACHE_LINE-2*sizeof(uint64_t)];
+    uint64_t head;
+    char tailPadding[CACHE_LINE-sizeof(uint64_t)];
+    uint64_t tail;
+    char slotsPadding[CACHE_LINE-sizeof(uint64_t)];
+    VoteRingSlot slots[];
+}VoteRingShared;
+
+struct VoteRing_t{
+    VoteRingShared* shared;
+    size_t size;
+    uint64_t mask;
+    char* name;
+};
+
+/** return the size of the shared memory of a ring of capacity records */
+size_t voteRingSize(uint64_t capacity);
+
+/** map the shared memory object open as fd of size bytes to a new ring
+ *  handle, name is copied if the ring is the creator's and NULL otherwise.
+ *  fd is closed */
+VoteRing voteRingMap(int fd, size_t size, const char *name);
+
+size_t voteRingSize(uint64_t capacity){
+    return sizeof(VoteRingShared)+sizeof(VoteRingSlot)*capacity;
+}
+
+VoteRing voteRingMap(int fd, size_t size, const char *name){
+    VoteRing ring = malloc(sizeof(*ring));
+    void *shared = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    char *nameCopy = name ? malloc(strlen(name)+1) : NULL;
+    if(!ring||shared==MAP_FAILED||(name && !nameCopy)){
+        if(shared!=MAP_FAILED) munmap(shared, size);
+        free(nameCopy);
+        free(ring);
+        return NULL;
+    }
+    if(nameCopy){
+        strcpy(nameCopy, name);
+    }
+    ring->shared = shared;
+    ring->size = size;
+    ring->mask = 0;
+    ring->name = nameCopy;
+    return ring;
+}
+
+VoteRing voteRingCreate(const char *name, int capacity){
+    if(!name||capacity<=0||capacity>VOTE_RING_MAX_CAPACITY) return NULL;
+    uint64_t roundedCapacity = 1;
+    while(roundedCapacity < (uint64_t)capacity){
+        roundedCapacity *= 2;
+    }
+    size_t size = voteRingSize(roundedCapacity);
+    int fd = shm_open(name, O_RDWR|O_CREAT|O_EXCL, S_IRUSR|S_IWUSR);
+    if(fd<0) return NULL;
+    if(ftruncate(fd, (off_t)size)!=0){
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+    VoteRing ring = voteRingMap(fd, size, name);
+    if(!ring){
+        shm_unlink(name);
+        return NULL;
+    }
+    VoteRingShared *shared = ring->shared;
+    shared->capacity = roundedCapacity;
+    shared->head = 0;
+    shared->tail = 0;
+    for(uint64_t i=0; i<roundedCapacity; i++){
+        shared->slots[i].sequence = i;
+    }
+    ring->mask = roundedCapacity-1;
+    __atomic_store_n(&shared->magic, VOTE_RING_MAGIC, __ATOMIC_RELEASE);
+    return ring;
+}
+
+VoteRing voteRingOpen(const char *name){
+    if(!name) return NULL;
+    int fd = shm_open(name, O_RDWR, 0);
+    if(fd<0) return NULL;
+    struct stat status;
+    if(fstat(fd, &status)!=0 ||
+       (size_t)status.st_size < sizeof(VoteRingShared)){
+        close(fd);
+        return NULL;
+    }
+    VoteRing ring = voteRingMap(fd, (size_t)status.st_size, NULL);
+    if(!ring) return NULL;
+    VoteRingShared *shared = ring->shared;
+    if(__atomic_load_n(&shared->magic, __ATOMIC_ACQUIRE)!=VOTE_RING_MAGIC ||
+       voteRingSize(shared->capacity)!=ring->size){
+        voteRingClose(ring);
+        return NULL;
+    }
+    ring->mask = shared->capacity-1;
+    return ring;
+}
+
+void voteRingClose(VoteRing ring){
+    if(!ring) return;
+    munmap(ring->shared, ring->size);
+    if(ring->name){
+        shm_unlink(ring->name);
+        free(ring->name);
+    }
+    free(ring);
+}
+
+bool voteRingPush(VoteRing ring, const EurovisionVote *vote){
+    if(!ring||!vote) return false;
+    VoteRingShared *shared = ring->shared;
+    uint64_t position = __atomic_load_n(&shared->head, __ATOMIC_RELAXED);
+    while(true){
+        VoteRingSlot *slot = &shared->slots[position & ring->mask];
+        uint64_t sequence = __atomic_load_n(&slot->sequence,
+                                            __ATOMIC_ACQUIRE);
+        int64_t difference = (int64_t)(sequence-position);
+        if(difference==0){
+            if(__atomic_compare_exchange_n(&shared->head, &position,
+                                           position+1, true,
+                                           __ATOMIC_RELAXED,
+                                           __ATOMIC_RELAXED)){
+                slot->vote = *vote;
+                __atomic_store_n(&slot->sequence, position+1,
+                                 __ATOMIC_RELEASE);
+                return true;
+            }
+        }
+        else if(difference<0){
+            return false;
+        }
+        else{
+            position = __atomic_load_n(&shared->head, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+int voteRingPop(VoteRing ring, EurovisionVote *votes, int maxVotes){
+    if(!ring||!votes) return 0;
+    VoteRingShared *shared = ring->shared;
+    uint64_t position = shared->tail;
+    int numOfVotes = 0;
+    while(numOfVotes<maxVotes){
+        VoteRingSlot *slot = &shared->slots[position & ring->mask];
+        if(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE)!=position+1){
+            break;
+        }
+        votes[numOfVotes++] = slot->vote;
+        __atomic_store_n(&slot->sequence, position+ring->mask+1,
+                         __ATOMIC_RELEASE);
+        position++;
+    }
+    __atomic_store_n(&shared->tail, position, __ATOMIC_RELAXED);
+    return numOfVotes;
+}
+
+EurovisionResult voteRingDrain(VoteRing ring, Eurovision eurovision,
+                               int maxVotes, int *numOfDrained){
+    if(!ring||!eurovision||!numOfDrained) return EUROVISION_NULL_ARGUMENT;
+    EurovisionVote batch[VOTE_RING_BATCH];
+    *numOfDrained = 0;
+    while(*numOfDrained<maxVotes){
+        int wanted = maxVotes-*numOfDrained;
+        int numOfVotes = voteRingPop(ring, batch, wanted<VOTE_RING_BATCH ?
+                                                  wanted : VOTE_RING_BATCH);
+        if(numOfVotes==0) break;
+        *numOfDrained += numOfVotes;
+        EurovisionResult result = eurovisionAddVotes(eurovision, batch,
+                                                     numOfVotes, NULL);
+        if(result!=EUROVISION_SUCCESS) return result;
+    }
+    return EUROVISION_SUCCESS;
+}
@@ -0,0 +1,119 @@
+#ifndef MTM_HW1_EUROVISION_VOTERING_H
+#define MTM_HW1_EUROVISION_VOTERING_H
+
+#include <stdbool.h>
+#include "eurovision.h"
+
+/**
+ * Shared Memory Vote Ring
+ *
+ * A bounded ring of EurovisionVote records in POSIX shared memory, for vote
+ * producers that run as separate processes on the same host as the
+ * process that owns the Eurovision. Any number of producers push records
+ * and one consumer pops them, without locks and without system calls: a
+ * producer claims a slot with an atomic compare and swap on the head and
+ * publishes it through the sequence number of the slot, the consumer reads
+ * the slots in order and hands them back the same way. The records are
+ * written once, by the producer, straight into the shared memory.
+ *
+ * A producer that dies between claiming a slot and publishing it stops the
+ * consumer at that slot, so the ring must be recreated after a producer
+ * crash.
+ *
+ * The following functions are available:
+ *
+ * voteRingCreate  - Create the shared memory of a new ring, for the
+ *                   consumer.
+ * voteRingOpen    - Attach to an existing ring, for the producers.
+ * voteRingClose   - Detach from a ring, the creator also removes it.
+ * voteRingPush    - Add a vote record to a ring.
+ * voteRingPop     - Take vote records out of a ring.
+ * voteRingDrain   - Take vote records out of a ring into a Eurovision in
+ *                   batches.
+*/
+
+/** The number of records voteRingDrain adds to the Eurovision at once */
+#define VOTE_RING_BATCH 256
+
+/** Type for defining a Vote Ring */
+typedef struct VoteRing_t *VoteRing;
+
+/**
+* voteRingCreate: Creates the shared memory object name holding an empty
+* ring, the process that creates the ring is its consumer
+*
+* @param name - the name of the shared memory object, like "/votes"
+* @param capacity - the minimal number of records in the ring, rounded up
+*                   to a power of 2
+* @return
+* 	NULL - if name is NULL, capacity is not positive, an object named name
+* 	       exists or the shared memory could not be created.
+* 	A new VoteRing in case of success.
+*/
+VoteRing voteRingCreate(const char *name, int capacity);
+
+/**
+* voteRingOpen: Attach to the ring in the shared memory object name, for a
+* producer
+*
+* @param name - the name the ring was created with
+* @return
+* 	NULL - if name is NULL or there is no ring named name.
+* 	A VoteRing of the shared ring in case of success.
+*/
+VoteRing voteRingOpen(const char *name);
+
+/**
+* voteRingClose: Detach from a ring, the ring of the creator is also
+* removed from the system (the producers that are still attached keep it
+* until they close it)
+*
+* @param ring - the ring to close, if NULL nothing will be done
+*/
+void voteRingClose(VoteRing ring);
+
+/**
+* voteRingPush: Add a vote record to the ring, safe to call from many
+* producers at once
+*
+* @param ring - the ring
+* @param vote - the record to add
+* @return
+* 	false - if ring or vote is NULL or the ring is full, the producer may
+* 	        try again later
+* 	true - if the record was added
+*/
+bool voteRingPush(VoteRing ring, const EurovisionVote *vote);
+
+/**
+* voteRingPop: Take up to maxVotes records out of the ring in the order
+* they were published, must only be called by the one consumer
+*
+* @param ring - the ring
+* @param votes - the array to copy the records to
+* @param maxVotes - the size of votes
+* @return
+* 	the number of records taken, 0 if the ring is empty or an argument is
+* 	NULL
+*/
+int voteRingPop(VoteRing ring, EurovisionVote *votes, int maxVotes);
+
+/**
+* voteRingDrain: Take up to maxVotes records out of the ring and add them
+* to eurovision with eurovisionAddVotes, VOTE_RING_BATCH records at a time.
+* Stops when the ring is empty. Must only be called by the one consumer.
+*
+* @param ring - the ring
+* @param eurovision - the eurovision to add the votes to
+* @param maxVotes - the largest number of records to take
+* @param numOfDrained - set to the number of records taken, the skipped
+*                       records included
+* @return
+* 	the result of eurovisionAddVotes, EUROVISION_NULL_ARGUMENT if an
+* 	argument is NULL. On EUROVISION_OUT_OF_MEMORY eurovision is destroyed
+* 	like in the eurovision functions.
+*/
+EurovisionResult voteRingDrain(VoteRing ring, Eurovision eurovision,
+                               int maxVotes, int *numOfDrained);
+
+#endif